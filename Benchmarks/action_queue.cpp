@@ -0,0 +1,140 @@
+//
+//  action_queue.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <kss/thread/action_queue.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::thread::bench;
+
+namespace {
+    // Add depth actions that will not become due during the run, so that the
+    // additions we measure are made to a queue of that size.
+    void preload(ActionQueue& q, size_t depth) {
+        for (size_t i = 0; i < depth; ++i) {
+            q.addAction(hours(1) + milliseconds(i), "preload", []{});
+        }
+    }
+
+    void waitFor(const atomic<uint64_t>& counter, uint64_t value) {
+        while (counter.load() < value) {
+            this_thread::yield();
+        }
+    }
+
+    // threads producers add asap actions until all of them have been run.
+    nanoseconds addAsap(State& state, ActionQueue& q) {
+        atomic<uint64_t> completed { 0 };
+        preload(q, state.params.depth);
+        const auto n = state.params.threads;
+        const auto elapsed = timeThreads(n, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i);
+            for (uint64_t j = 0; j < count; ++j) {
+                q.addAction([&completed] { ++completed; });
+            }
+            if (i == 0) {
+                waitFor(completed, state.iterations);
+            }
+        });
+        q.cancel();
+        return elapsed;
+    }
+
+    // A single producer adds timed actions, with delays spread over an hour, to a
+    // queue that already holds depth of them. Only the additions are timed.
+    nanoseconds addTimed(State& state, ActionQueue::Storage storage) {
+        ActionQueue q(ActionQueue::noLimit, storage);
+        preload(q, state.params.depth);
+        const auto elapsed = timeOf([&] {
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                q.addAction(seconds(1) + milliseconds((i * 7919) % 3600000), []{});
+            }
+        });
+        q.cancel();
+        return elapsed;
+    }
+
+    // Schedule timers spread over 100ms and record how late each one runs.
+    nanoseconds timerLateness(State& state, ActionQueue::Storage storage) {
+        ActionQueue q(ActionQueue::noLimit, storage);
+        preload(q, state.params.depth);
+        mutex lock;
+        vector<double> lateness;
+        lateness.reserve(state.iterations);
+        atomic<uint64_t> completed { 0 };
+
+        const auto elapsed = timeOf([&] {
+            const auto start = steady_clock::now();
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                const auto target = start + microseconds(1000 + ((i * 100000) / state.iterations));
+                q.addActionAt(target, [&, target] {
+                    const auto late = duration<double, micro>(steady_clock::now() - target).count();
+                    lock_guard<mutex> l(lock);
+                    lateness.push_back(late);
+                    ++completed;
+                });
+            }
+            waitFor(completed, state.iterations);
+        });
+        q.cancel();
+
+        state.setMetric("lateness_p50_us", percentile(lateness, 50));
+        state.setMetric("lateness_p99_us", percentile(lateness, 99));
+        state.setMetric("lateness_max_us", percentile(lateness, 100));
+        return elapsed;
+    }
+
+    const auto depths = vector<size_t> { 0, 10000 };
+
+    Benchmark addAsapBench("action_queue/add_asap", sweep(threadCounts(), depths), [](State& state) {
+        ActionQueue q;
+        return addAsap(state, q);
+    });
+
+    Benchmark addAsapBoundedBench("action_queue/add_asap_bounded", sweep(threadCounts(), { 0 }), [](State& state) {
+        // A limit disables the lock-free intake, hence this measures the locked path.
+        ActionQueue q(ActionQueue::noLimit - 1);
+        return addAsap(state, q);
+    });
+
+    Benchmark poolAddAsapBench("action_queue_pool/add_asap", sweepThreads(), [](State& state) {
+        ActionQueuePool q(state.params.threads);
+        Params p = state.params;
+        p.threads = 1;
+        State single(p, state.iterations);
+        return addAsap(single, q);
+    });
+
+    Benchmark orderedAddBench("action_queue/add_timed/ordered", sweep({ 1 }, { 0, 1000, 100000 }), [](State& state) {
+        return addTimed(state, ActionQueue::Storage::ordered);
+    });
+
+    Benchmark wheelAddBench("action_queue/add_timed/timing_wheel", sweep({ 1 }, { 0, 1000, 100000 }), [](State& state) {
+        return addTimed(state, ActionQueue::Storage::timingWheel);
+    });
+
+    Benchmark orderedLatenessBench("action_queue/timer_lateness/ordered", sweep({ 1 }, { 0, 100000 }), [](State& state) {
+        return timerLateness(state, ActionQueue::Storage::ordered);
+    }, 1000);
+
+    Benchmark wheelLatenessBench("action_queue/timer_lateness/timing_wheel", sweep({ 1 }, { 0, 100000 }), [](State& state) {
+        return timerLateness(state, ActionQueue::Storage::timingWheel);
+    }, 1000);
+}
@@ -0,0 +1,69 @@
+//
+//  channel.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <kss/thread/bounded_queue.hpp>
+#include <kss/thread/channel.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::thread::bench;
+
+namespace {
+    // threads producers and threads consumers pass a total of iterations items
+    // through a queue whose capacity is depth.
+    const auto queueSweep = sweep({ 1, 2, 4 }, { 16, 1024 });
+
+    Benchmark channelBench("channel/push_pop", queueSweep, [](State& state) {
+        Channel<uint64_t> ch(state.params.depth);
+        const auto n = state.params.threads;
+        return timeThreads(n * 2, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i % n);
+            uint64_t value = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                if (i < n) {
+                    ch.push(j);
+                }
+                else {
+                    ch.pop(value);
+                }
+            }
+            doNotOptimize(value);
+        });
+    });
+
+    Benchmark boundedQueueBench("bounded_queue/try_push_try_pop", queueSweep, [](State& state) {
+        BoundedQueue<uint64_t> q(state.params.depth);
+        const auto n = state.params.threads;
+        return timeThreads(n * 2, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i % n);
+            uint64_t value = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                if (i < n) {
+                    uint64_t item = j;
+                    while (!q.tryPush(move(item))) {
+                        this_thread::yield();
+                    }
+                }
+                else {
+                    while (!q.tryPop(value)) {
+                        this_thread::yield();
+                    }
+                }
+            }
+            doNotOptimize(value);
+        });
+    });
+}
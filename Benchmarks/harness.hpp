@@ -0,0 +1,162 @@
+//
+//  harness.hpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// A minimal benchmark harness. Each benchmark is registered, by creating a static
+// Benchmark object, with a name, the parameter combinations to sweep, and a function
+// that performs a given number of iterations and returns the time they took. The
+// harness calibrates the number of iterations so that each run lasts long enough to
+// be meaningful, and writes one JSON object per line to stdout for each run.
+//
+
+#ifndef kssthread_benchmark_harness_hpp
+#define kssthread_benchmark_harness_hpp
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace kss { namespace thread { namespace bench {
+
+    /*!
+     The parameters of a single run. Each benchmark decides what threads and depth
+     mean for it (typically the number of concurrent threads, and the number of items
+     already in, or the capacity of, the queue being measured).
+     */
+    struct Params {
+        unsigned    threads = 1;
+        std::size_t depth = 0;
+    };
+
+    /*!
+     The state given to a benchmark function for one run.
+     */
+    class State {
+    public:
+        State(const Params& p, uint64_t iterations) : params(p), iterations(iterations) {}
+
+        const Params    params;
+        const uint64_t  iterations;
+
+        /*!
+         Report an additional named result (e.g. a latency percentile) for this run.
+         */
+        void setMetric(const std::string& name, double value) { metrics[name] = value; }
+
+        const std::map<std::string, double>& allMetrics() const noexcept { return metrics; }
+
+    private:
+        std::map<std::string, double> metrics;
+    };
+
+    /*!
+     A benchmark function performs state.iterations operations and returns the time
+     they took, excluding any setup or teardown it does not wish to measure.
+     */
+    using benchmark_fn = std::function<std::chrono::nanoseconds(State&)>;
+
+    /*!
+     Registering a benchmark. If fixedIterations is non-zero the iterations are not
+     calibrated, which is useful for benchmarks whose run time does not depend on the
+     number of iterations (e.g. timer lateness).
+     */
+    class Benchmark {
+    public:
+        Benchmark(const std::string& name,
+                  const std::vector<Params>& sweep,
+                  benchmark_fn fn,
+                  uint64_t fixedIterations = 0);
+    };
+
+    /*!
+     Returns the thread counts that benchmarks should sweep: powers of two up to
+     twice the hardware concurrency, and at least up to 8.
+     */
+    std::vector<unsigned> threadCounts();
+
+    /*!
+     Returns the parameters for every thread count, each with the given depth.
+     */
+    std::vector<Params> sweepThreads(std::size_t depth = 0);
+
+    /*!
+     Returns the parameters for every combination of the given thread counts and depths.
+     */
+    std::vector<Params> sweep(const std::vector<unsigned>& threads, const std::vector<std::size_t>& depths);
+
+    /*!
+     Time the execution of fn.
+     */
+    template <class Fn>
+    std::chrono::nanoseconds timeOf(Fn&& fn) {
+        using namespace std::chrono;
+        const auto start = steady_clock::now();
+        fn();
+        return duration_cast<nanoseconds>(steady_clock::now() - start);
+    }
+
+    /*!
+     Run fn(index) in each of n threads, and return the time from when they were all
+     released until the last one completed. The cost of creating the threads is not
+     included.
+     */
+    template <class Fn>
+    std::chrono::nanoseconds timeThreads(unsigned n, Fn&& fn) {
+        std::atomic<bool> go { false };
+        std::atomic<unsigned> ready { 0 };
+        std::vector<std::thread> threads;
+        threads.reserve(n);
+        for (unsigned i = 0; i < n; ++i) {
+            threads.emplace_back([&, i] {
+                ++ready;
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                fn(i);
+            });
+        }
+        while (ready.load() < n) {
+            std::this_thread::yield();
+        }
+        return timeOf([&] {
+            go.store(true, std::memory_order_release);
+            for (auto& t : threads) {
+                t.join();
+            }
+        });
+    }
+
+    /*!
+     Returns the share of total iterations that the thread with the given index
+     should perform, when they are divided among n threads.
+     */
+    inline uint64_t shareOf(uint64_t total, unsigned n, unsigned index) noexcept {
+        return (total / n) + (index < (total % n) ? 1 : 0);
+    }
+
+    /*!
+     Prevent the compiler from optimizing away a value that is computed but not used.
+     */
+    template <class T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /*!
+     Returns the given percentile (0 to 100) of the values, which are sorted in place.
+     */
+    double percentile(std::vector<double>& values, double pct);
+}}}
+
+#endif
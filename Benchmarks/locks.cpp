@@ -0,0 +1,140 @@
+//
+//  locks.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include <kss/thread/read_write_lock.hpp>
+#include <kss/thread/semaphore.hpp>
+#include <kss/thread/seq_lock.hpp>
+#include <kss/thread/spin_lock.hpp>
+#include <kss/thread/versioned.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::thread::bench;
+
+namespace {
+    // For the read-mostly benchmarks, depth is the number of writes per 1000
+    // operations, and each thread performs its share of the iterations.
+    const auto readMostlySweep = sweep(threadCounts(), { 0, 10 });
+
+    template <class ReadLock, class WriteLock>
+    nanoseconds readMostly(State& state, ReadLock& rl, WriteLock& wl) {
+        const auto writesPerThousand = state.params.depth;
+        uint64_t value = 0;
+        const auto n = state.params.threads;
+        const auto elapsed = timeThreads(n, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i);
+            uint64_t sum = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                if ((j % 1000) < writesPerThousand) {
+                    lock_guard<WriteLock> l(wl);
+                    ++value;
+                }
+                else {
+                    lock_guard<ReadLock> l(rl);
+                    sum += value;
+                }
+            }
+            doNotOptimize(sum);
+        });
+        return elapsed;
+    }
+
+    Benchmark mutexBench("rwlock/std_mutex", readMostlySweep, [](State& state) {
+        mutex m;
+        return readMostly(state, m, m);
+    });
+
+    Benchmark rwlockBench("rwlock/ReadWriteLock", readMostlySweep, [](State& state) {
+        ReadWriteLock l;
+        return readMostly(state, l.readLock(), l.writeLock());
+    });
+
+    Benchmark distributedBench("rwlock/DistributedReadWriteLock", readMostlySweep, [](State& state) {
+        DistributedReadWriteLock l;
+        return readMostly(state, l.readLock(), l.writeLock());
+    });
+
+    Benchmark seqLockBench("rwlock/SeqLock", readMostlySweep, [](State& state) {
+        SeqLock<uint64_t> value;
+        const auto writesPerThousand = state.params.depth;
+        const auto n = state.params.threads;
+        return timeThreads(n, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i);
+            uint64_t sum = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                if ((j % 1000) < writesPerThousand) {
+                    value.update([](uint64_t& v) { ++v; });
+                }
+                else {
+                    sum += value.load();
+                }
+            }
+            doNotOptimize(sum);
+        });
+    });
+
+    Benchmark versionedBench("rwlock/Versioned", readMostlySweep, [](State& state) {
+        Versioned<uint64_t> value;
+        const auto writesPerThousand = state.params.depth;
+        const auto n = state.params.threads;
+        return timeThreads(n, [&](unsigned i) {
+            const auto count = shareOf(state.iterations, n, i);
+            uint64_t sum = 0;
+            for (uint64_t j = 0; j < count; ++j) {
+                if ((j % 1000) < writesPerThousand) {
+                    value.update([](uint64_t& v) { ++v; });
+                }
+                else {
+                    sum += *value.snapshot();
+                }
+            }
+            doNotOptimize(sum);
+        });
+    });
+
+    // A very short critical section, as when a lock protects a counter, shared by all
+    // the threads.
+    template <class Lockable>
+    nanoseconds shortCriticalSection(State& state) {
+        Lockable m;
+        uint64_t value = 0;
+        const auto n = state.params.threads;
+        const auto elapsed = timeThreads(n, [&](unsigned i) {
+            for (uint64_t j = 0, count = shareOf(state.iterations, n, i); j < count; ++j) {
+                lock_guard<Lockable> l(m);
+                ++value;
+            }
+        });
+        doNotOptimize(value);
+        return elapsed;
+    }
+
+    Benchmark stdMutexBench("mutex/std_mutex", sweepThreads(), shortCriticalSection<mutex>);
+    Benchmark adaptiveMutexBench("mutex/AdaptiveMutex", sweepThreads(), shortCriticalSection<AdaptiveMutex>);
+    Benchmark ticketLockBench("mutex/TicketLock", sweepThreads(), shortCriticalSection<TicketLock>);
+    Benchmark mcsLockBench("mutex/McsLock", sweepThreads(), shortCriticalSection<McsLock>);
+
+    // Acquire and release a semaphore that allows half of the threads at once.
+    Benchmark countingSemaphoreBench("semaphore/CountingSemaphore", sweepThreads(), [](State& state) {
+        const auto n = state.params.threads;
+        CountingSemaphore sem(max(n / 2, 1U));
+        return timeThreads(n, [&](unsigned i) {
+            for (uint64_t j = 0, count = shareOf(state.iterations, n, i); j < count; ++j) {
+                lock_guard<CountingSemaphore> l(sem);
+            }
+        });
+    });
+}
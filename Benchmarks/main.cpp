@@ -0,0 +1,197 @@
+//
+//  main.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// Usage: benchmark [--quick] [--list] [name-filter ...]
+//
+// Runs every benchmark whose name contains one of the filters (or all of them if
+// none are given). The results are written to stdout as JSON lines, one per run,
+// while progress is written to stderr. --quick shortens the calibration target,
+// which is useful for checking that the benchmarks work but not for measurements.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kss/thread/version.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread::bench;
+
+namespace {
+    struct Registration {
+        string          name;
+        vector<Params>  sweep;
+        benchmark_fn    fn;
+        uint64_t        fixedIterations;
+    };
+
+    // Constructed on first use, since the registrations are made by static objects
+    // in other translation units.
+    vector<Registration>& registrations() {
+        static vector<Registration> regs;
+        return regs;
+    }
+
+    string jsonString(const string& s) {
+        string ret = "\"";
+        for (const char c : s) {
+            if (c == '"' || c == '\\') {
+                ret += '\\';
+            }
+            ret += c;
+        }
+        return ret + "\"";
+    }
+
+    string jsonNumber(double d) {
+        if (!isfinite(d)) {
+            return "null";
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.6g", d);
+        return buf;
+    }
+
+    bool matches(const string& name, const vector<string>& filters) {
+        if (filters.empty()) {
+            return true;
+        }
+        return any_of(filters.begin(), filters.end(), [&](const string& f) {
+            return name.find(f) != string::npos;
+        });
+    }
+
+    // Grow the iterations until a run takes at least the target time, then report
+    // that run.
+    void runOne(const Registration& reg, const Params& params, const nanoseconds& target) {
+        uint64_t iterations = (reg.fixedIterations ? reg.fixedIterations : 1);
+        for (;;) {
+            State state(params, iterations);
+            const auto elapsed = reg.fn(state);
+            if (reg.fixedIterations || elapsed >= target || iterations >= (uint64_t(1) << 40)) {
+                const double ns = double(elapsed.count());
+                cout << "{\"name\":" << jsonString(reg.name)
+                     << ",\"threads\":" << params.threads
+                     << ",\"depth\":" << params.depth
+                     << ",\"iterations\":" << iterations
+                     << ",\"ns\":" << elapsed.count()
+                     << ",\"ns_per_op\":" << jsonNumber(ns / double(iterations))
+                     << ",\"ops_per_sec\":" << jsonNumber(ns > 0 ? double(iterations) * 1e9 / ns : NAN);
+                for (const auto& m : state.allMetrics()) {
+                    cout << "," << jsonString(m.first) << ":" << jsonNumber(m.second);
+                }
+                cout << "}" << endl;
+                return;
+            }
+
+            // Aim a little past the target, but never grow by more than 10 times.
+            const double ratio = (elapsed.count() > 0 ? double(target.count()) / double(elapsed.count()) : 10.0);
+            iterations = max(iterations * 2, uint64_t(double(iterations) * min(ratio * 1.2, 10.0)));
+        }
+    }
+}
+
+
+namespace kss { namespace thread { namespace bench {
+
+    Benchmark::Benchmark(const string& name, const vector<Params>& sweep, benchmark_fn fn, uint64_t fixedIterations) {
+        registrations().push_back(Registration { name, sweep, move(fn), fixedIterations });
+    }
+
+    vector<unsigned> threadCounts() {
+        const unsigned hw = max(std::thread::hardware_concurrency(), 1U);
+        const unsigned limit = max(hw * 2, 8U);
+        vector<unsigned> ret;
+        for (unsigned n = 1; n <= limit; n *= 2) {
+            ret.push_back(n);
+        }
+        return ret;
+    }
+
+    vector<Params> sweepThreads(size_t depth) {
+        return sweep(threadCounts(), { depth });
+    }
+
+    vector<Params> sweep(const vector<unsigned>& threads, const vector<size_t>& depths) {
+        vector<Params> ret;
+        for (const auto d : depths) {
+            for (const auto t : threads) {
+                Params p;
+                p.threads = t;
+                p.depth = d;
+                ret.push_back(p);
+            }
+        }
+        return ret;
+    }
+
+    double percentile(vector<double>& values, double pct) {
+        if (values.empty()) {
+            return NAN;
+        }
+        sort(values.begin(), values.end());
+        const auto idx = size_t(llround((pct / 100.0) * double(values.size() - 1)));
+        return values[min(idx, values.size() - 1)];
+    }
+}}}
+
+
+int main(int argc, char* argv[]) {
+    nanoseconds target = milliseconds(200);
+    bool listOnly = false;
+    vector<string> filters;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            target = milliseconds(10);
+        }
+        else if (strcmp(argv[i], "--list") == 0) {
+            listOnly = true;
+        }
+        else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    auto& regs = registrations();
+    sort(regs.begin(), regs.end(), [](const Registration& a, const Registration& b) { return a.name < b.name; });
+
+    cerr << "KSS Thread benchmarks, version " << kss::thread::version()
+         << ", hardware concurrency " << std::thread::hardware_concurrency() << endl;
+    try {
+        for (const auto& reg : regs) {
+            if (!matches(reg.name, filters)) {
+                continue;
+            }
+            if (listOnly) {
+                cout << reg.name << endl;
+                continue;
+            }
+            for (const auto& params : reg.sweep) {
+                cerr << "  " << reg.name << " threads=" << params.threads << " depth=" << params.depth << endl;
+                runOne(reg, params, target);
+            }
+        }
+    }
+    catch (const exception& e) {
+        cerr << "benchmark failed: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
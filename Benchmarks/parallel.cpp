@@ -0,0 +1,107 @@
+//
+//  parallel.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include <kss/thread/action_thread.hpp>
+#include <kss/thread/parallel.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::thread::bench;
+
+namespace {
+    // Each iteration runs threads (2, 4, or 8) tiny actions, since parallel() takes
+    // its actions as a parameter pack.
+    template <class Runner>
+    nanoseconds runActions(State& state, Runner&& runner) {
+        atomic<uint64_t> counter { 0 };
+        auto a = [&counter] { counter.fetch_add(1, memory_order_relaxed); };
+        const auto elapsed = timeOf([&] {
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                switch (state.params.threads) {
+                    case 2:     runner(a, a); break;
+                    case 4:     runner(a, a, a, a); break;
+                    default:    runner(a, a, a, a, a, a, a, a); break;
+                }
+            }
+        });
+        doNotOptimize(counter.load());
+        return elapsed;
+    }
+
+    const auto actionCounts = sweep({ 2, 4, 8 }, { 0 });
+
+    Benchmark sharedPoolBench("parallel/shared_pool", actionCounts, [](State& state) {
+        return runActions(state, [](auto&&... actions) { parallel(actions...); });
+    });
+
+    Benchmark threadGroupBench("parallel/thread_group", actionCounts, [](State& state) {
+        ParallelThreadGroup tg(state.params.threads - 1);
+        return runActions(state, [&tg](auto&&... actions) { parallel(tg, actions...); });
+    });
+
+    Benchmark cancellableBench("parallel/cancellable", actionCounts, [](State& state) {
+        atomic<uint64_t> counter { 0 };
+        auto a = [&counter](const StopToken&) { counter.fetch_add(1, memory_order_relaxed); };
+        const auto elapsed = timeOf([&] {
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                switch (state.params.threads) {
+                    case 2:     parallelCancellable(a, a); break;
+                    case 4:     parallelCancellable(a, a, a, a); break;
+                    default:    parallelCancellable(a, a, a, a, a, a, a, a); break;
+                }
+            }
+        });
+        doNotOptimize(counter.load());
+        return elapsed;
+    });
+
+    Benchmark stdAsyncBench("parallel/std_async", actionCounts, [](State& state) {
+        // The baseline that parallel() is intended to improve upon.
+        return runActions(state, [](auto&&... actions) {
+            future<void> futures[] = { async(launch::async, actions)... };
+            for (auto& f : futures) {
+                f.get();
+            }
+        });
+    });
+
+    Benchmark asyncRoundTripBench("action_thread/async_round_trip", sweep({ 1 }, { 0 }), [](State& state) {
+        ActionThread<int> th;
+        int total = 0;
+        const auto elapsed = timeOf([&] {
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                total += th.async([] { return 1; }).get();
+            }
+        });
+        doNotOptimize(total);
+        return elapsed;
+    });
+
+    Benchmark runRoundTripBench("action_thread/run_round_trip", sweep({ 1 }, { 0 }), [](State& state) {
+        ActionThread<int> th;
+        int total = 0;
+        const auto elapsed = timeOf([&] {
+            for (uint64_t i = 0; i < state.iterations; ++i) {
+                th.run([] { return 1; });
+                total += th.get();
+            }
+        });
+        doNotOptimize(total);
+        return elapsed;
+    });
+}
@@ -0,0 +1,67 @@
+//
+//  synchronizer.cpp
+//  benchmark
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <kss/thread/synchronizer.hpp>
+
+#include "harness.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::thread::bench;
+
+namespace {
+    // Each iteration is one phase in which all the threads meet at the barrier.
+    const auto threadSweep = sweep({ 2, 4, 8 }, { 0 });
+
+    Benchmark barrierBench("barrier/Barrier", threadSweep, [](State& state) {
+        // Barrier cannot be reused on its own, so we rotate through three of them.
+        // When a thread has passed barrier j, every thread has returned from barrier
+        // j-1, hence thread 0 may reset it before it is needed again for phase j+2.
+        const auto n = state.params.threads;
+        unique_ptr<Barrier> barriers[3] = {
+            unique_ptr<Barrier>(new Barrier(n)),
+            unique_ptr<Barrier>(new Barrier(n)),
+            unique_ptr<Barrier>(new Barrier(n))
+        };
+        return timeThreads(n, [&](unsigned i) {
+            for (uint64_t j = 0; j < state.iterations; ++j) {
+                barriers[j % 3]->wait();
+                if (i == 0) {
+                    barriers[(j + 2) % 3]->reset();
+                }
+            }
+        });
+    });
+
+    Benchmark spinBarrierBench("barrier/SpinBarrier", threadSweep, [](State& state) {
+        SpinBarrier barrier(state.params.threads);
+        return timeThreads(state.params.threads, [&](unsigned) {
+            for (uint64_t j = 0; j < state.iterations; ++j) {
+                barrier.wait();
+            }
+        });
+    });
+
+    Benchmark cyclicBarrierBench("barrier/CyclicBarrier", threadSweep, [](State& state) {
+        uint64_t phases = 0;
+        CyclicBarrier barrier(state.params.threads, [&phases] { ++phases; });
+        const auto elapsed = timeThreads(state.params.threads, [&](unsigned) {
+            for (uint64_t j = 0; j < state.iterations; ++j) {
+                barrier.wait();
+            }
+        });
+        doNotOptimize(phases);
+        return elapsed;
+    });
+}
@@ -48,8 +48,12 @@ ifeq ($(wildcard Dependancies/prereqs.json),)
 	PREREQS_LICENSE_FILE :=
 endif
 
+# The language standard may be overridden, e.g. "make check CXXSTD=c++20", but
+# note that the objects are not rebuilt when it changes. (See check-cxx20.)
+CXXSTD ?= c++14
+
 CFLAGS := $(CFLAGS) -I$(BUILDDIR)/include
-CXXFLAGS := $(CXXFLAGS) -I$(BUILDDIR)/include -std=c++14 -Wno-unknown-pragmas
+CXXFLAGS := $(CXXFLAGS) -I$(BUILDDIR)/include -std=$(CXXSTD) -Wno-unknown-pragmas
 
 KSS_INSTALL_PREFIX ?= /opt/$(PREFIX)
 CFLAGS := $(CFLAGS) -I$(KSS_INSTALL_PREFIX)/include
@@ -62,7 +66,7 @@ LDFLAGS := $(LDFLAGS) -L$(LIBDIR)
 -include $(PROJECTDIR)/config.local
 -include $(PROJECTDIR)/config.defs
 
-.PHONY: build library install check analyze clean cleanall directory-checks hello
+.PHONY: build library install check check-cxx20 bench analyze clean cleanall directory-checks hello
 .PHONY: prep docs help prereqs
 
 LIBNAME := $(PREFIX)$(PACKAGEBASENAME)
@@ -74,11 +78,20 @@ TESTDIR := $(BUILDDIR)/tests
 TESTPATH := $(TESTDIR)/unittest
 
 
+BENCHDIR := $(BUILDDIR)/benchmarks
+BENCHPATH := $(BENCHDIR)/benchmark
+
+
 # Turn off the building of the tests if there is no Tests directory.
 ifeq ($(wildcard Tests/.*),)
 	TESTPATH :=
 endif
 
+# Likewise turn off the benchmarks if there is no Benchmarks directory.
+ifeq ($(wildcard Benchmarks/.*),)
+	BENCHPATH :=
+endif
+
 build: library $(PREREQS_LICENSE_FILE)
 
 library: $(LIBPATH)
@@ -109,6 +122,9 @@ hello:
 ifneq ($(wildcard Tests/.*),)
 	@echo "  TESTPATH=$(TESTPATH)"
 endif
+ifneq ($(wildcard Benchmarks/.*),)
+	@echo "  BENCHPATH=$(BENCHPATH)"
+endif
 
 prereqs:
 	BuildSystem/update_prereqs.py
@@ -190,6 +206,13 @@ ifneq ($(wildcard $(EXEPATH)),)
 endif
 	$(LDPATHEXPR) $(TESTPATH)
 
+# Build and run the unit tests using C++20, which enables the features (e.g. the
+# coroutine support) that require it. A separate build directory is used so that
+# the objects built with different standards are not mixed.
+
+check-cxx20:
+	$(MAKE) check CXXSTD=c++20 BUILDDIR=$(BUILDDIR)-c++20
+
 analyze:
 	$(BUILDSYSTEMDIR)/xcode_analyzer.py
 
@@ -203,6 +226,27 @@ $(TESTDIR)/%.o: Tests/%.cpp $(TESTHDRS)
 	$(CXX) -c $< $(CXXFLAGS) -I. -o $@
 
 
+# Build and run the benchmarks. Use BENCHARGS to pass options to the benchmark
+# program, e.g. "make bench BENCHARGS='--quick action_queue'".
+
+BENCHSRCS := $(wildcard Benchmarks/*.cpp)
+BENCHOBJS := $(patsubst Benchmarks/%.cpp,$(BENCHDIR)/%.o,$(BENCHSRCS))
+BENCHHDRS := $(wildcard Benchmarks/*.h) $(wildcard Benchmarks/*.hpp)
+#BENCHLIBS :=  add this to your Makefile if necessary
+
+bench: library $(BENCHPATH)
+	$(LDPATHEXPR) $(BENCHPATH) $(BENCHARGS)
+
+$(BENCHPATH): $(LIBPATH) $(BENCHDIR) $(BENCHOBJS)
+	$(CXX) $(LDFLAGS) -L$(BUILDDIR) $(BENCHOBJS) -l $(LIBNAME) $(LIBS) $(BENCHLIBS) -o $@
+
+$(BENCHDIR):
+	-mkdir -p $@
+
+$(BENCHDIR)/%.o: Benchmarks/%.cpp $(BENCHHDRS)
+	$(CXX) -c $< $(CXXFLAGS) -I. -o $@
+
+
 # Build the documentation.
 docs:
 	-rm -rf docs
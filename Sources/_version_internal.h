@@ -0,0 +1,5 @@
+/* This file is auto-generated and should not be edited. */
+namespace {
+    constexpr const char* versionText = "0.0.0";
+}
+
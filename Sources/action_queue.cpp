@@ -7,19 +7,29 @@
 //  Licensing follows the MIT License.
 //
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <system_error>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <syslog.h>
 #include <kss/contract/all.h>
 #include <kss/util/all.h>
 
 #include "action_queue.hpp"
+#include "lock.hpp"
+#include "poller.hpp"
+#include "stop_token.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -28,142 +38,1409 @@ namespace contract = kss::contract;
 
 using kss::util::time::now;
 
-using time_point_t = time_point<steady_clock, milliseconds>;
+using time_point_t = steady_clock::time_point;
+
+static_assert(IOActionQueue::readable == _private::Poller::readable
+              && IOActionQueue::writable == _private::Poller::writable
+              && IOActionQueue::hangup == _private::Poller::hangup
+              && IOActionQueue::error == _private::Poller::error,
+              "IOActionQueue events must match the Poller events");
 
 namespace {
-    struct ActionDetails {
-        time_point_t            targetTime;
-        string                  identifier;
-        ActionQueue::action_t   action;
+    struct Node;
+
+    // Actions that share an identifier are linked together so that they may be
+    // cancelled as a group without searching through all the pending actions. The
+    // index entry also serves as the single (interned) copy of the identifier
+    // string that all the nodes refer to.
+    //
+    // When identifiers are serialized, running is set while one of the group's
+    // actions is in progress, and any of its actions that become due in the meantime
+    // are moved, in order, into the deferred list.
+    struct IdentifierGroup {
+        Node*   head = nullptr;
+        size_t  count = 0;
+        bool    running = false;
+        Node*   deferredHead = nullptr;
+        Node*   deferredTail = nullptr;
+    };
+
+    using identifier_index_t = unordered_map<string, IdentifierGroup>;
+    using ordered_map_t = multimap<time_point_t, Node*>;
+
+    // The priority lanes, in the order in which their due actions are taken.
+    constexpr unsigned highLane = 0;
+    constexpr unsigned normalLane = 1;
+    constexpr unsigned lowLane = 2;
+    constexpr unsigned numberOfLanes = 3;
+
+    // A pending action. Nodes are allocated from a slab that is owned by the
+    // ActionQueue, hence a node pointer will remain valid (although it may be reused
+    // for a different action) for the life of the queue. The sequence number is
+    // used to determine if a handle still refers to the action in the node.
+    //
+    // The action may run at any time from its target time up to its deadline,
+    // which is the target time plus its slack. The stores are ordered by the
+    // deadlines, which is when the worker must wake up for the action.
+    struct Node {
+        time_point_t                    targetTime;
+        time_point_t                    deadline;
+        unsigned                        lane = normalLane;
+        ActionQueue::inline_action_t    action;
+        identifier_index_t::value_type* identifier = nullptr;
+        uint64_t                        sequence = 0;       // 0 when not in use
+        Node*                           prevWithIdentifier = nullptr;
+        Node*                           nextWithIdentifier = nullptr;
+        bool                            deferred = false;
+
+        // Used by the storage engines, or by the deferred list.
+        Node*                           prev = nullptr;
+        Node*                           next = nullptr;
+        uint64_t                        tick = 0;
+        unsigned                        level = 0;
+        unsigned                        slotIndex = 0;
+        ordered_map_t::iterator         position;
+    };
+
+
+    // The slab of nodes. These are allocated in chunks, and released nodes are
+    // held in a free list for reuse. Nothing is returned to the system until the
+    // slab is destroyed.
+    class NodeSlab {
+    public:
+        Node* allocate() {
+            if (!freeNodes) {
+                chunks.emplace_back(new Node[nodesPerChunk]);
+                Node* chunk = chunks.back().get();
+                for (size_t i = 0; i < nodesPerChunk; ++i) {
+                    chunk[i].next = freeNodes;
+                    freeNodes = &chunk[i];
+                }
+            }
+            Node* node = freeNodes;
+            freeNodes = node->next;
+            node->next = nullptr;
+            return node;
+        }
+
+        void release(Node* node) noexcept {
+            // Release the action now rather than when the node is reused, in case
+            // it holds resources (or references) of its own.
+            node->action = nullptr;
+            node->identifier = nullptr;
+            node->sequence = 0;
+            node->deferred = false;
+            node->prev = nullptr;
+            node->next = freeNodes;
+            freeNodes = node;
+        }
+
+    private:
+        static constexpr size_t     nodesPerChunk = 256;
+
+        vector<unique_ptr<Node[]>>  chunks;
+        Node*                       freeNodes = nullptr;
+    };
+
+
+    // The storage engine interface. Note that none of these methods are protected
+    // by locks. It is assumed that the caller will be holding the ActionQueue lock
+    // whenever they are called.
+    class ActionStore {
+    public:
+        virtual ~ActionStore() noexcept = default;
+
+        virtual bool empty() const noexcept = 0;
+        virtual size_t size() const noexcept = 0;
+        virtual void add(Node* node) = 0;
+
+        // Returns the earliest time at which an action may become due. This must
+        // not be called if the store is empty.
+        virtual time_point_t nextTargetTime() noexcept = 0;
+
+        // If an action is due at currentTime, remove it from the store and return
+        // it. Otherwise return nullptr. An action whose target time has passed may
+        // be returned before its deadline.
+        virtual Node* removeDue(const time_point_t& currentTime) noexcept = 0;
+
+        // Remove an arbitrary action, returning nullptr if the store is empty.
+        virtual Node* removeAny() noexcept = 0;
+
+        // Remove the given action, which must be in the store.
+        virtual void remove(Node* node) noexcept = 0;
+    };
+
+
+    // The original storage engine, keeping the actions in a multimap ordered by
+    // their deadlines. In the style of the Linux hrtimers, the actions are taken in
+    // deadline order for as long as their target times have passed, which allows
+    // actions with slack to be run along with ones that woke the worker.
+    class OrderedStore : public ActionStore {
+    public:
+        bool empty() const noexcept override { return pendingActions.empty(); }
+        size_t size() const noexcept override { return pendingActions.size(); }
+
+        void add(Node* node) override {
+            node->position = pendingActions.emplace(node->deadline, node);
+        }
+
+        time_point_t nextTargetTime() noexcept override {
+            return pendingActions.begin()->first;
+        }
+
+        Node* removeDue(const time_point_t& currentTime) noexcept override {
+            const auto cit = pendingActions.begin();
+            if (cit != pendingActions.end() && cit->second->targetTime <= currentTime) {
+                Node* node = cit->second;
+                pendingActions.erase(cit);
+                return node;
+            }
+            return nullptr;
+        }
+
+        Node* removeAny() noexcept override {
+            return removeDue(time_point_t::max());
+        }
+
+        void remove(Node* node) noexcept override {
+            pendingActions.erase(node->position);
+        }
+
+    private:
+        ordered_map_t pendingActions;
+    };
+
+
+    // A hierarchical timing wheel (in the style of the classic BSD/Linux kernel
+    // timers). There are four levels of 256 slots each. Level 0 holds the actions
+    // that are due within the next 256 ticks, one slot per tick. Each slot of level
+    // n holds the actions due within a block of 256^n ticks, and is "cascaded" down
+    // into the lower levels when the current tick reaches the start of that block.
+    // Anything more than 2^32 ticks (about 50 days) away is placed in an overflow
+    // slot that is re-examined every 2^32 ticks.
+    //
+    // Each slot is an intrusive list of nodes. Each level also keeps a bitmap of
+    // its non-empty slots, which allows us to find the next non-empty slot, and
+    // hence to skip over idle periods, without walking through every tick.
+    //
+    // The nodes are placed by their deadlines, hence an action with slack is run
+    // at the end of its slack rather than along with earlier actions. The slack
+    // still allows nearby actions to share a tick, and hence a wakeup.
+    class TimingWheelStore : public ActionStore {
+    public:
+        TimingWheelStore() : epoch(now<time_point_t>()) {}
+
+        bool empty() const noexcept override { return (count == 0); }
+        size_t size() const noexcept override { return count; }
+
+        void add(Node* node) override {
+            node->tick = tickOf(node->deadline);
+            insert(node);
+            ++count;
+        }
+
+        time_point_t nextTargetTime() noexcept override {
+            return epoch + (tickDuration * nextEventTick());
+        }
+
+        Node* removeDue(const time_point_t& currentTime) noexcept override {
+            if (count > 0 && currentTime >= epoch) {
+                const auto nowTick = uint64_t((currentTime - epoch) / tickDuration);
+                advanceTo(nowTick);
+                Node* node = levels[0].slots[currentTick & slotMask].head;
+                if (currentTick <= nowTick && node) {
+                    remove(node);
+                    return node;
+                }
+            }
+            return nullptr;
+        }
+
+        Node* removeAny() noexcept override {
+            Node* node = overflow.head;
+            for (unsigned level = 0; !node && level < numberOfLevels; ++level) {
+                const int idx = nextOccupied(levels[level], 0);
+                if (idx >= 0) {
+                    node = levels[level].slots[unsigned(idx)].head;
+                }
+            }
+            if (node) {
+                remove(node);
+            }
+            return node;
+        }
+
+        void remove(Node* node) noexcept override {
+            unlink(node);
+            --count;
+        }
+
+    private:
+        static constexpr unsigned   bitsPerLevel = 8;
+        static constexpr unsigned   numberOfLevels = 4;
+        static constexpr unsigned   slotsPerLevel = 1U << bitsPerLevel;
+        static constexpr uint64_t   slotMask = slotsPerLevel - 1;
+        static constexpr unsigned   overflowLevel = numberOfLevels;
+        static constexpr unsigned   wordsPerBitmap = slotsPerLevel / 64;
+        static constexpr uint64_t   noEvent = numeric_limits<uint64_t>::max();
+
+        static constexpr milliseconds tickDuration { 1 };
+
+        struct Slot {
+            Node*   head = nullptr;
+            Node*   tail = nullptr;
+        };
+
+        struct Level {
+            array<Slot, slotsPerLevel>      slots;
+            array<uint64_t, wordsPerBitmap> occupied {};
+        };
+
+        const time_point_t              epoch;
+        uint64_t                        currentTick = 0;
+        size_t                          count = 0;
+        array<Level, numberOfLevels>    levels;
+        Slot                            overflow;
+
+        // Round up so that an action is never run before its target time.
+        uint64_t tickOf(const time_point_t& tp) const noexcept {
+            if (tp <= epoch) {
+                return 0;
+            }
+            const auto d = tp - epoch;
+            const auto ticks = uint64_t(d / tickDuration);
+            return ((d % tickDuration).count() > 0 ? ticks + 1 : ticks);
+        }
+
+        Slot& slotFor(unsigned level, unsigned slotIndex) noexcept {
+            return (level == overflowLevel ? overflow : levels[level].slots[slotIndex]);
+        }
+
+        void insert(Node* node) noexcept {
+            if (node->tick < currentTick) {
+                node->tick = currentTick;
+            }
+
+            const uint64_t delta = node->tick - currentTick;
+            node->level = overflowLevel;
+            node->slotIndex = 0;
+            for (unsigned level = 0; level < numberOfLevels; ++level) {
+                if (delta < (uint64_t(1) << (bitsPerLevel * (level+1)))) {
+                    node->level = level;
+                    node->slotIndex = unsigned((node->tick >> (bitsPerLevel * level)) & slotMask);
+                    break;
+                }
+            }
+
+            Slot& slot = slotFor(node->level, node->slotIndex);
+            node->next = nullptr;
+            node->prev = slot.tail;
+            if (slot.tail) {
+                slot.tail->next = node;
+            }
+            else {
+                slot.head = node;
+            }
+            slot.tail = node;
+
+            if (node->level != overflowLevel) {
+                levels[node->level].occupied[node->slotIndex / 64] |= (uint64_t(1) << (node->slotIndex % 64));
+            }
+        }
+
+        void unlink(Node* node) noexcept {
+            Slot& slot = slotFor(node->level, node->slotIndex);
+            if (node->prev) { node->prev->next = node->next; } else { slot.head = node->next; }
+            if (node->next) { node->next->prev = node->prev; } else { slot.tail = node->prev; }
+            node->prev = node->next = nullptr;
+
+            if (!slot.head && node->level != overflowLevel) {
+                levels[node->level].occupied[node->slotIndex / 64] &= ~(uint64_t(1) << (node->slotIndex % 64));
+            }
+        }
+
+        // Returns the index of the first non-empty slot at or after start, wrapping
+        // around the end of the level, or -1 if the level is empty.
+        int nextOccupied(const Level& level, unsigned start) const noexcept {
+            for (unsigned i = 0; i <= wordsPerBitmap; ++i) {
+                const unsigned word = ((start / 64) + i) % wordsPerBitmap;
+                uint64_t bits = level.occupied[word];
+                if (i == 0) {
+                    bits &= (~uint64_t(0) << (start % 64));
+                }
+                else if (i == wordsPerBitmap) {
+                    bits &= ~(~uint64_t(0) << (start % 64));
+                }
+                if (bits) {
+                    return int(word * 64 + unsigned(__builtin_ctzll(bits)));
+                }
+            }
+            return -1;
+        }
+
+        // Returns the next tick at which something needs to happen, either a level
+        // 0 slot becoming due, or a higher level slot needing to be cascaded.
+        uint64_t nextEventTick() const noexcept {
+            uint64_t best = noEvent;
+            const int idx0 = nextOccupied(levels[0], unsigned(currentTick & slotMask));
+            if (idx0 >= 0) {
+                best = currentTick + ((uint64_t(idx0) - currentTick) & slotMask);
+            }
+            for (unsigned level = 1; level < numberOfLevels; ++level) {
+                const unsigned shift = bitsPerLevel * level;
+                const uint64_t base = (currentTick >> shift) + 1;
+                const int idx = nextOccupied(levels[level], unsigned(base & slotMask));
+                if (idx >= 0) {
+                    const uint64_t block = base + ((uint64_t(idx) - base) & slotMask);
+                    best = min(best, block << shift);
+                }
+            }
+            if (overflow.head) {
+                const unsigned shift = bitsPerLevel * numberOfLevels;
+                best = min(best, ((currentTick >> shift) + 1) << shift);
+            }
+            return best;
+        }
+
+        // Detach the list before re-inserting, as overflow nodes that are still
+        // too far away will be placed back into the same slot.
+        void cascade(unsigned level, unsigned slotIndex) noexcept {
+            Slot& slot = slotFor(level, slotIndex);
+            Node* node = slot.head;
+            slot.head = slot.tail = nullptr;
+            if (level != overflowLevel) {
+                levels[level].occupied[slotIndex / 64] &= ~(uint64_t(1) << (slotIndex % 64));
+            }
+
+            while (node) {
+                Node* next = node->next;
+                insert(node);
+                node = next;
+            }
+        }
+
+        // Move forward until either the current level 0 slot contains actions, or
+        // we have reached nowTick.
+        void advanceTo(uint64_t nowTick) noexcept {
+            while (!levels[0].slots[currentTick & slotMask].head) {
+                const auto tick = nextEventTick();
+                if (tick > nowTick) {
+                    currentTick = max(currentTick, nowTick);
+                    return;
+                }
+
+                currentTick = tick;
+                const unsigned overflowShift = bitsPerLevel * numberOfLevels;
+                if ((currentTick & ((uint64_t(1) << overflowShift) - 1)) == 0) {
+                    cascade(overflowLevel, 0);
+                }
+                for (unsigned level = numberOfLevels - 1; level > 0; --level) {
+                    const unsigned shift = bitsPerLevel * level;
+                    if ((currentTick & ((uint64_t(1) << shift) - 1)) == 0) {
+                        cascade(level, unsigned((currentTick >> shift) & slotMask));
+                    }
+                }
+            }
+        }
+    };
+
+    constexpr milliseconds TimingWheelStore::tickDuration;
+
+
+    // A bounded, lock-free, multi-producer/single-consumer ring used to submit asap
+    // actions without taking the ActionQueue lock. This follows Dmitry Vyukov's
+    // bounded queue: each cell carries a sequence number that tells a producer when
+    // the cell is free for its ticket, and tells the consumer when the cell has been
+    // published. The consumer methods must only be called by the holder of the
+    // ActionQueue lock, which is what makes this single-consumer even when there are
+    // multiple workers.
+    class IntakeRing {
+    public:
+        IntakeRing() : cells(new Cell[numberOfCells]) {
+            for (size_t i = 0; i < numberOfCells; ++i) {
+                cells[i].sequence.store(i, memory_order_relaxed);
+            }
+        }
+
+        // Returns false, leaving action untouched, if the ring is full. Otherwise the
+        // action is moved into the ring and its ticket is returned in ticket.
+        bool push(ActionQueue::inline_action_t& action, uint64_t& ticket) noexcept {
+            auto pos = enqueuePos.load(memory_order_relaxed);
+            Cell* cell = nullptr;
+            while (true) {
+                cell = &cells[pos & cellMask];
+                const auto seq = cell->sequence.load(memory_order_acquire);
+                const auto dif = int64_t(seq - pos);
+                if (dif == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (dif < 0) {
+                    return false;
+                }
+                else {
+                    pos = enqueuePos.load(memory_order_relaxed);
+                }
+            }
+
+            cell->action = move(action);
+            cell->sequence.store(pos + 1, memory_order_release);
+            ticket = pos;
+            return true;
+        }
+
+        bool available() const noexcept {
+            const auto& cell = cells[dequeuePos & cellMask];
+            return (cell.sequence.load(memory_order_acquire) == dequeuePos + 1);
+        }
+
+        // The number of actions that have been (or are being) pushed but not yet
+        // popped. Cancelled actions are included until they are popped.
+        size_t size() const noexcept {
+            return size_t(enqueuePos.load(memory_order_acquire) - dequeuePos);
+        }
+
+        // The total number of actions that have been (or are being) pushed.
+        uint64_t pushed() const noexcept {
+            return enqueuePos.load(memory_order_relaxed);
+        }
+
+        // Returns false if there is nothing to pop. Note that action may be empty if
+        // it was cancelled while in the ring.
+        bool pop(ActionQueue::inline_action_t& action) noexcept {
+            if (!available()) {
+                return false;
+            }
+            auto& cell = cells[dequeuePos & cellMask];
+            action = move(cell.action);
+            cell.sequence.store(dequeuePos + numberOfCells, memory_order_release);
+            ++dequeuePos;
+            return true;
+        }
+
+        bool isPending(uint64_t ticket) const noexcept {
+            if (ticket < dequeuePos) {
+                return false;
+            }
+            const auto& cell = cells[ticket & cellMask];
+            return (cell.sequence.load(memory_order_acquire) == ticket + 1 && bool(cell.action));
+        }
+
+        bool cancel(uint64_t ticket) noexcept {
+            if (isPending(ticket)) {
+                cells[ticket & cellMask].action = nullptr;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        static constexpr size_t     numberOfCells = 1024;
+        static constexpr uint64_t   cellMask = numberOfCells - 1;
+
+        struct Cell {
+            atomic<uint64_t>                sequence;
+            ActionQueue::inline_action_t    action;
+        };
+
+        // Keep the producer and consumer positions in separate cache lines.
+        unique_ptr<Cell[]>  cells;
+        char                padding1[64];
+        atomic<uint64_t>    enqueuePos { 0 };
+        char                padding2[64];
+        uint64_t            dequeuePos = 0;
+    };
+
+
+    // A descriptor watched by an IOActionQueue. It is shared with any readiness
+    // actions that have been taken into a batch, which check active before running
+    // the action so that a removed descriptor's action is never started.
+    struct DescriptorEntry {
+        unsigned                    events;
+        IOActionQueue::fd_action_t  action;
+        atomic<bool>                active { true };
+    };
+
+    using descriptor_map_t = unordered_map<int, shared_ptr<DescriptorEntry>>;
+
+
+    // The pending actions, held in one store per priority lane. The high and low
+    // lanes are only created when they are first used.
+    class LanedStore {
+    public:
+        void setStorage(ActionQueue::Storage s) noexcept { storage = s; }
+
+        bool empty() const noexcept { return (count == 0); }
+        size_t size() const noexcept { return count; }
+
+        bool hasLane(unsigned lane) const noexcept {
+            return (lanes[lane] && !lanes[lane]->empty());
+        }
+
+        void add(Node* node) {
+            auto& lane = lanes[node->lane];
+            if (!lane) {
+                if (storage == ActionQueue::Storage::timingWheel) {
+                    lane.reset(new TimingWheelStore());
+                }
+                else {
+                    lane.reset(new OrderedStore());
+                }
+            }
+            lane->add(node);
+            ++count;
+        }
+
+        // Returns time_point::max() if the store is empty.
+        time_point_t nextTargetTime() noexcept {
+            auto ret = time_point_t::max();
+            for (unsigned lane = 0; lane < numberOfLanes; ++lane) {
+                if (hasLane(lane)) {
+                    ret = min(ret, lanes[lane]->nextTargetTime());
+                }
+            }
+            return ret;
+        }
+
+        // Take the due actions of the first n lanes, in lane order.
+        Node* removeDue(const time_point_t& currentTime, unsigned n) noexcept {
+            for (unsigned lane = 0; lane < n; ++lane) {
+                if (hasLane(lane)) {
+                    if (Node* node = lanes[lane]->removeDue(currentTime)) {
+                        --count;
+                        return node;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        Node* removeAny() noexcept {
+            for (unsigned lane = 0; lane < numberOfLanes; ++lane) {
+                if (hasLane(lane)) {
+                    --count;
+                    return lanes[lane]->removeAny();
+                }
+            }
+            return nullptr;
+        }
+
+        void remove(Node* node) noexcept {
+            lanes[node->lane]->remove(node);
+            --count;
+        }
+
+    private:
+        ActionQueue::Storage                            storage = ActionQueue::Storage::ordered;
+        array<unique_ptr<ActionStore>, numberOfLanes>   lanes;
+        size_t                                          count = 0;
     };
 }
 
-using action_map_t = multimap<time_point_t, ActionDetails>;
+
+namespace kss { namespace thread { namespace _private {
+
+    // The coalesced repeating actions on a queue that share an interval. A single
+    // pending action runs all the members, holding the lock while it does so, which
+    // lets a member's destructor know that its action is not running once it has the
+    // lock. (The lock is recursive so that an action may destroy a member of its own
+    // group, in which case the member is marked by a nullptr and removed once the
+    // group has finished running.) A retired group has no members and has been
+    // removed from the queue, hence it may no longer be joined.
+    struct RepeatingGroup {
+        ActionQueue*                queue = nullptr;
+        nanoseconds                 interval;
+        recursive_mutex             lock;
+        vector<RepeatingAction*>    members;
+        time_point_t                nextTime;
+        ActionQueue::Handle         handle;
+        bool                        running = false;
+        bool                        retired = false;
+    };
+}}}
 
 
 // MARK: ActionQueue
 
 struct ActionQueue::Impl {
-    std::thread actionThread;
-    size_t      maxPending = 0;
-    bool        stopping = false;
-    bool        waiting = false;
-    bool        runningAction = false;
+    vector<std::thread> workers;
+    size_t              maxPending = 0;
+    bool                serializeIdentifiers = false;
+    bool                batchDispatch = false;
+    atomic<bool>        stopping { false };
+    atomic<bool>        waiting { false };
+    atomic<unsigned>    parkedWorkers { 0 };
+    size_t              runningActions = 0;
+    IntakeRing          intake;
+
+    // Only present in an IOActionQueue, in which case the (single) worker waits in
+    // the poller instead of on workAvailable. The descriptors are protected by the
+    // lock, the poller itself may be used by any thread.
+    unique_ptr<_private::Poller>    poller;
+    descriptor_map_t                descriptors;
+    _private::Poller::ready_t       readyDescriptors;
+    uint64_t                        readinessActions = 0;
+    unsigned                        dispatchesSincePoll = 0;
+
+    static constexpr unsigned       dispatchesPerPoll = 64;
 
-    // The following must be protected by the lock and the condition variable.
-    mutex               lock;
-    condition_variable  cv;
-    action_map_t        pendingActions;
+    // The coalesced RepeatingAction groups, keyed by their intervals in nanoseconds.
+    // This is protected by the lock.
+    unordered_map<nanoseconds::rep, shared_ptr<_private::RepeatingGroup>> repeatingGroups;
+
+    // The following must be protected by the lock and the condition variables.
+    // The workers wait on workAvailable, wait() waits on cv, and the producers
+    // of addActionWait() and addActionFor() wait on roomAvailable.
+    mutex                       lock;
+    condition_variable          workAvailable;
+    condition_variable          cv;
+    condition_variable          roomAvailable;
+    size_t                      waitingProducers = 0;
+    NodeSlab                    slab;
+    LanedStore                  pendingActions;
+    identifier_index_t          identifiers;
+    size_t                      deferredActions = 0;
+    uint64_t                    lastSequence = 0;
+
+    // The statistics, also protected by the lock. The observer is replaced rather
+    // than modified, so that a worker may keep using its copy after unlocking.
+    uint64_t                            addedBase = 0;
+    uint64_t                            completedActions = 0;
+    uint64_t                            cancelledActions = 0;
+    uint64_t                            rejectedActions = 0;
+    size_t                              peakPending = 0;
+    LatencyHistogram                    lateness;
+    LatencyHistogram                    runTime;
+    shared_ptr<const action_observer_t> observer;
 
     inline time_point_t getNextTargetTime() noexcept {
-        return (pendingActions.empty()
-                ? now<time_point_t>() + 10000ms
-                : pendingActions.begin()->first);
+        return pendingActions.nextTargetTime();
+    }
+
+    // The number of pending actions, excluding those still in the intake ring.
+    inline size_t lockedPending() const noexcept {
+        return pendingActions.size() + deferredActions;
+    }
+
+    inline size_t numberPending() const noexcept {
+        return lockedPending() + intake.size();
+    }
+
+    // An action that has been taken from the queue to be run by a worker. If the
+    // action belongs to a serialized identifier group, group refers to its entry.
+    // The times are filled in as the action is run.
+    struct BatchItem {
+        inline_action_t                 action;
+        identifier_index_t::value_type* group;
+        ActionTiming                    timing;
+    };
+
+    static BatchItem makeItem(inline_action_t&& action,
+                              identifier_index_t::value_type* group,
+                              const time_point_t& targetTime) noexcept
+    {
+        BatchItem item { move(action), group, ActionTiming() };
+        item.timing.targetTime = targetTime;
+        return item;
     }
 
+    // Each worker thread runs this loop. The lock is held except while actions are
+    // actually running. In single dispatch mode each batch holds one action. In
+    // batched dispatch mode a batch holds every action that is due, and the lock
+    // is only taken again (and the other threads notified) once the entire batch
+    // has been run.
     void runActionThread() {
-        while (true) {
-            bool haveAction = false;
-            action_t currentAction;
+        vector<BatchItem> batch;
+        unique_lock<mutex> l(lock);
+        while (!stopping) {
+            // Due high priority actions are taken first, then the actions submitted
+            // through the intake ring, and only then the other pending actions.
+            auto pendingBefore = lockedPending();
+            if (batchDispatch || batch.empty()) {
+                notePending();
+                if (pendingActions.hasLane(highLane)) {
+                    takeDueActions(batch, now<time_point_t>(), highLane + 1);
+                }
+                takeIntakeActions(batch);
+            }
+
+            const auto currentTime = now<time_point_t>();
+            takeDueActions(batch, currentTime);
+            notifyProducers(pendingBefore - lockedPending());
+
+            // Sleep until the next action must run, or until something changes
+            // that could make an earlier action due. With nothing pending there is
+            // no timeout at all. The parked count tells the intake producers that
+            // they must notify us. Since it is incremented while we hold the lock, a
+            // producer that sees it and then takes the lock before notifying cannot
+            // miss us.
+            if (batch.empty()) {
+                const auto nextTargetTime = getNextTargetTime();
+                const bool idle = (nextTargetTime > currentTime);
+                if (poller) {
+                    dispatchesSincePoll = 0;
+                    pollDescriptors(l, batch, idle ? nextTargetTime : time_point_t::min());
+                }
+                else if (idle) {
+                    const auto wakeCondition = [&] {
+                        return stopping || intake.available() || getNextTargetTime() < nextTargetTime;
+                    };
+                    parkedWorkers.fetch_add(1);
+                    atomic_thread_fence(memory_order_seq_cst);
+                    if (nextTargetTime == time_point_t::max()) {
+                        workAvailable.wait(l, wakeCondition);
+                    }
+                    else {
+                        workAvailable.wait_until(l, nextTargetTime, wakeCondition);
+                    }
+                    parkedWorkers.fetch_sub(1);
+                }
+                continue;
+            }
+
+            // A steady stream of due actions must not starve the descriptors.
+            if (poller && ++dispatchesSincePoll >= dispatchesPerPoll) {
+                dispatchesSincePoll = 0;
+                pollDescriptors(l, batch, time_point_t::min());
+            }
+
+            runningActions += batch.size();
+            const auto obs = observer;
+            l.unlock();
+            runBatch(batch, obs.get());
+            l.lock();
+            runningActions -= batch.size();
+            recordBatch(batch);
+
+            pendingBefore = lockedPending();
+            finishBatch(batch);
+            notifyProducers(pendingBefore - lockedPending());
+            cv.notify_all();
+        }
+    }
+
+    // Wait in the poller until the deadline (or just check the descriptors if it has
+    // passed), then add an action to the batch for each ready descriptor. The parked
+    // count works as it does for workAvailable, except that a wake() that arrives
+    // before we reach the poller is not lost, hence we need only re-check the
+    // intake ring after announcing ourselves.
+    void pollDescriptors(unique_lock<mutex>& l, vector<BatchItem>& batch, time_point_t deadline) {
+        const bool parking = (deadline != time_point_t::min());
+        if (parking) {
+            parkedWorkers.fetch_add(1);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (stopping || intake.available()) {
+                deadline = time_point_t::min();
+            }
+        }
+
+        l.unlock();
+        poller->wait(readyDescriptors, deadline);
+        l.lock();
+        if (parking) {
+            parkedWorkers.fetch_sub(1);
+        }
+
+        for (const auto& ready : readyDescriptors) {
+            const auto it = descriptors.find(ready.first);
+            if (it != descriptors.end()) {
+                auto entry = it->second;
+                const int fd = ready.first;
+                const unsigned events = ready.second;
+                batch.push_back(makeItem(inline_action_t([entry, fd, events] {
+                    if (entry->active) {
+                        entry->action(fd, events);
+                    }
+                }), nullptr, time_point_t::min()));
+                ++readinessActions;
+            }
+        }
+        readyDescriptors.clear();
+    }
+
+    // Wake the worker(s), wherever they are waiting.
+    void wakeWorkers() noexcept {
+        workAvailable.notify_all();
+        if (poller) {
+            poller->wake();
+        }
+    }
+
+    // Run the actions, which must be done without holding the lock, noting the times
+    // as we go. The observer, if there is one, is told about each action as soon as
+    // it has finished.
+    static void runBatch(vector<BatchItem>& batch, const action_observer_t* obs) {
+        auto startTime = now<time_point_t>();
+        for (auto& item : batch) {
+            item.action();
+            item.action = nullptr;
+            item.timing.startTime = startTime;
+            item.timing.finishTime = now<time_point_t>();
+            startTime = item.timing.finishTime;
+            if (obs) {
+                try {
+                    (*obs)(item.timing);
+                }
+                catch (const exception& e) {
+                    syslog(LOG_ERR, "[%s] Action observer threw: %s", __PRETTY_FUNCTION__, e.what());
+                }
+                startTime = now<time_point_t>();
+            }
+        }
+    }
+
+    // Add the actions that were just run to the statistics. This must be called,
+    // with the lock held, before finishBatch() adds anything to the batch.
+    void recordBatch(const vector<BatchItem>& batch) noexcept {
+        completedActions += batch.size();
+        for (const auto& item : batch) {
+            if (item.timing.targetTime != time_point_t::min()) {
+                lateness.record(item.timing.startTime - item.timing.targetTime);
+            }
+            runTime.record(item.timing.finishTime - item.timing.startTime);
+        }
+    }
+
+    // The lock must be held by the caller.
+    inline void notePending() noexcept {
+        peakPending = max(peakPending, numberPending());
+    }
+
+    // Wake as many waiting producers as there are newly available places. The lock
+    // must be held by the caller.
+    void notifyProducers(size_t numberFreed) {
+        for (size_t i = 0, n = min(numberFreed, waitingProducers); i < n; ++i) {
+            roomAvailable.notify_one();
+        }
+    }
 
-            {
-                unique_lock<mutex> l(lock);
+    // Move actions from the intake ring into the batch, skipping any that were
+    // cancelled while in the ring.
+    void takeIntakeActions(vector<BatchItem>& batch) {
+        bool skipped = false;
+        inline_action_t action;
+        while ((batchDispatch || batch.empty()) && intake.pop(action)) {
+            if (action) {
+                batch.push_back(makeItem(move(action), nullptr, time_point_t::min()));
+            }
+            else {
+                skipped = true;
+            }
+        }
+
+        // A skipped action may have been the last one that wait() was waiting for.
+        if (skipped) {
+            cv.notify_all();
+        }
+    }
+
+    // The lock-free path used for asap actions without identifiers. This is only
+    // used when the queue has no maxPending limit, so that we need not maintain a
+    // separate atomic count. Returns false if the action must instead be added via
+    // the locked path.
+    bool tryAddIntake(inline_action_t& action, Handle& handle) noexcept {
+        if (maxPending != ActionQueue::noLimit || stopping || waiting) {
+            return false;
+        }
+
+        uint64_t ticket = 0;
+        if (!intake.push(action, ticket)) {
+            return false;
+        }
+
+        // Only notify if a worker is parked. See runActionThread() for why we must
+        // take the lock (albeit briefly) before notifying.
+        atomic_thread_fence(memory_order_seq_cst);
+        if (parkedWorkers.load() > 0) {
+            { lock_guard<mutex> l(lock); }
+            if (poller) {
+                poller->wake();
+            }
+            else {
+                workAvailable.notify_one();
+            }
+        }
+
+        handle.owner = this;
+        handle.node = &intake;
+        handle.sequence = ticket;
+        handle.intake = true;
+        return true;
+    }
+
+    // Move the due actions of the first n lanes that may be run now into the batch,
+    // deferring any that belong to a serialized identifier group that is already
+    // running.
+    void takeDueActions(vector<BatchItem>& batch, const time_point_t& currentTime, unsigned n = numberOfLanes) {
+        while (batchDispatch || batch.empty()) {
+            Node* node = pendingActions.removeDue(currentTime, n);
+            if (!node) {
+                break;
+            }
+
+            auto* entry = (serializeIdentifiers ? node->identifier : nullptr);
+            if (entry && entry->second.running) {
+                deferNode(node);
+                continue;
+            }
+
+            batch.push_back(makeItem(move(node->action), entry, node->targetTime));
+            if (entry) {
+                entry->second.running = true;
+            }
+            releaseNode(node);
+        }
+    }
+
+    // Clear the batch and, for each serialized group it contained, either take the
+    // group's next deferred action into the new batch (to be run by this same
+    // worker), or mark the group as no longer running.
+    void finishBatch(vector<BatchItem>& batch) {
+        const auto n = batch.size();
+        for (size_t i = 0; i < n; ++i) {
+            auto* entry = batch[i].group;
+            if (entry) {
+                auto& group = entry->second;
+                if (group.deferredHead && !stopping) {
+                    Node* node = popDeferred(group);
+                    batch.push_back(makeItem(move(node->action), entry, node->targetTime));
+                    releaseNode(node);
+                }
+                else {
+                    group.running = false;
+                    if (group.count == 0) {
+                        identifiers.erase(entry->first);
+                    }
+                }
+            }
+        }
+        batch.erase(batch.begin(), batch.begin() + ptrdiff_t(n));
+    }
+
+    void deferNode(Node* node) noexcept {
+        auto& group = node->identifier->second;
+        node->deferred = true;
+        node->next = nullptr;
+        node->prev = group.deferredTail;
+        if (group.deferredTail) {
+            group.deferredTail->next = node;
+        }
+        else {
+            group.deferredHead = node;
+        }
+        group.deferredTail = node;
+        ++deferredActions;
+    }
+
+    void unlinkDeferred(Node* node) noexcept {
+        auto& group = node->identifier->second;
+        if (node->prev) { node->prev->next = node->next; } else { group.deferredHead = node->next; }
+        if (node->next) { node->next->prev = node->prev; } else { group.deferredTail = node->prev; }
+        node->prev = node->next = nullptr;
+        node->deferred = false;
+        --deferredActions;
+    }
+
+    Node* popDeferred(IdentifierGroup& group) noexcept {
+        Node* node = group.deferredHead;
+        unlinkDeferred(node);
+        return node;
+    }
+
+    // Remove a node from wherever it is waiting, without releasing it.
+    void removePending(Node* node) noexcept {
+        if (node->deferred) {
+            unlinkDeferred(node);
+        }
+        else {
+            pendingActions.remove(node);
+        }
+    }
+
+    Handle addNode(const time_point_t& targetTime,
+                   const string& identifier,
+                   inline_action_t&& action,
+                   const Options& options = Options(),
+                   bool ignoreCapacity = false)
+    {
+        lock_guard<mutex> l(lock);
+        if (!stopping) {
+            if (!ignoreCapacity) {
+                checkCapacity(1, "addActionAfter");
+            }
+            return lockedAddNode(targetTime, identifier, move(action), options);
+        }
+        return Handle();
+    }
+
+    // As addNode(), but waits, up to the deadline if one is given, until there is
+    // room for the node. The delay is applied once there is room.
+    Handle addNodeWhenRoom(const nanoseconds& delay,
+                           const string& identifier,
+                           inline_action_t&& action,
+                           const time_point_t* deadline)
+    {
+        unique_lock<mutex> l(lock);
+        const auto hasRoom = [this] {
+            return (stopping || (!waiting && numberPending() < maxPending));
+        };
+
+        if (!hasRoom()) {
+            ++waitingProducers;
+            bool ready = true;
+            if (deadline) {
+                ready = roomAvailable.wait_until(l, *deadline, hasRoom);
+            }
+            else {
+                roomAvailable.wait(l, hasRoom);
+            }
+            --waitingProducers;
+            if (!ready) {
+                return Handle();
+            }
+        }
+
+        if (stopping) {
+            return Handle();
+        }
+        return lockedAddNode(now<time_point_t>() + delay, identifier, move(action));
+    }
+
+    // The lock must be held by the caller.
+    Handle lockedAddNode(const time_point_t& targetTime,
+                         const string& identifier,
+                         inline_action_t&& action,
+                         const Options& options = Options())
+    {
+        Handle handle;
+        Node* node = insertNode(targetTime, identifier, move(action), options);
+        handle.owner = this;
+        handle.node = node;
+        handle.sequence = node->sequence;
+        notePending();
+        wakeWorkers();
+
+        contract::postconditions({
+            KSS_EXPR(!pendingActions.empty())
+        });
+        return handle;
+    }
+
+    // Add all the actions or, if any cannot be added, none of them.
+    void addNodes(const time_point_t& targetTime, const string& identifier, vector<inline_action_t>& actions) {
+        if (actions.empty()) {
+            return;
+        }
+
+        lock_guard<mutex> l(lock);
+        if (!stopping) {
+            checkCapacity(actions.size(), "addActions");
+
+            vector<Node*> added;
+            added.reserve(actions.size());
+            try {
+                for (auto& action : actions) {
+                    added.push_back(insertNode(targetTime, identifier, move(action)));
+                }
+            }
+            catch (...) {
+                for (size_t i = 0; i < added.size(); ++i) {
+                    actions[i] = move(added[i]->action);
+                    removePending(added[i]);
+                    releaseNode(added[i]);
+                }
+                throw;
+            }
+            notePending();
+            wakeWorkers();
+
+            contract::postconditions({
+                KSS_EXPR(pendingActions.size() >= actions.size())
+            });
+        }
+    }
 
-                if (stopping) {
-                    break;
-                }
+    void checkCapacity(size_t numberToAdd, const char* what) {
+        if (waiting) {
+            ++rejectedActions;
+            throw system_error(EAGAIN, system_category(), string(what) + " (queue waiting)");
+        }
+        const auto n = numberPending();
+        if (n >= maxPending || numberToAdd > (maxPending - n)) {
+            ++rejectedActions;
+            throw system_error(EAGAIN, system_category(), what);
+        }
+    }
 
-                const auto nextTargetTime = getNextTargetTime();
-                cv.wait_until(l, nextTargetTime, [this] {
-                    return stopping || !pendingActions.empty();
-                });
+    // Create a node for the action and add it to the pending actions. The lock
+    // must be held by the caller.
+    Node* insertNode(const time_point_t& targetTime,
+                     const string& identifier,
+                     inline_action_t&& action,
+                     const Options& options = Options())
+    {
+        Node* node = slab.allocate();
+        node->targetTime = targetTime;
+        node->deadline = (options.slack > (time_point_t::max() - targetTime)
+                          ? time_point_t::max()
+                          : targetTime + options.slack);
+        node->lane = (options.priority == Priority::high ? highLane
+                      : options.priority == Priority::low ? lowLane
+                      : normalLane);
+        node->action = move(action);
+        try {
+            pendingActions.add(node);
+        }
+        catch (...) {
+            action = move(node->action);
+            slab.release(node);
+            throw;
+        }
+        if (!identifier.empty()) {
+            addToIdentifierGroup(node, identifier);
+        }
+        node->sequence = ++lastSequence;
+        return node;
+    }
 
-                if (stopping) {
-                    break;
-                }
+    // If the identifier group insertion fails, the node will remain pending but
+    // cannot be cancelled by its identifier. Since the only failure is memory
+    // allocation, we accept that.
+    void addToIdentifierGroup(Node* node, const string& identifier) noexcept {
+        try {
+            // Look up the group first, since emplace() would allocate an index
+            // entry even when the identifier is already present.
+            auto it = identifiers.find(identifier);
+            if (it == identifiers.end()) {
+                it = identifiers.emplace(identifier, IdentifierGroup()).first;
+            }
+            auto& entry = *it;
+            auto& group = entry.second;
+            node->identifier = &entry;
+            node->prevWithIdentifier = nullptr;
+            node->nextWithIdentifier = group.head;
+            if (group.head) {
+                group.head->prevWithIdentifier = node;
+            }
+            group.head = node;
+            ++group.count;
+        }
+        catch (const exception& e) {
+            syslog(LOG_ERR, "[%s] Could not index identifier: %s", __PRETTY_FUNCTION__, e.what());
+        }
+    }
 
-                if (!pendingActions.empty()) {
-                    // If the next action is due to run, remove it from the queue and
-                    // place it into currentAction.
-                    const auto cit = pendingActions.begin();
-                    const auto currentTime = now<time_point_t>();
-                    if (cit->first <= currentTime) {
-                        runningAction = true;
-                        currentAction = move(cit->second.action);
-                        pendingActions.erase(cit);
-                        haveAction = true;
-                    }
-                }
+    // Remove the node from its identifier group (if any) and return it to the slab.
+    // The node must already have been removed from the pending actions.
+    void releaseNode(Node* node) noexcept {
+        if (node->identifier) {
+            auto& group = node->identifier->second;
+            if (node->prevWithIdentifier) {
+                node->prevWithIdentifier->nextWithIdentifier = node->nextWithIdentifier;
+            }
+            else {
+                group.head = node->nextWithIdentifier;
             }
+            if (node->nextWithIdentifier) {
+                node->nextWithIdentifier->prevWithIdentifier = node->prevWithIdentifier;
+            }
+            node->prevWithIdentifier = node->nextWithIdentifier = nullptr;
 
-            if (haveAction) {
-                runAction(currentAction);
+            if (--group.count == 0 && !group.running) {
+                identifiers.erase(node->identifier->first);
             }
         }
+        slab.release(node);
     }
 
-    void runAction(const action_t& action) {
-        action();
-        {
-            lock_guard<mutex> l(lock);
-            runningAction = false;
+    bool isPending(const Handle& handle) const noexcept {
+        if (handle.owner == this && handle.intake) {
+            return intake.isPending(handle.sequence);
+        }
+        if (handle.owner == this && handle.node) {
+            return (static_cast<const Node*>(handle.node)->sequence == handle.sequence);
         }
-        cv.notify_all();
+        return false;
     }
 
-    void addActionDetails(ActionDetails&& details) {
-        lock_guard<mutex> l(lock);
-        if (!stopping) {
-            if (waiting) {
-                throw system_error(EAGAIN, system_category(), "addActionAfter (queue waiting)");
+    size_t cancelAll() noexcept {
+        size_t ret = 0;
+        inline_action_t action;
+        while (intake.pop(action)) {
+            if (action) {
+                action = nullptr;
+                ++ret;
             }
-            else {
-                if (pendingActions.size() >= maxPending) {
-                    throw system_error(EAGAIN, system_category(), "addActionAfter");
-                }
+        }
+
+        while (Node* node = pendingActions.removeAny()) {
+            releaseNode(node);
+            ++ret;
+        }
 
-                pendingActions.emplace(details.targetTime, move(details));
-                cv.notify_all();
+        // Deferred actions are only possible in a running group, hence releasing
+        // them cannot erase the group we are examining.
+        if (deferredActions > 0) {
+            for (auto& entry : identifiers) {
+                while (entry.second.deferredHead) {
+                    releaseNode(popDeferred(entry.second));
+                    ++ret;
+                }
+            }
+        }
+        return ret;
+    }
 
-                contract::postconditions({
-                    KSS_EXPR(!pendingActions.empty())
-                });
+    size_t cancelGroup(const string& identifier) noexcept {
+        size_t ret = 0;
+        const auto it = identifiers.find(identifier);
+        if (it != identifiers.end()) {
+            // Releasing the last node will remove the group from the index, so we
+            // must not refer to the group after that.
+            const auto count = it->second.count;
+            for (size_t i = 0; i < count; ++i) {
+                Node* node = it->second.head;
+                removePending(node);
+                releaseNode(node);
+                ++ret;
             }
         }
+        return ret;
+    }
+
+    size_t cancelHandle(const Handle& handle) noexcept {
+        if (handle.owner == this && handle.intake) {
+            return (intake.cancel(handle.sequence) ? 1 : 0);
+        }
+        if (isPending(handle)) {
+            Node* node = static_cast<Node*>(handle.node);
+            removePending(node);
+            releaseNode(node);
+            return 1;
+        }
+        return 0;
     }
 };
 
 
 const milliseconds ActionQueue::asap { 0 };
 
-ActionQueue::ActionQueue(ActionQueue&&) = default;
-ActionQueue& ActionQueue::operator=(ActionQueue &&) noexcept = default;
+// The link must follow the implementation, so that it refers to the object that
+// now owns it.
+ActionQueue::ActionQueue(ActionQueue&& other)
+: impl(move(other.impl)), link(move(other.link))
+{
+    if (link) {
+        lock_guard<mutex> l(link->lock);
+        link->queue = this;
+    }
+}
 
-ActionQueue::ActionQueue(size_t maxPending) : impl(new Impl()) {
-    lock_guard<mutex> l(impl->lock);
+// Our own workers must be stopped and joined before the implementation they refer
+// to is replaced.
+ActionQueue& ActionQueue::operator=(ActionQueue&& other) noexcept {
+    if (this != &other) {
+        shutdown();
+        impl = move(other.impl);
+        link = move(other.link);
+        if (link) {
+            lock_guard<mutex> l(link->lock);
+            link->queue = this;
+        }
+    }
+    return *this;
+}
+
+ActionQueue::ActionQueue(size_t maxPending,
+                         Storage storage,
+                         Dispatch dispatch,
+                         const ThreadAttributes& attributes)
+: ActionQueue(maxPending, storage, dispatch, attributes, 1, false)
+{
+}
+
+ActionQueue::ActionQueue(size_t maxPending,
+                         Storage storage,
+                         Dispatch dispatch,
+                         const ThreadAttributes& attributes,
+                         unsigned numberOfWorkers,
+                         bool serializeIdentifiers,
+                         bool pollDescriptors)
+: impl(new Impl()), link(make_shared<_private::QueueLink>(this))
+{
+    contract::parameters({
+        KSS_EXPR(numberOfWorkers > 0),
+        KSS_EXPR(!pollDescriptors || numberOfWorkers == 1)
+    });
+
+    if (pollDescriptors) {
+        impl->poller.reset(new _private::Poller());
+    }
 
     impl->maxPending = maxPending;
-    impl->actionThread = std::thread { [this]{ impl->runActionThread(); }};
+    impl->serializeIdentifiers = serializeIdentifiers;
+    impl->batchDispatch = (dispatch == Dispatch::batched);
+    impl->pendingActions.setStorage(storage);
+
+    // The workers refer to the implementation rather than to this object, so that
+    // the queue may be safely moved.
+    auto self = impl.get();
+    impl->workers.reserve(numberOfWorkers);
+    try {
+        for (unsigned i = 0; i < numberOfWorkers; ++i) {
+            impl->workers.emplace_back([self]{ self->runActionThread(); });
+            if (!attributes.empty()) {
+                attributes.apply(impl->workers.back());
+            }
+        }
+    }
+    catch (...) {
+        locked(impl->lock, [self] { self->stopping = true; });
+        impl->wakeWorkers();
+        for (auto& t : impl->workers) {
+            t.join();
+        }
+        throw;
+    }
 
     contract::postconditions({
         KSS_EXPR(impl->maxPending == maxPending),
+        KSS_EXPR(impl->workers.size() == numberOfWorkers),
         KSS_EXPR(impl->stopping == false),
         KSS_EXPR(impl->waiting == false),
-        KSS_EXPR(impl->runningAction == false),
+        KSS_EXPR(impl->runningActions == 0),
         KSS_EXPR(impl->pendingActions.empty())
     });
 }
 
 ActionQueue::~ActionQueue() noexcept {
+    shutdown();
+}
+
+// Detach the link, then stop the workers, discard the pending actions, and wait
+// for the workers to exit. This does nothing to a moved-from queue.
+void ActionQueue::shutdown() noexcept {
     try {
+        if (link) {
+            lock_guard<mutex> l(link->lock);
+            link->queue = nullptr;
+        }
+        if (!impl) {
+            return;
+        }
         {
             lock_guard<mutex> l(impl->lock);
             impl->stopping = true;
         }
+        impl->wakeWorkers();
         impl->cv.notify_all();
+        impl->roomAvailable.notify_all();
         cancel();
-        if (impl->actionThread.joinable()) {
-            impl->actionThread.join();
+        for (auto& t : impl->workers) {
+            if (t.joinable()) {
+                t.join();
+            }
         }
     }
     catch (const exception& e) {
@@ -174,117 +1451,517 @@ ActionQueue::~ActionQueue() noexcept {
 
 
 size_t ActionQueue::cancel(const string& identifier) {
+    if (!impl) {
+        return 0;
+    }
+
     size_t ret = 0;
     {
         lock_guard<mutex> l(impl->lock);
-        const auto sizeIn = impl->pendingActions.size();
-        if (!impl->pendingActions.empty()) {
-            if (identifier.empty()) {
-                ret = sizeIn;
-                impl->pendingActions.clear();
-            }
-            else {
-                const auto end = impl->pendingActions.end();
-                for (auto it = impl->pendingActions.begin(); it != end;) {
-                    if (it->second.identifier == identifier) {
-                        it = impl->pendingActions.erase(it);
-                        ++ret;
-                    }
-                    else {
-                        ++it;
-                    }
-                }
-            }
-        }
+        const auto sizeIn = impl->lockedPending();
+        ret = (identifier.empty() ? impl->cancelAll() : impl->cancelGroup(identifier));
+        impl->cancelledActions += ret;
+
+        // Actions in the intake ring have no identifiers, and more may be
+        // submitted at any time, hence we cannot include them here.
+        contract::postconditions({
+            KSS_EXPR(impl->lockedPending() == (identifier.empty() ? 0 : sizeIn - ret))
+        });
+    }
+
+    if (ret > 0) {
+        impl->wakeWorkers();
+        impl->cv.notify_all();
+        impl->roomAvailable.notify_all();
+    }
+    return ret;
+}
+
+size_t ActionQueue::cancel(const Handle& handle) {
+    if (!impl) {
+        return 0;
+    }
+
+    size_t ret = 0;
+    {
+        lock_guard<mutex> l(impl->lock);
+        ret = impl->cancelHandle(handle);
+        impl->cancelledActions += ret;
 
         contract::postconditions({
-            KSS_EXPR(impl->pendingActions.size() == (sizeIn - ret))
+            KSS_EXPR(!impl->isPending(handle))
         });
     }
 
     if (ret > 0) {
+        impl->wakeWorkers();
         impl->cv.notify_all();
+        impl->roomAvailable.notify_all();
     }
     return ret;
 }
 
 
 void ActionQueue::wait() {
+    if (!impl) {
+        return;
+    }
+
+    _private::WakeOnStop waker(impl->lock, impl->cv);
     unique_lock<mutex> l(impl->lock);
-    if (!impl->pendingActions.empty() || impl->runningAction) {
+    if (impl->numberPending() > 0 || impl->runningActions > 0) {
         impl->waiting = true;
         auto self = impl.get();
-        impl->cv.wait(l, [self] {
-            return self->stopping || (self->pendingActions.empty() && !self->runningAction);
-        });
+        try {
+            impl->cv.wait(l, [self] {
+                if (_private::currentStopToken().stopRequested()) {
+                    throw Stopped();
+                }
+                return self->stopping || (self->numberPending() == 0 && self->runningActions == 0);
+            });
+        }
+        catch (const Stopped&) {
+            impl->waiting = false;
+            impl->roomAvailable.notify_all();
+            throw;
+        }
         impl->waiting = false;
+        impl->roomAvailable.notify_all();
     }
 
     contract::postconditions({
         KSS_EXPR(impl->waiting == false),
-        KSS_EXPR(impl->runningAction == false),
-        KSS_EXPR(impl->pendingActions.empty())
+        KSS_EXPR(impl->runningActions == 0),
+        KSS_EXPR(impl->lockedPending() == 0)
+    });
+}
+
+
+ActionQueue::Statistics ActionQueue::statistics() const {
+    Statistics ret;
+    if (!impl) {
+        return ret;
+    }
+
+    lock_guard<mutex> l(impl->lock);
+    ret.pending = impl->numberPending();
+    ret.running = impl->runningActions;
+    ret.peakPending = max(impl->peakPending, ret.pending);
+    ret.added = impl->lastSequence + impl->intake.pushed() + impl->readinessActions - impl->addedBase;
+    ret.completed = impl->completedActions;
+    ret.cancelled = impl->cancelledActions;
+    ret.rejected = impl->rejectedActions;
+    ret.lateness = impl->lateness;
+    ret.runTime = impl->runTime;
+    return ret;
+}
+
+void ActionQueue::resetStatistics() {
+    if (!impl) {
+        return;
+    }
+
+    lock_guard<mutex> l(impl->lock);
+    impl->addedBase = impl->lastSequence + impl->intake.pushed() + impl->readinessActions;
+    impl->completedActions = 0;
+    impl->cancelledActions = 0;
+    impl->rejectedActions = 0;
+    impl->peakPending = impl->numberPending();
+    impl->lateness.clear();
+    impl->runTime.clear();
+}
+
+void ActionQueue::setActionObserver(action_observer_t observer) {
+    shared_ptr<const action_observer_t> obs;
+    if (observer) {
+        obs = make_shared<const action_observer_t>(move(observer));
+    }
+
+    if (!impl) {
+        return;
+    }
+
+    // Swap so that the old observer is destroyed after we release the lock.
+    lock_guard<mutex> l(impl->lock);
+    impl->observer.swap(obs);
+}
+
+
+ActionQueue::Handle ActionQueue::addActionAfter(const nanoseconds &delay,
+                                                const string& identifier,
+                                                inline_action_t &&action)
+{
+    contract::parameters({
+        KSS_EXPR(delay.count() >= 0)
     });
+
+    if (!impl) {
+        return Handle();
+    }
+    if (delay.count() == 0 && identifier.empty()) {
+        Handle handle;
+        if (impl->tryAddIntake(action, handle)) {
+            return handle;
+        }
+    }
+    return impl->addNode(now<time_point_t>() + delay, identifier, move(action));
 }
 
+ActionQueue::Handle ActionQueue::addActionWithOptions(const Options& options,
+                                                      const nanoseconds& delay,
+                                                      const string& identifier,
+                                                      inline_action_t&& action)
+{
+    contract::parameters({
+        KSS_EXPR(delay.count() >= 0),
+        KSS_EXPR(options.slack.count() >= 0)
+    });
+
+    if (!impl) {
+        return Handle();
+    }
+
+    // Only default options may take the lock-free path, since the intake ring has
+    // neither priorities nor slack.
+    if (delay.count() == 0 && identifier.empty()
+        && options.priority == Priority::normal && options.slack.count() == 0)
+    {
+        Handle handle;
+        if (impl->tryAddIntake(action, handle)) {
+            return handle;
+        }
+    }
+    return impl->addNode(now<time_point_t>() + delay, identifier, move(action), options);
+}
 
-void ActionQueue::addActionAfter(const milliseconds &delay,
-                                 const string& identifier,
-                                 const action_t &action)
+void ActionQueue::addActionsAfter(const nanoseconds &delay,
+                                  const string& identifier,
+                                  vector<inline_action_t>&& actions)
 {
     contract::parameters({
         KSS_EXPR(delay.count() >= 0)
     });
 
-    ActionDetails details { now<time_point_t>() + delay, identifier, action };
-    impl->addActionDetails(move(details));
+    if (impl) {
+        impl->addNodes(now<time_point_t>() + delay, identifier, actions);
+    }
 }
 
-void ActionQueue::addActionAfter(const milliseconds &delay,
-                                 const string& identifier,
-                                 action_t &&action)
+ActionQueue::Handle ActionQueue::addActionWhenRoom(const nanoseconds& delay,
+                                                   const string& identifier,
+                                                   inline_action_t&& action,
+                                                   const nanoseconds* timeout)
 {
     contract::parameters({
         KSS_EXPR(delay.count() >= 0)
     });
 
-    ActionDetails details { now<time_point_t>() + delay, identifier, move(action) };
-    impl->addActionDetails(move(details));
+    if (!impl) {
+        return Handle();
+    }
+    if (delay.count() == 0 && identifier.empty()) {
+        Handle handle;
+        if (impl->tryAddIntake(action, handle)) {
+            return handle;
+        }
+    }
+
+    if (timeout) {
+        const auto deadline = now<time_point_t>() + max(*timeout, nanoseconds::zero());
+        return impl->addNodeWhenRoom(delay, identifier, move(action), &deadline);
+    }
+    return impl->addNodeWhenRoom(delay, identifier, move(action), nullptr);
+}
+
+ActionQueue::Handle ActionQueue::requeueAction(const nanoseconds& delay, inline_action_t&& action) {
+    if (!impl) {
+        return Handle();
+    }
+    return impl->addNode(now<time_point_t>() + delay, "", move(action), Options(), true);
+}
+
+ActionQueue::Handle ActionQueue::requeueActionAt(const time_point_t& targetTime, inline_action_t&& action) {
+    if (!impl) {
+        return Handle();
+    }
+    return impl->addNode(targetTime, "", move(action), Options(), true);
+}
+
+ActionQueue::Handle ActionQueue::addActionAtTime(const time_point_t& targetTime,
+                                                 const string& identifier,
+                                                 inline_action_t &&action)
+{
+    if (!impl) {
+        return Handle();
+    }
+    return impl->addNode(targetTime, identifier, move(action));
+}
+
+
+// MARK: IOActionQueue
+
+constexpr unsigned IOActionQueue::readable;
+constexpr unsigned IOActionQueue::writable;
+constexpr unsigned IOActionQueue::hangup;
+constexpr unsigned IOActionQueue::error;
+
+void IOActionQueue::addFdAction(int fd, unsigned events, fd_action_t action) {
+    contract::parameters({
+        KSS_EXPR(fd >= 0),
+        KSS_EXPR((events & (readable | writable)) != 0),
+        KSS_EXPR(bool(action))
+    });
+
+    auto entry = make_shared<DescriptorEntry>();
+    entry->events = events;
+    entry->action = move(action);
+
+    if (!impl) {
+        return;
+    }
+    lock_guard<mutex> l(impl->lock);
+    if (impl->descriptors.count(fd) > 0) {
+        throw system_error(EEXIST, system_category(), "addFdAction");
+    }
+    auto it = impl->descriptors.emplace(fd, move(entry)).first;
+    try {
+        impl->poller->add(fd, events);
+    }
+    catch (...) {
+        impl->descriptors.erase(it);
+        throw;
+    }
+
+    contract::postconditions({
+        KSS_EXPR(impl->descriptors.count(fd) == 1)
+    });
+}
+
+bool IOActionQueue::removeFdAction(int fd) {
+    if (!impl) {
+        return false;
+    }
+    lock_guard<mutex> l(impl->lock);
+    const auto it = impl->descriptors.find(fd);
+    if (it == impl->descriptors.end()) {
+        return false;
+    }
+    it->second->active = false;
+    impl->poller->remove(fd);
+    impl->descriptors.erase(it);
+
+    contract::postconditions({
+        KSS_EXPR(impl->descriptors.count(fd) == 0)
+    });
+    return true;
 }
 
 
 // MARK: RepeatingAction
 
+namespace {
+    // The time of the fixed rate run that follows previous. If that has already
+    // passed, either it is returned (to be run as soon as possible) or, when
+    // skipping overruns, the first run time that is still in the future.
+    time_point_t nextRunTime(const time_point_t& previous,
+                             const nanoseconds& interval,
+                             RepeatingAction::Overrun overrun) noexcept
+    {
+        auto next = previous + interval;
+        const auto currentTime = now<time_point_t>();
+        if (next <= currentTime && overrun == RepeatingAction::Overrun::skip) {
+            next += interval * (((currentTime - next) / interval) + 1);
+        }
+        return next;
+    }
+}
+
 RepeatingAction::~RepeatingAction() noexcept {
-    stopping = true;
-    queue.cancel(identifier);
+    try {
+        if (schedule == Schedule::coalesced) {
+            leaveGroup();
+            return;
+        }
+
+        // A run that is in progress is no longer pending, so cancelling it is not
+        // enough. If it is our own action destroying us, it is told not to touch
+        // this object again, otherwise we must wait for it to finish.
+        unique_lock<mutex> l(lock);
+        stopping = true;
+        queue.cancel(handle);
+        if (running) {
+            if (runner == this_thread::get_id()) {
+                *destroyed = true;
+            }
+            else {
+                finished.wait(l, [this] { return !running; });
+            }
+        }
+    }
+    catch (const exception& e) {
+        // Best we can do is log the error and continue.
+        syslog(LOG_ERR, "[%s] Exception shutting down: %s", __PRETTY_FUNCTION__, e.what());
+    }
 }
 
 void RepeatingAction::init() {
-    identifier = string(kss::util::UUID::generate());
-    queue.addAction(timeInterval, identifier, internalAction);
+    contract::parameters({
+        KSS_EXPR(schedule == Schedule::fixedDelay || timeInterval.count() > 0)
+    });
+
+    if (schedule == Schedule::coalesced) {
+        joinGroup();
+        return;
+    }
+
+    lock_guard<mutex> l(lock);
+    if (schedule == Schedule::fixedRate) {
+        nextTime = now<time_point_t>() + timeInterval;
+        handle = queue.addActionAt(nextTime, [this] { runActionAndRequeue(); });
+    }
+    else {
+        handle = queue.addAction(timeInterval, [this] { runActionAndRequeue(); });
+    }
 
     contract::postconditions({
-        KSS_EXPR(!identifier.empty()),
         KSS_EXPR(stopping == false)
     });
 }
 
+// While the action runs, running tells the destructor that it must wait for us, and
+// destroyed, which lives on our stack, is how it tells us that it was called by the
+// action itself, after which this object must not be touched.
 void RepeatingAction::runActionAndRequeue() {
-    if (!stopping) {
-        action();
-        try {
-            queue.addAction(timeInterval, identifier, internalAction);
+    bool wasDestroyed = false;
+    {
+        lock_guard<mutex> l(lock);
+        if (stopping) {
+            return;
         }
-        catch (const std::system_error& err) {
-            // If the queue is currently paused or full, we pause, then try again.
-            if (err.code() == error_code(EAGAIN, system_category())) {
-                this_thread::sleep_for(timeInterval);
-                internalAction();
+        running = true;
+        runner = this_thread::get_id();
+        destroyed = &wasDestroyed;
+    }
+
+    exception_ptr error;
+    try {
+        action();
+    }
+    catch (...) {
+        error = current_exception();
+    }
+
+    if (!wasDestroyed) {
+        // The destructor may be waiting. Since it must take the lock before it can
+        // return, notifying it here is safe.
+        lock_guard<mutex> l(lock);
+        running = false;
+        destroyed = nullptr;
+        finished.notify_all();
+        if (!stopping && !error) {
+            if (schedule == Schedule::fixedRate) {
+                nextTime = nextRunTime(nextTime, timeInterval, overrun);
+                handle = queue.requeueActionAt(nextTime, [this] { runActionAndRequeue(); });
             }
             else {
+                handle = queue.requeueAction(timeInterval, [this] { runActionAndRequeue(); });
+            }
+        }
+    }
+
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+// Find (or create) the group for our interval and add ourselves to it. If the group
+// we find is retired before we can join it, we try again, which will create a new one.
+void RepeatingAction::joinGroup() {
+    auto& impl = *queue.impl;
+    while (true) {
+        group_ptr_t g;
+        {
+            lock_guard<mutex> l(impl.lock);
+            auto& slot = impl.repeatingGroups[timeInterval.count()];
+            if (!slot) {
+                slot = make_shared<_private::RepeatingGroup>();
+                slot->queue = &queue;
+                slot->interval = timeInterval;
+            }
+            g = slot;
+        }
+
+        lock_guard<recursive_mutex> gl(g->lock);
+        if (g->retired) {
+            continue;
+        }
+
+        g->members.push_back(this);
+        if (!g->handle) {
+            try {
+                g->nextTime = now<time_point_t>() + timeInterval;
+                g->handle = queue.addActionAt(g->nextTime, [g] { runGroup(g); });
+            }
+            catch (...) {
+                g->members.pop_back();
+                retireGroup(*g);
                 throw;
             }
         }
+        group = move(g);
+        return;
+    }
+}
+
+void RepeatingAction::leaveGroup() {
+    lock_guard<recursive_mutex> gl(group->lock);
+    auto it = find(group->members.begin(), group->members.end(), this);
+    if (group->running) {
+        *it = nullptr;
+    }
+    else {
+        group->members.erase(it);
+        if (group->members.empty()) {
+            retireGroup(*group);
+        }
+    }
+}
+
+// Members that join while the group is running will first be run on its next pass.
+void RepeatingAction::runGroup(const group_ptr_t& g) {
+    lock_guard<recursive_mutex> gl(g->lock);
+    if (g->retired) {
+        return;
+    }
+
+    g->running = true;
+    const auto n = g->members.size();
+    for (size_t i = 0; i < n; ++i) {
+        if (auto* member = g->members[i]) {
+            member->action();
+        }
+    }
+    g->running = false;
+
+    g->members.erase(remove(g->members.begin(), g->members.end(), nullptr), g->members.end());
+    if (g->members.empty()) {
+        retireGroup(*g);
+        return;
+    }
+
+    g->nextTime = nextRunTime(g->nextTime, g->interval, Overrun::skip);
+    g->handle = g->queue->requeueActionAt(g->nextTime, [g] { runGroup(g); });
+}
+
+// The group lock must be held by the caller.
+void RepeatingAction::retireGroup(_private::RepeatingGroup& g) {
+    g.retired = true;
+    g.queue->cancel(g.handle);
+
+    auto& impl = *g.queue->impl;
+    lock_guard<mutex> l(impl.lock);
+    const auto it = impl.repeatingGroups.find(g.interval.count());
+    if (it != impl.repeatingGroups.end() && it->second.get() == &g) {
+        impl.repeatingGroups.erase(it);
     }
 }
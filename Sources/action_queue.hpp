@@ -18,18 +18,34 @@
 #ifndef kssthread_action_queue_hpp
 #define kssthread_action_queue_hpp
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <kss/util/all.h>
 
+#include "coroutine.hpp"
+#include "inline_function.hpp"
+#include "latency_histogram.hpp"
+#include "thread_attributes.hpp"
+
 namespace kss { namespace thread {
 
+    namespace _private {
+        class QueueLink;
+        struct RepeatingGroup;
+    }
+
     /*!
      An action queue is used to allow a variety of actions to be queued on a single thread.
      Each action, added by one of the addAction() methods, will be run as soon as possible
@@ -52,6 +68,15 @@ namespace kss { namespace thread {
     public:
         using action_t = std::function<void()>;
 
+        /*!
+         The type used to hold the pending actions. The addAction() methods accept any
+         callable that may be used to construct one of these, including an action_t.
+         Callables of up to 64 bytes, such as a lambda capturing a few pointers or
+         values, are stored without any heap allocation. Since this is move-only,
+         actions may also capture move-only objects.
+         */
+        using inline_action_t = InlineFunction<void(), 64>;
+
         /*!
          Use this in the constructor to specify that you do not want to enforce a limit
          on the number of items in the queue.
@@ -69,13 +94,148 @@ namespace kss { namespace thread {
          */
         static constexpr const char* all = "";
 
+        /*!
+         Selects the data structure used to hold the pending actions.
+
+         - ordered keeps the pending actions in a balanced tree sorted by their target
+           times. Each action runs at (or after) its exact target time, but every add is
+           an O(log n) operation that allocates a tree node.
+         - timingWheel keeps the pending actions in a hierarchical timing wheel with
+           one millisecond ticks, and allocates its entries from a slab. Adds and
+           expiries are O(1) and, once the slab has grown to its working size, do not
+           allocate. The cost is that target times are rounded up to the next tick and
+           actions that fall in the same tick run in the order they were added. This
+           is intended for queues holding large numbers of timeouts.
+         */
+        enum class Storage { ordered, timingWheel };
+
+        /*!
+         Selects how due actions are taken from the queue.
+
+         - single takes one due action at a time, releasing the internal lock (and
+           notifying any waiting threads) after each one.
+         - batched takes every action that is due in a single critical section and
+           runs them back-to-back, only taking the lock again once the whole batch
+           is complete. This is intended for queues where many actions become due at
+           once. Note that once an action has been taken into a batch it can no
+           longer be cancelled, and that in an ActionQueuePool the batch is run by a
+           single worker.
+         */
+        enum class Dispatch { single, batched };
+
+        /*!
+         The priority class of an action. Each class is held in its own lane, and when
+         actions from more than one lane are due, those in the higher lanes are taken
+         first. High priority actions are also taken ahead of the asap actions that were
+         submitted without a lock (see addAction()), hence a burst of ordinary work
+         cannot delay a latency-critical timer by more than the action that is running.
+         Within a lane the actions are taken in the order of their target times.
+         */
+        enum class Priority { low, normal, high };
+
+        /*!
+         The per-action options that may be given to addAction().
+
+         - priority selects the lane of the action.
+         - slack allows the action to run at any time from its target time up to its
+           target time plus the slack. The worker wakes for the action no later than
+           the end of its slack, and runs it earlier if it is already awake for another
+           action. Hence timers that need not be precise can share a single wakeup.
+           Note that with Storage::timingWheel the action is run at the end of its slack,
+           which still allows nearby actions to share a tick.
+         */
+        struct Options {
+            Priority                    priority = Priority::normal;
+            std::chrono::nanoseconds    slack = std::chrono::nanoseconds::zero();
+        };
+
+        /*!
+         A handle refers to a single action that was added to the queue. It may be used
+         to cancel that action in constant time, without needing an identifier. Handles
+         are small and may be freely copied. A handle that is default constructed, or
+         whose action has already begun running or been cancelled, is simply ignored by
+         cancel().
+         */
+        class Handle {
+        public:
+            Handle() = default;
+
+            /*!
+             Returns true if this handle was returned by addAction(). Note that this does
+             not imply that the action is still pending.
+             */
+            explicit operator bool() const noexcept { return (node != nullptr); }
+
+        private:
+            friend class ActionQueue;
+            const void* owner = nullptr;
+            void*       node = nullptr;
+            uint64_t    sequence = 0;
+            bool        intake = false;
+        };
+
+        /*!
+         The timing of a single action, as passed to an action observer. The lateness
+         of the action is startTime - targetTime and its run time is finishTime -
+         startTime. Asap actions without identifiers on a queue without a maxPending
+         limit are submitted without a target time being taken, in which case
+         targetTime is time_point::min().
+         */
+        struct ActionTiming {
+            std::chrono::steady_clock::time_point targetTime;
+            std::chrono::steady_clock::time_point startTime;
+            std::chrono::steady_clock::time_point finishTime;
+        };
+
+        using action_observer_t = std::function<void(const ActionTiming&)>;
+
+        /*!
+         A snapshot of the queue statistics, as returned by statistics(). The counts
+         are cumulative from the construction of the queue, or from the most recent
+         call to resetStatistics().
+
+         - pending and running are the number of actions currently waiting and
+           currently being run.
+         - peakPending is the largest number of pending actions that has been seen.
+         - added, completed, and cancelled count the actions that have been added,
+           run to completion, and cancelled before they were run.
+         - rejected counts the additions that failed with EAGAIN.
+         - lateness holds the times between the actions becoming due and starting,
+           for the actions that have a target time (see ActionTiming).
+         - runTime holds the times taken to run the actions.
+         */
+        struct Statistics {
+            size_t              pending = 0;
+            size_t              running = 0;
+            size_t              peakPending = 0;
+            uint64_t            added = 0;
+            uint64_t            completed = 0;
+            uint64_t            cancelled = 0;
+            uint64_t            rejected = 0;
+            LatencyHistogram    lateness;
+            LatencyHistogram    runTime;
+        };
 
         /*!
          Construct the queue.
          @param maxPending puts a maximum limit on the number of pending actions.
+         @param storage selects how the pending actions are stored.
+         @param dispatch selects how due actions are taken from the queue.
+         @param attributes are applied to the thread that runs the actions.
+         @throws any exception that ThreadAttributes::apply() may throw
          */
-        explicit ActionQueue(size_t maxPending = noLimit);
+        explicit ActionQueue(size_t maxPending = noLimit,
+                             Storage storage = Storage::ordered,
+                             Dispatch dispatch = Dispatch::single,
+                             const ThreadAttributes& attributes = ThreadAttributes());
 
+        /*!
+         A queue may be moved while it is running. Move assignment first shuts down
+         the queue being assigned to, as its destructor would. A moved-from queue has
+         no thread: it may be destroyed or assigned to, actions added to it are
+         discarded (as they are while a queue is being destroyed), and its other
+         methods do nothing.
+         */
         ActionQueue(ActionQueue&&);
         ActionQueue& operator=(ActionQueue&&) noexcept;
         ~ActionQueue() noexcept;
@@ -87,11 +247,14 @@ namespace kss { namespace thread {
          Add an action to the queue. The action will be performed as soon as possible after
          the given delay.
          @param delay The amount of time before the action will be performed. Note that
-            Duration must conform to the std::chrono::duration API.
+            Duration must conform to the std::chrono::duration API. The delay is kept
+            at the resolution of std::chrono::steady_clock (typically in nanoseconds),
+            although Storage::timingWheel will round it up to the next millisecond.
          @param identifier If not empty this identifier can be used to cancel the action
             before it is performed. Note that it need not be unique. For example, you
             can give a set of actions the same identifier and then cancel them as a block.
          @param action The action to be performed.
+         @return a handle that may be used to cancel this specific action.
          @throws std::invalid_argument if the delay is a negative value
          @throws std::system_error with a value of EAGAIN if the action queue
             already has maxPending items, or if we are currently waiting for
@@ -100,43 +263,57 @@ namespace kss { namespace thread {
          @throws any exceptions that a condition_variable, a map, or a
             checked_duration_cast may throw.
          */
-        template <class Duration>
-        inline void addAction(const Duration& delay,
-                              const std::string& identifier,
-                              const action_t& action)
+        template <class Duration, class Fn>
+        inline Handle addAction(const Duration& delay,
+                                const std::string& identifier,
+                                Fn&& action)
         {
             using util::time::checkedDurationCast;
-            addActionAfter(checkedDurationCast<std::chrono::milliseconds>(delay),
-                           identifier, action);
+            return addActionAfter(checkedDurationCast<std::chrono::nanoseconds>(delay),
+                                  identifier, inline_action_t(std::forward<Fn>(action)));
         }
 
-        template <class Duration>
-        inline void addAction(const Duration& delay,
-                              const std::string& identifier,
-                              action_t&& action)
-        {
+        template <class Duration, class Fn>
+        inline Handle addAction(const Duration& delay, Fn&& action) {
             using util::time::checkedDurationCast;
-            addActionAfter(checkedDurationCast<std::chrono::milliseconds>(delay),
-                           identifier, move(action));
+            return addActionAfter(checkedDurationCast<std::chrono::nanoseconds>(delay),
+                                  "", inline_action_t(std::forward<Fn>(action)));
         }
 
-        template <class Duration>
-        inline void addAction(const Duration& delay, const action_t& action) {
+        /*!
+         Add an action to the queue, with the given options. This is otherwise the same
+         as the addAction() above.
+         @code
+         queue.addAction({ActionQueue::Priority::high}, 5ms, [] { ... });
+         queue.addAction({ActionQueue::Priority::low, 50ms}, 1s, "flush", [] { ... });
+         @endcode
+         @throws std::invalid_argument if the delay or the slack is a negative value
+         @throws std::system_error with a value of EAGAIN as for addAction()
+         @throws any exceptions that a condition_variable, a map, or a
+            checked_duration_cast may throw.
+         */
+        template <class Duration, class Fn>
+        inline Handle addAction(const Options& options,
+                                const Duration& delay,
+                                const std::string& identifier,
+                                Fn&& action)
+        {
             using util::time::checkedDurationCast;
-            addActionAfter(checkedDurationCast<std::chrono::milliseconds>(delay),
-                           "", action);
+            return addActionWithOptions(options, checkedDurationCast<std::chrono::nanoseconds>(delay),
+                                        identifier, inline_action_t(std::forward<Fn>(action)));
         }
 
-        template <class Duration>
-        inline void addAction(const Duration& delay, action_t&& action) {
+        template <class Duration, class Fn>
+        inline Handle addAction(const Options& options, const Duration& delay, Fn&& action) {
             using util::time::checkedDurationCast;
-            addActionAfter(checkedDurationCast<std::chrono::milliseconds>(delay),
-                           "", move(action));
+            return addActionWithOptions(options, checkedDurationCast<std::chrono::nanoseconds>(delay),
+                                        "", inline_action_t(std::forward<Fn>(action)));
         }
 
         /*!
          Add an action to the queue. The action will be performed as soon as possible.
          (I.e. It will be given a delay of 0.)
+         @return a handle that may be used to cancel the action.
          @throws std::invalid_argument if the delay is a negative value
          @throws std::system_error with a value of EAGAIN if the action queue
             already has maxPending items, or if we are currently waiting for
@@ -144,14 +321,217 @@ namespace kss { namespace thread {
             the caller wait a short time, then try again.
          @throws any exceptions that a condition_variable or a map may throw.
          */
-        inline void addAction(const action_t& action) {
-            addActionAfter(asap, "", action);
+        template <class Fn>
+        inline Handle addAction(Fn&& action) {
+            return addActionAfter(asap, "", inline_action_t(std::forward<Fn>(action)));
         }
 
-        inline void addAction(action_t&& action) {
-            addActionAfter(asap, "", move(action));
+        /*!
+         Add an action to the queue, waiting while the queue already has maxPending
+         actions or wait() is in progress. This is the same as addAction() except that
+         instead of throwing a system_error with EAGAIN, the calling thread is parked
+         until there is room for the action. The delay is measured from the time the
+         action is actually added.
+
+         Note that this must not be called from one of the queue's own actions (when
+         the waiting worker could be the one that would make room for it).
+         @return a handle that may be used to cancel the action. It will test as false
+            if the queue was destroyed while we were waiting.
+         @throws std::invalid_argument if the delay is a negative value
+         @throws any exceptions that a condition_variable, a map, or a
+            checked_duration_cast may throw.
+         */
+        template <class Duration, class Fn>
+        inline Handle addActionWait(const Duration& delay,
+                                    const std::string& identifier,
+                                    Fn&& action)
+        {
+            using util::time::checkedDurationCast;
+            return addActionWhenRoom(checkedDurationCast<std::chrono::nanoseconds>(delay), identifier,
+                                     inline_action_t(std::forward<Fn>(action)), nullptr);
+        }
+
+        template <class Duration, class Fn>
+        inline Handle addActionWait(const Duration& delay, Fn&& action) {
+            using util::time::checkedDurationCast;
+            return addActionWhenRoom(checkedDurationCast<std::chrono::nanoseconds>(delay), "",
+                                     inline_action_t(std::forward<Fn>(action)), nullptr);
+        }
+
+        template <class Fn>
+        inline Handle addActionWait(Fn&& action) {
+            return addActionWhenRoom(asap, "", inline_action_t(std::forward<Fn>(action)), nullptr);
+        }
+
+        /*!
+         Add an action to the queue, waiting up to the given timeout for there to be
+         room for it. See addActionWait() for the details.
+         @param timeout The maximum amount of time to wait for room in the queue. Note
+            that Timeout must conform to the std::chrono::duration API.
+         @return a handle that may be used to cancel the action. It will test as false
+            if the action was not added, i.e. if the timeout was reached or the queue was
+            destroyed while we were waiting.
+         @throws std::invalid_argument if the delay is a negative value
+         @throws any exceptions that a condition_variable, a map, or a
+            checked_duration_cast may throw.
+         */
+        template <class Timeout, class Duration, class Fn>
+        inline Handle addActionFor(const Timeout& timeout,
+                                   const Duration& delay,
+                                   const std::string& identifier,
+                                   Fn&& action)
+        {
+            using util::time::checkedDurationCast;
+            const auto to = checkedDurationCast<std::chrono::nanoseconds>(timeout);
+            return addActionWhenRoom(checkedDurationCast<std::chrono::nanoseconds>(delay), identifier,
+                                     inline_action_t(std::forward<Fn>(action)), &to);
+        }
+
+        template <class Timeout, class Duration, class Fn>
+        inline Handle addActionFor(const Timeout& timeout, const Duration& delay, Fn&& action) {
+            return addActionFor(timeout, delay, "", std::forward<Fn>(action));
+        }
+
+        template <class Timeout, class Fn>
+        inline Handle addActionFor(const Timeout& timeout, Fn&& action) {
+            return addActionFor(timeout, asap, "", std::forward<Fn>(action));
+        }
+
+        /*!
+         Add an action to the queue to be performed as soon as possible after the given
+         steady clock time. If that time has already passed, the action will be performed
+         as soon as possible. Unlike addAction(), this allows a series of actions to be
+         scheduled against fixed deadlines without the drift that accumulates when each
+         delay is computed from the current time.
+         @param targetTime The time at or after which the action will be performed. If
+            Duration is finer than the steady_clock duration, it is rounded up.
+         @param identifier If not empty this identifier can be used to cancel the action
+            before it is performed.
+         @param action The action to be performed.
+         @return a handle that may be used to cancel this specific action.
+         @throws std::system_error with a value of EAGAIN if the action queue
+            already has maxPending items, or if we are currently waiting for
+            pending actions to complete.
+         @throws any exceptions that a condition_variable or a map may throw.
+         */
+        template <class Duration, class Fn>
+        inline Handle addActionAt(const std::chrono::time_point<std::chrono::steady_clock, Duration>& targetTime,
+                                  const std::string& identifier,
+                                  Fn&& action)
+        {
+            return addActionAtTime(toClockTime(targetTime), identifier,
+                                   inline_action_t(std::forward<Fn>(action)));
+        }
+
+        template <class Duration, class Fn>
+        inline Handle addActionAt(const std::chrono::time_point<std::chrono::steady_clock, Duration>& targetTime,
+                                  Fn&& action)
+        {
+            return addActionAtTime(toClockTime(targetTime), "",
+                                   inline_action_t(std::forward<Fn>(action)));
         }
 
+        /*!
+         Add a number of actions to the queue in a single operation, all with the same
+         delay and identifier. This takes the internal lock, and notifies the worker(s),
+         only once regardless of the number of actions. Either all of the actions are
+         added, or none of them are.
+         @param delay The amount of time before the actions will be performed. Note that
+            Duration must conform to the std::chrono::duration API.
+         @param identifier If not empty this identifier can be used to cancel the actions
+            as a block.
+         @param first, last The range of actions to add. Each element must be a callable
+            that may be used to construct an inline_action_t. The elements are copied.
+         @throws std::invalid_argument if the delay is a negative value
+         @throws std::system_error with a value of EAGAIN if adding the actions would
+            exceed maxPending, or if we are currently waiting for pending actions to
+            complete.
+         @throws any exceptions that a condition_variable, a map, or a
+            checked_duration_cast may throw.
+         */
+        template <class Duration, class InputIt>
+        inline void addActions(const Duration& delay,
+                               const std::string& identifier,
+                               InputIt first,
+                               InputIt last)
+        {
+            using util::time::checkedDurationCast;
+            std::vector<inline_action_t> actions;
+            for (; first != last; ++first) {
+                actions.emplace_back(*first);
+            }
+            addActionsAfter(checkedDurationCast<std::chrono::nanoseconds>(delay),
+                            identifier, std::move(actions));
+        }
+
+        template <class Duration, class InputIt>
+        inline void addActions(const Duration& delay, InputIt first, InputIt last) {
+            addActions(delay, "", first, last);
+        }
+
+        template <class InputIt>
+        inline void addActions(InputIt first, InputIt last) {
+            addActions(asap, "", first, last);
+        }
+
+#if defined(KSS_THREAD_HAVE_COROUTINES)
+        /*!
+         The awaitable returned by after() and schedule(). Awaiting it suspends the
+         coroutine and adds an action that will resume it. Any exception that adding
+         the action throws (e.g. a system_error with EAGAIN) is thrown from the
+         co_await expression, in which case the coroutine was never suspended.
+         */
+        class Awaiter {
+        public:
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                // Avoid the lock-free intake, which touches the queue after publishing
+                // the action, by which time the coroutine may have finished and its
+                // owner destroyed the queue.
+                inline_action_t action([h] { h.resume(); });
+                if (delay.count() == 0) {
+                    queue.addActionAtTime(std::chrono::steady_clock::now(), "", std::move(action));
+                }
+                else {
+                    queue.addActionAfter(delay, "", std::move(action));
+                }
+            }
+            void await_resume() const noexcept {}
+
+        private:
+            friend class ActionQueue;
+            Awaiter(ActionQueue& q, const std::chrono::nanoseconds& d) noexcept : queue(q), delay(d) {}
+
+            ActionQueue&                queue;
+            std::chrono::nanoseconds    delay;
+        };
+
+        /*!
+         Returns an awaitable that resumes the coroutine on the queue's worker(s) as
+         soon as possible after the given delay. Since the coroutine is resumed by an
+         action it is serialized with the queue's other actions, and suspending costs
+         a single pending action rather than a thread.
+         @code
+         co_await queue.after(5ms);
+         @endcode
+         @throws std::invalid_argument (from the co_await) if the delay is negative
+         */
+        template <class Duration>
+        inline Awaiter after(const Duration& delay) {
+            using util::time::checkedDurationCast;
+            return Awaiter(*this, checkedDurationCast<std::chrono::nanoseconds>(delay));
+        }
+
+        /*!
+         Returns an awaitable that resumes the coroutine on the queue's worker(s) as
+         soon as possible. This is used to move a coroutine on to the queue, e.g. before
+         it accesses a resource that the queue serializes.
+         */
+        inline Awaiter schedule() noexcept {
+            return Awaiter(*this, std::chrono::nanoseconds::zero());
+        }
+#endif
+
         /*!
          Cancel any actions that match the given identifier. If the identifier is all
          or anything else that is an empty string, then all pending actions, even those
@@ -165,24 +545,255 @@ namespace kss { namespace thread {
          */
         size_t cancel(const std::string& identifier = all);
 
+        /*!
+         Cancel the action referred to by the handle. This takes constant time regardless
+         of the number of pending actions. If the action has already started, has already
+         been cancelled, or the handle was not returned by this queue, then nothing is done.
+
+         @param handle The handle returned when the action was added.
+         @return 1 if the action was cancelled, 0 otherwise.
+         */
+        size_t cancel(const Handle& handle);
+
         /*!
          Wait until all pending actions have completed. Note that no further actions
          may be added while waiting. But they may be added as soon as wait()
-         has returned.
+         has returned. In a stoppable section a stop request wakes the waiting thread,
+         which then throws Stopped without waiting for the actions.
+         @throws kss::thread::Stopped if a stop is requested in a stoppable section
          @throws any exceptions that a condition_variable or a map may throw
          */
         void wait();
 
+        /*!
+         Returns a snapshot of the queue statistics. The statistics are maintained
+         while the internal lock is already held, hence keeping them adds very little
+         to the cost of adding or running an action, and this may be polled as often
+         as is useful.
+         */
+        Statistics statistics() const;
+
+        /*!
+         Reset the cumulative counts and the histograms. The peak is reset to the
+         current number of pending actions.
+         */
+        void resetStatistics();
+
+        /*!
+         Set (or, given an empty function, remove) a function that is called with the
+         timing of each action after it has run. The observer is called by the worker
+         that ran the action, without holding any locks, hence it should be quick and
+         must not block. Exceptions thrown by the observer are logged and ignored.
+         @throws any exception that allocating the observer may throw
+         */
+        void setActionObserver(action_observer_t observer);
+
+    protected:
+        /*!
+         Construct a queue whose actions are run by the given number of worker threads.
+         This is used by ActionQueuePool and, with pollDescriptors set, by IOActionQueue.
+         @throws std::invalid_argument if numberOfWorkers is 0, or if pollDescriptors
+            is set with more than one worker
+         @throws std::system_error if pollDescriptors is set and the poller could not
+            be created
+         @throws any exception that ThreadAttributes::apply() may throw
+         */
+        ActionQueue(size_t maxPending,
+                    Storage storage,
+                    Dispatch dispatch,
+                    const ThreadAttributes& attributes,
+                    unsigned numberOfWorkers,
+                    bool serializeIdentifiers,
+                    bool pollDescriptors = false);
+
     private:
+        friend class IOActionQueue;
+        friend class RepeatingAction;
+        friend class _private::QueueLink;
+
         struct Impl;
-        std::unique_ptr<Impl> impl;
-
-        void addActionAfter(const std::chrono::milliseconds& delay,
-                            const std::string& identifier,
-                            const action_t& action);
-        void addActionAfter(const std::chrono::milliseconds& delay,
-                            const std::string& identifier,
-                            action_t&& action);
+        std::unique_ptr<Impl>                   impl;
+        std::shared_ptr<_private::QueueLink>    link;
+
+        void shutdown() noexcept;
+
+        Handle addActionWhenRoom(const std::chrono::nanoseconds& delay,
+                                 const std::string& identifier,
+                                 inline_action_t&& action,
+                                 const std::chrono::nanoseconds* timeout);
+        Handle requeueAction(const std::chrono::nanoseconds& delay, inline_action_t&& action);
+        Handle requeueActionAt(const std::chrono::steady_clock::time_point& targetTime,
+                               inline_action_t&& action);
+        Handle addActionAfter(const std::chrono::nanoseconds& delay,
+                              const std::string& identifier,
+                              inline_action_t&& action);
+        Handle addActionWithOptions(const Options& options,
+                                    const std::chrono::nanoseconds& delay,
+                                    const std::string& identifier,
+                                    inline_action_t&& action);
+        void addActionsAfter(const std::chrono::nanoseconds& delay,
+                             const std::string& identifier,
+                             std::vector<inline_action_t>&& actions);
+        Handle addActionAtTime(const std::chrono::steady_clock::time_point& targetTime,
+                               const std::string& identifier,
+                               inline_action_t&& action);
+
+        // Round up so that the action is never performed before the requested time.
+        template <class Duration>
+        static std::chrono::steady_clock::time_point
+        toClockTime(const std::chrono::time_point<std::chrono::steady_clock, Duration>& tp) {
+            using namespace std::chrono;
+            auto ret = time_point_cast<steady_clock::duration>(tp);
+            if (ret < tp) {
+                ret += steady_clock::duration(1);
+            }
+            return ret;
+        }
+    };
+
+    namespace _private {
+        /*!
+         A link to an ActionQueue that the queue clears when it is destroyed. This allows
+         an action to be added at some later time, by a thread that cannot know whether
+         the queue still exists.
+         */
+        class QueueLink {
+        public:
+            explicit QueueLink(ActionQueue* q) noexcept : queue(q) {}
+
+            // Returns the link of the queue.
+            static std::shared_ptr<QueueLink> of(ActionQueue& q) noexcept { return q.link; }
+
+            // Add an action to the queue, returning false if the queue no longer exists.
+            template <class Fn>
+            bool addAction(Fn&& action) {
+                std::lock_guard<std::mutex> l(lock);
+                if (!queue) {
+                    return false;
+                }
+                queue->addAction(std::forward<Fn>(action));
+                return true;
+            }
+
+        private:
+            friend class kss::thread::ActionQueue;
+            std::mutex      lock;
+            ActionQueue*    queue;
+        };
+    }
+
+
+    /*!
+     An action queue pool is an ActionQueue whose due actions are run by a number of
+     worker threads instead of a single one. It has the same timing, identifier, and
+     cancellation API, but a slow action will no longer delay the other actions that
+     are due behind it. This makes it suitable for replacing a combination of action
+     queues and hand-written thread pools.
+
+     Note that unlike an ActionQueue this does not, by default, serialize the actions.
+     If you need actions that share an identifier to never run concurrently, use
+     IdentifierPolicy::serialized. In that case actions with the same identifier are
+     run one at a time, in the order they become due, while actions with different
+     identifiers (or without an identifier) still run in parallel.
+
+     Since this is an ActionQueue, it may also be used with a RepeatingAction.
+     */
+    class ActionQueuePool : public ActionQueue {
+    public:
+        enum class IdentifierPolicy { concurrent, serialized };
+
+        /*!
+         Construct the pool.
+         @param numberOfWorkers the number of threads used to run the actions. If this
+            is 0 (which hardware_concurrency() may return) a single worker is used.
+         @param maxPending puts a maximum limit on the number of pending actions.
+         @param storage selects how the pending actions are stored.
+         @param policy determines if actions sharing an identifier may run concurrently.
+         @param dispatch selects how due actions are taken from the queue.
+         @param attributes are applied to each of the worker threads.
+         @throws any exception that ThreadAttributes::apply() may throw
+         */
+        explicit ActionQueuePool(unsigned numberOfWorkers = std::thread::hardware_concurrency(),
+                                 size_t maxPending = noLimit,
+                                 Storage storage = Storage::ordered,
+                                 IdentifierPolicy policy = IdentifierPolicy::concurrent,
+                                 Dispatch dispatch = Dispatch::single,
+                                 const ThreadAttributes& attributes = ThreadAttributes())
+        : ActionQueue(maxPending, storage, dispatch, attributes, std::max(numberOfWorkers, 1U),
+                      policy == IdentifierPolicy::serialized)
+        {}
+    };
+
+
+    /*!
+     An I/O action queue is an ActionQueue whose thread also watches a set of file
+     descriptors. Instead of sleeping on a condition variable until the next action is
+     due, the thread waits in epoll_wait (kqueue on macOS and the BSDs) with the next
+     target time as its timeout, and cross-thread additions wake it through an eventfd
+     (or an EVFILT_USER event). When a descriptor becomes ready its action is run on the
+     queue thread, serialized with the timed actions, which allows a single thread to
+     replace a reactor thread plus an action queue and the handoffs between them.
+
+     The descriptors are level triggered, hence a descriptor's action will be run
+     again, on each pass through the queue, for as long as the descriptor remains
+     ready. The action should therefore consume the available data (or remove the
+     descriptor) each time it is run. Descriptors are checked between due actions at
+     least once in every 64 actions, so that a steady stream of timed actions cannot
+     starve them.
+
+     Note that the timeout passed to the poller has a resolution of one millisecond on
+     Linux, hence timed actions may run up to a millisecond later than they would on
+     an ActionQueue.
+     */
+    class IOActionQueue : public ActionQueue {
+    public:
+        /*!
+         The action run when a descriptor is ready. It is given the descriptor and the
+         readiness events (a combination of readable, writable, hangup, and error).
+         */
+        using fd_action_t = std::function<void(int fd, unsigned events)>;
+
+        static constexpr unsigned readable = 1;
+        static constexpr unsigned writable = 2;
+        static constexpr unsigned hangup = 4;
+        static constexpr unsigned error = 8;
+
+        /*!
+         Construct the queue. The parameters are as for ActionQueue.
+         @throws std::system_error if the poller could not be created
+         @throws any exception that ThreadAttributes::apply() may throw
+         */
+        explicit IOActionQueue(size_t maxPending = noLimit,
+                               Storage storage = Storage::ordered,
+                               Dispatch dispatch = Dispatch::single,
+                               const ThreadAttributes& attributes = ThreadAttributes())
+        : ActionQueue(maxPending, storage, dispatch, attributes, 1, false, true)
+        {}
+
+        /*!
+         Start watching a file descriptor. Each time the descriptor is ready for one of
+         the given events, the action will be run on the queue thread. Hangups and
+         errors are always reported, even if they were not requested. The descriptor
+         remains registered until removeFdAction() is called, which must be done before
+         the descriptor is closed. Registered descriptors are not pending actions, hence
+         they are not affected by cancel() and do not prevent wait() from returning.
+         @param fd the descriptor to watch.
+         @param events a non-empty combination of readable and writable.
+         @param action the action to run when the descriptor is ready.
+         @throws std::invalid_argument if fd is negative, events does not contain
+            readable or writable, or the action is empty
+         @throws std::system_error with a value of EEXIST if the descriptor is already
+            registered, or with the error reported by the poller
+         */
+        void addFdAction(int fd, unsigned events, fd_action_t action);
+
+        /*!
+         Stop watching a file descriptor. Once this returns the descriptor's action will
+         not be started again, although if it is called from another thread the action
+         may still be in progress.
+         @return true if the descriptor was registered, false otherwise.
+         */
+        bool removeFdAction(int fd);
     };
 
 
@@ -192,17 +803,56 @@ namespace kss { namespace thread {
      and it will repeatedly add the action with the given interval to the queue. It will
      continue to do this until it goes out of scope.
 
-     Note that it is important that the ActionQueue remain in scope for at least as long
-     as the RepeatingAction is in scope.
+     Note that it is important that the ActionQueue remain in scope, and not be moved,
+     for at least as long as the RepeatingAction is in scope.
+
+     The schedule determines how the next run is timed.
+
+     - fixedDelay adds the action back to the queue, timeInterval after the previous run
+       has finished. The time taken to run the action hence accumulates as drift.
+     - fixedRate schedules the runs relative to the original start time, i.e. the nth
+       run is due at start + n * interval regardless of how long the previous runs
+       took. If a run finishes after the next one was due, the overrun policy decides
+       if the missed runs are skipped (the next run is the first one still in the
+       future) or caught up (the missed runs are made, back-to-back, as soon as possible).
+     - coalesced is fixedRate, except that all the coalesced repeating actions on a
+       queue that share an interval are run, in the order they were created, by a single
+       pending action. This is intended for large numbers of identical timers, such as
+       heartbeats, which then cost one timer insert and one wakeup per interval instead
+       of one each. Since the actions share the timing of the group, the first run of a
+       new action may come sooner than one interval after its creation. Missed runs are
+       always skipped, and a slow action delays the others in its group.
+
+     Each time the action has run it is added back to the queue in the place it has
+     just vacated, without regard to maxPending or to a wait() in progress. Hence a
+     full queue cannot cause the worker to block or sleep on its behalf, but a queue
+     may briefly exceed maxPending by the number of its repeating actions, and wait()
+     will not return while a RepeatingAction exists. The initial add, made by the
+     constructor, is an ordinary add and may throw if the queue is full.
+
+     If the repeating action is destroyed while its action is running on another thread,
+     the destructor waits for that run to finish. It may also be destroyed by its own
+     action, in which case the action is not run again.
      */
     class RepeatingAction {
     public:
+        enum class Schedule { fixedDelay, fixedRate, coalesced };
+        enum class Overrun { skip, catchUp };
+
+        /*!
+         Construct the repeating action and add its first run to the queue.
+         @throws std::invalid_argument if the schedule is fixedRate or coalesced and the
+            interval is not positive
+         @throws any exception that adding the action may throw
+         */
         template <class Duration>
         RepeatingAction(const Duration& interval,
                         ActionQueue& q,
-                        const ActionQueue::action_t& act)
-        : timeInterval(kss::util::time::checkedDurationCast<std::chrono::milliseconds>(interval)),
-        queue(q), action(act)
+                        const ActionQueue::action_t& act,
+                        Schedule sched = Schedule::fixedDelay,
+                        Overrun ovr = Overrun::skip)
+        : timeInterval(kss::util::time::checkedDurationCast<std::chrono::nanoseconds>(interval)),
+        queue(q), schedule(sched), overrun(ovr), action(act)
         {
             init();
         }
@@ -210,9 +860,11 @@ namespace kss { namespace thread {
         template <class Duration>
         RepeatingAction(const Duration& interval,
                         ActionQueue& q,
-                        ActionQueue::action_t&& act)
-        : timeInterval(kss::util::time::checkedDurationCast<std::chrono::milliseconds>(interval)),
-        queue(q), action(move(act))
+                        ActionQueue::action_t&& act,
+                        Schedule sched = Schedule::fixedDelay,
+                        Overrun ovr = Overrun::skip)
+        : timeInterval(kss::util::time::checkedDurationCast<std::chrono::nanoseconds>(interval)),
+        queue(q), schedule(sched), overrun(ovr), action(move(act))
         {
             init();
         }
@@ -225,15 +877,29 @@ namespace kss { namespace thread {
         RepeatingAction& operator=(RepeatingAction&&) = delete;
 
     private:
-        std::chrono::milliseconds   timeInterval;
-        ActionQueue&                queue;
-        std::string                 identifier;
-        std::atomic<bool>           stopping { false };
-        ActionQueue::action_t       action;
-        ActionQueue::action_t       internalAction = [this] { runActionAndRequeue(); };
+        using group_ptr_t = std::shared_ptr<_private::RepeatingGroup>;
+
+        std::chrono::nanoseconds                timeInterval;
+        ActionQueue&                            queue;
+        Schedule                                schedule;
+        Overrun                                 overrun;
+        std::mutex                              lock;
+        std::condition_variable                 finished;
+        ActionQueue::Handle                     handle;
+        bool                                    stopping = false;
+        bool                                    running = false;
+        std::thread::id                         runner;
+        bool*                                   destroyed = nullptr;
+        std::chrono::steady_clock::time_point   nextTime;
+        group_ptr_t                             group;
+        ActionQueue::action_t                   action;
 
         void init();
         void runActionAndRequeue();
+        void joinGroup();
+        void leaveGroup();
+        static void runGroup(const group_ptr_t& g);
+        static void retireGroup(_private::RepeatingGroup& g);
     };
 }}
 
@@ -16,48 +16,84 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <exception>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <mutex>
+#include <new>
 #include <thread>
+#include <type_traits>
+#include <utility>
 
 #include <kss/contract/all.h>
 
+#include "atomic_wait.hpp"
+#include "coroutine.hpp"
+#include "future.hpp"
+#include "inline_function.hpp"
 #include "lock.hpp"
+#include "thread_attributes.hpp"
 
 namespace kss { namespace thread {
 
-    namespace _private {
-
-        template <class T>
-        inline bool isCallable(const std::packaged_task<T()>& fn) {
-            return fn.valid();
-        }
-    }
-
     /*!
      An action thread is a thread that will wait until it is given an action to run, then
-     will run it asynchronously, returning an appropriate future.
+     will run it asynchronously.
+
+     There are two ways to use it. The async() method returns a std::future<T>, much like
+     std::async. The run() and get() methods instead keep the result in a slot that is
+     reused from one call to the next, avoiding the packaged_task, the std::bind, and the
+     shared state allocation that a future requires. The latter is intended for tight
+     loops that repeatedly hand small actions to the same thread.
+
+     In both cases the hand-off is "spin-then-park". After completing an action the
+     worker spins for a short time waiting for the next one, and only then sleeps on a
+     condition variable. Likewise get() and wait() spin for a short time before sleeping.
+     The condition variable is only notified if the other side is actually asleep.
+
+     The lock used while parking may be any Lockable type, such as AdaptiveMutex. Types
+     other than std::mutex are waited on with a std::condition_variable_any.
      */
-    template <class T>
+    template <class T, class Lockable = std::mutex>
     class ActionThread {
     public:
         ActionThread() = default;
 
-        ~ActionThread() noexcept {
-            locked(lock, [this] { stopping = true; });
-            cv.notify_all();
-            if (workerThread.joinable()) {
-                workerThread.join();
+        /*!
+         Construct the thread and apply the given attributes to it.
+         @throws any exception that ThreadAttributes::apply() may throw
+         */
+        explicit ActionThread(const ThreadAttributes& attributes) {
+            try {
+                attributes.apply(workerThread);
+            }
+            catch (...) {
+                shutdown();
+                throw;
             }
         }
 
+        ~ActionThread() noexcept {
+            shutdown();
+        }
+
         ActionThread(ActionThread&&) = default;
         ActionThread& operator=(ActionThread&&) = default;
 
         ActionThread(const ActionThread&) = delete;
         ActionThread& operator=(const ActionThread&) = delete;
 
+        /*!
+         Apply the given attributes to the thread. This is normally done via the
+         constructor, but may also be done later (e.g. for ActionThreads held in a
+         container).
+         @throws any exception that ThreadAttributes::apply() may throw
+         */
+        void applyAttributes(const ThreadAttributes& attributes) {
+            attributes.apply(workerThread);
+        }
+
         /*!
          Wake up the thread and start an action. This is not unlike std::async, except that
          it is much more efficient since it does not create/destroy a new thread for each
@@ -70,60 +106,247 @@ namespace kss { namespace thread {
          */
         template <class Fn, class... Args>
         std::future<T> async(Fn&& fn, Args&&... args) {
-            std::packaged_task<T()> pt(std::bind(fn, args...));
+            std::packaged_task<T()> pt([this, f = std::bind(fn, args...)]() mutable -> T {
+                IdleOnExit idle(*this);
+                return f();
+            });
             auto fut = pt.get_future();
-            startTask(std::move(pt));
+            startTask([pt = std::move(pt)]() mutable { pt(); });
+            return fut;
+        }
+
+        /*!
+         Wake up the thread and start an action, returning a kss::thread::Future for its
+         result. Unlike async(), the result may be consumed by a continuation (see
+         Future::then()) that this thread runs as soon as the action completes, hence
+         no other thread need wait for it. The same restriction as for async() applies:
+         the action must have completed before the next one is started.
+         @throws std::bad_alloc if the future's state could not be allocated
+         */
+        template <class Fn>
+        Future<T> submit(Fn&& fn) {
+            Promise<T> p;
+            auto fut = p.getFuture();
+            startTask([this, p = std::move(p), fn = typename std::decay<Fn>::type(std::forward<Fn>(fn))]() mutable {
+                p.setWith([this, &fn]() -> T {
+                    IdleOnExit idle(*this);
+                    return fn();
+                });
+            });
             return fut;
         }
 
+        /*!
+         Wake up the thread and start an action, without creating a future. The result
+         (or the exception) of the action is kept by the ActionThread, and is obtained by
+         calling get(). Callables of up to 64 bytes (e.g. a lambda capturing a few
+         references) are held without any heap allocation.
+
+         Note that it is an error to call this before the previous action has completed.
+         Doing so will cause (in debug mode) a condition to fail. Call get() or wait()
+         before calling this method again.
+         */
+        template <class Fn>
+        void run(Fn&& fn) {
+            complete.store(false, std::memory_order_relaxed);
+            startTask([this, fn = std::forward<Fn>(fn)]() mutable {
+                auto call = [this, &fn]() -> T {
+                    IdleOnExit idle(*this);
+                    return fn();
+                };
+                result.set(call);
+                notifyComplete();
+            });
+        }
+
+        /*!
+         Block until the action started by run() has completed. This may be called more
+         than once, but only between a call to run() and the following call to get().
+         */
+        void wait() {
+            for (unsigned i = 0, n = _private::spinIterations(); i < n; ++i) {
+                if (complete.load(std::memory_order_acquire)) {
+                    return;
+                }
+                _private::cpuRelax();
+            }
+
+            std::unique_lock<Lockable> l(lock);
+            waiterParked.store(true);
+            doneCv.wait(l, [this] { return complete.load(); });
+            waiterParked.store(false, std::memory_order_relaxed);
+        }
+
+        /*!
+         Block until the action started by run() has completed, and return its result.
+         This may only be called once for each call to run().
+         @throws any exception that the action threw
+         */
+        T get() {
+            wait();
+            return result.take();
+        }
+
+#if defined(KSS_THREAD_HAVE_COROUTINES)
+        /*!
+         The awaitable returned by awaitable(). The result, or the exception, of the
+         action is held in the awaitable itself (i.e. in the coroutine frame) rather
+         than in a future.
+         */
+        template <class Fn>
+        class Awaiter {
+        public:
+            Awaiter(const Awaiter&) = delete;
+            Awaiter& operator=(const Awaiter&) = delete;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                thread.startTaskLocked([this, h] {
+                    auto call = [this]() -> T {
+                        IdleOnExit idle(thread);
+                        return fn();
+                    };
+                    result.set(call);
+                    h.resume();
+                });
+            }
+            T await_resume() { return result.take(); }
+
+        private:
+            friend class ActionThread;
+            template <class F>
+            Awaiter(ActionThread& th, F&& f) : thread(th), fn(std::forward<F>(f)) {}
+
+            ActionThread&               thread;
+            Fn                          fn;
+            _private::ResultSlot<T>     result;
+        };
+
+        /*!
+         Returns an awaitable that runs the action on this thread and resumes the
+         coroutine with its result (or throws its exception) once it completes. No
+         thread is blocked while waiting. Note that the coroutine is resumed on this
+         thread, hence it should move on (e.g. with ActionQueue::schedule()) before
+         doing anything lengthy, and that the same restriction as for async() applies:
+         the previous action must have completed before this is awaited.
+         @code
+         auto value = co_await thread.awaitable([] { return compute(); });
+         @endcode
+         */
+        template <class Fn>
+        Awaiter<typename std::decay<Fn>::type> awaitable(Fn&& fn) {
+            return Awaiter<typename std::decay<Fn>::type>(*this, std::forward<Fn>(fn));
+        }
+#endif
+
     private:
-        void startTask(std::packaged_task<T()>&& pt) {
-            std::lock_guard<std::mutex> l(lock);
+        using task_t = InlineFunction<void()>;
 
+        // Marks the thread as no longer busy once the action has returned (or thrown),
+        // but before its result is made available. This allows whoever receives the
+        // result, including a continuation or coroutine run by this thread, to start
+        // the next action.
+        struct IdleOnExit {
+            explicit IdleOnExit(ActionThread& th) noexcept : thread(th) {}
+            ~IdleOnExit() noexcept { thread.busy.store(false, std::memory_order_release); }
+            ActionThread& thread;
+        };
+
+        // The task is written by the caller only when posted is false, and is read by
+        // the worker only when posted is true. The parked flags, with the sequentially
+        // consistent operations on each side, ensure that either the poster sees that
+        // the other thread is parked (and notifies it while holding the lock, which the
+        // other thread holds from setting its flag until it is actually waiting), or
+        // the other thread sees the new state before it parks.
+        void startTask(task_t&& t) {
 #           if !defined(NDEBUG)
-            kss::contract::preconditions({ KSS_EXPR(!_private::isCallable(worker)) });
+            kss::contract::preconditions({ KSS_EXPR(!busy.load(std::memory_order_acquire)) });
 #           endif
 
-            worker = move(pt);
-            cv.notify_all();
+            busy.store(true, std::memory_order_relaxed);
+            task = std::move(t);
+            posted.store(true);
+            if (workerParked.load()) {
+                std::lock_guard<Lockable> l(lock);
+                cv.notify_one();
+            }
+        }
 
+        // As startTask(), but holding the lock until we are done with this object.
+        // This is used when the task may lead to the ActionThread being destroyed,
+        // as when it resumes a coroutine.
+        void startTaskLocked(task_t&& t) {
 #           if !defined(NDEBUG)
-            kss::contract::postconditions({ KSS_EXPR(_private::isCallable(worker)) });
+            kss::contract::preconditions({ KSS_EXPR(!busy.load(std::memory_order_acquire)) });
 #           endif
+
+            busy.store(true, std::memory_order_relaxed);
+            std::lock_guard<Lockable> l(lock);
+            task = std::move(t);
+            posted.store(true);
+            cv.notify_one();
         }
 
-        std::thread workerThread { [this] {
-            while (true) {
-                std::packaged_task<T()> localWorker;
+        void shutdown() noexcept {
+            locked(lock, [this] { stopping = true; });
+            cv.notify_all();
+            if (workerThread.joinable()) {
+                workerThread.join();
+            }
+        }
+
+        void notifyComplete() {
+            complete.store(true);
+            if (waiterParked.load()) {
+                std::lock_guard<Lockable> l(lock);
+                doneCv.notify_all();
+            }
+        }
 
-                // Wait until a worker has been assigned.
-                {
-                    std::unique_lock<std::mutex> l(lock);
+        // Returns false if the thread should stop.
+        bool waitForTask() {
+            for (unsigned i = 0, n = _private::spinIterations(); i < n; ++i) {
+                if (posted.load(std::memory_order_acquire)) {
+                    return !stopping;
+                }
+                _private::cpuRelax();
+            }
 
-                    if (stopping) { break; }
-                    cv.wait(l, [this] { return stopping || _private::isCallable(worker); });
+            std::unique_lock<Lockable> l(lock);
+            workerParked.store(true);
+            cv.wait(l, [this] { return stopping || posted.load(); });
+            workerParked.store(false, std::memory_order_relaxed);
+            return !stopping;
+        }
 
-                    if (stopping) { break; }
-                    localWorker.swap(worker);
+        using condition_t = _private::condition_variable_for_t<Lockable>;
 
-#                   if !defined(NDEBUG)
-                    kss::contract::conditions({ KSS_EXPR(!_private::isCallable(worker)) });
-#                   endif
-                }
+        Lockable                    lock;
+        condition_t                 cv;
+        condition_t                 doneCv;
+        std::atomic<bool>           stopping { false };
+        std::atomic<bool>           posted { false };
+        std::atomic<bool>           busy { false };
+        std::atomic<bool>           complete { false };
+        std::atomic<bool>           workerParked { false };
+        std::atomic<bool>           waiterParked { false };
+        task_t                      task;
+        _private::ResultSlot<T>     result;
+
+        // This must be declared last, since the thread starts as soon as it is
+        // constructed and it uses the other members.
+        std::thread workerThread { [this] {
+            while (waitForTask()) {
+                task_t localTask = std::move(task);
+                posted.store(false, std::memory_order_release);
 
-                // Run the worker.
 #               if !defined(NDEBUG)
-                kss::contract::conditions({ KSS_EXPR(_private::isCallable(localWorker)) });
+                kss::contract::conditions({ KSS_EXPR(bool(localTask)) });
 #               endif
-                localWorker();
+                localTask();
             }
         }};
-
-        std::mutex              lock;
-        std::condition_variable cv;
-        bool                    stopping = false;
-        std::packaged_task<T()> worker;
     };
 }}
 
-#endif 
+#endif
@@ -0,0 +1,33 @@
+#ifndef kssrepo_all_h
+#define kssrepo_all_h
+
+/* This file is auto-generated and should not be edited. */
+
+#include "action_queue.hpp"
+#include "action_thread.hpp"
+#include "atomic_wait.hpp"
+#include "bounded_queue.hpp"
+#include "channel.hpp"
+#include "coroutine.hpp"
+#include "future.hpp"
+#include "inline_function.hpp"
+#include "instrumented_lock.hpp"
+#include "interruptible.hpp"
+#include "join.hpp"
+#include "latency_histogram.hpp"
+#include "lock.hpp"
+#include "parallel.hpp"
+#include "poller.hpp"
+#include "read_write_lock.hpp"
+#include "semaphore.hpp"
+#include "seq_lock.hpp"
+#include "signal.hpp"
+#include "spin_lock.hpp"
+#include "stop_token.hpp"
+#include "synchronizer.hpp"
+#include "thread_attributes.hpp"
+#include "version.hpp"
+#include "versioned.hpp"
+
+#endif
+
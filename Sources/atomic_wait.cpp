@@ -0,0 +1,128 @@
+//
+//  atomic_wait.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__linux)
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#else
+#   include <condition_variable>
+#   include <functional>
+#   include <mutex>
+#endif
+
+#include "atomic_wait.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+    static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t),
+                  "atomic<uint32_t> must have the same layout as uint32_t");
+}
+
+
+#if defined(__linux)
+
+namespace {
+    // The futex operates on the underlying 32-bit word.
+    inline uint32_t* addressOf(const atomic<uint32_t>& word) noexcept {
+        return reinterpret_cast<uint32_t*>(const_cast<atomic<uint32_t>*>(&word));
+    }
+
+    inline long futex(uint32_t* addr, int op, uint32_t val, const timespec* timeout) noexcept {
+        return syscall(SYS_futex, addr, op, val, timeout, nullptr, 0);
+    }
+}
+
+void kss::thread::_private::atomicWait(const atomic<uint32_t>& word, uint32_t expected) noexcept {
+    futex(addressOf(word), FUTEX_WAIT_PRIVATE, expected, nullptr);
+}
+
+bool kss::thread::_private::atomicWaitUntil(const atomic<uint32_t>& word,
+                                            uint32_t expected,
+                                            const steady_clock::time_point& deadline) noexcept
+{
+    const auto remaining = deadline - steady_clock::now();
+    if (remaining <= steady_clock::duration::zero()) {
+        return false;
+    }
+
+    const auto ts = toTimespec(duration_cast<nanoseconds>(remaining));
+    if (futex(addressOf(word), FUTEX_WAIT_PRIVATE, expected, &ts) == -1 && errno == ETIMEDOUT) {
+        return false;
+    }
+    return true;
+}
+
+void kss::thread::_private::atomicNotifyAll(const atomic<uint32_t>& word) noexcept {
+    futex(addressOf(word), FUTEX_WAKE_PRIVATE, uint32_t(INT32_MAX), nullptr);
+}
+
+void kss::thread::_private::atomicNotifyOne(const atomic<uint32_t>& word) noexcept {
+    futex(addressOf(word), FUTEX_WAKE_PRIVATE, 1, nullptr);
+}
+
+#else
+
+namespace {
+    // Without a futex we park on one of a fixed number of condition variables,
+    // selected by the address of the word. Since the word is always re-checked
+    // while holding the bucket lock, and the notifier takes the same lock after
+    // changing the word, no wake-ups can be lost.
+    struct Bucket {
+        mutex               lock;
+        condition_variable  cv;
+    };
+
+    constexpr size_t numberOfBuckets = 64;
+
+    Bucket& bucketFor(const atomic<uint32_t>& word) noexcept {
+        static Bucket buckets[numberOfBuckets];
+        return buckets[hash<const void*>()(&word) % numberOfBuckets];
+    }
+}
+
+void kss::thread::_private::atomicWait(const atomic<uint32_t>& word, uint32_t expected) noexcept {
+    auto& b = bucketFor(word);
+    unique_lock<mutex> l(b.lock);
+    if (word.load() == expected) {
+        b.cv.wait(l);
+    }
+}
+
+bool kss::thread::_private::atomicWaitUntil(const atomic<uint32_t>& word,
+                                            uint32_t expected,
+                                            const steady_clock::time_point& deadline) noexcept
+{
+    auto& b = bucketFor(word);
+    unique_lock<mutex> l(b.lock);
+    if (word.load() == expected) {
+        return (b.cv.wait_until(l, deadline) == cv_status::no_timeout);
+    }
+    return true;
+}
+
+void kss::thread::_private::atomicNotifyAll(const atomic<uint32_t>& word) noexcept {
+    auto& b = bucketFor(word);
+    { lock_guard<mutex> l(b.lock); }
+    b.cv.notify_all();
+}
+
+// Other words may share the bucket, hence we cannot wake just one thread.
+void kss::thread::_private::atomicNotifyOne(const atomic<uint32_t>& word) noexcept {
+    atomicNotifyAll(word);
+}
+
+#endif
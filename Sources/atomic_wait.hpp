@@ -0,0 +1,145 @@
+//
+//  atomic_wait.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// Internal building blocks for the spin-then-park synchronizers. These are not
+// intended to be used directly.
+//
+
+#ifndef kssthread_atomic_wait_hpp
+#define kssthread_atomic_wait_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+// glibc 2.30 added timed waits (pthread_rwlock_clockrdlock, sem_clockwait, ...) that
+// accept CLOCK_MONOTONIC, and hence are not affected by changes to the system time.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+#   define KSS_THREAD_HAVE_CLOCKWAIT 1
+#endif
+
+namespace kss { namespace thread { namespace _private {
+
+    // Hint to the processor that we are in a spin loop.
+    inline void cpuRelax() noexcept {
+#       if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#       elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#       endif
+    }
+
+    // The number of times to spin before parking. Spinning is only worthwhile if
+    // the other thread can be running at the same time, so on a single processor
+    // we do not spin at all.
+    inline unsigned spinIterations() noexcept {
+        static const unsigned iterations = (std::thread::hardware_concurrency() > 1 ? 4000 : 0);
+        return iterations;
+    }
+
+    // Adaptive spinning, in the style of the glibc adaptive mutexes. Call tryFn up to
+    // (about) twice the number of attempts that recent successful spins needed, and
+    // update that average. Returns true if tryFn succeeded. On a single processor no
+    // attempts are made.
+    template <class TryFn>
+    bool adaptiveSpin(std::atomic<unsigned>& average, TryFn&& tryFn) {
+        const unsigned maxAttempts = spinIterations() / 40;
+        const auto avg = average.load(std::memory_order_relaxed);
+        const auto limit = std::min(maxAttempts, (avg * 2) + 10);
+        for (unsigned i = 0; i < limit; ++i) {
+            if (tryFn()) {
+                average.store(unsigned(int(avg) + ((int(i) - int(avg)) / 8)), std::memory_order_relaxed);
+                return true;
+            }
+            cpuRelax();
+        }
+        if (limit > 0) {
+            average.store(unsigned(int(avg) + ((int(limit) - int(avg)) / 8)), std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    // Repeatedly call tryFn, backing off from short to longer sleeps, until it
+    // succeeds or the deadline passes. This is for platforms without the timed POSIX
+    // calls.
+    template <class TryFn>
+    bool pollUntil(const std::chrono::steady_clock::time_point& deadline, TryFn&& tryFn) {
+        using namespace std::chrono;
+        auto delay = microseconds(50);
+        for (;;) {
+            if (tryFn()) {
+                return true;
+            }
+            const auto now = steady_clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::min<steady_clock::duration>(delay, deadline - now));
+            delay = std::min(delay * 2, microseconds(1000));
+        }
+    }
+
+    // Convert a steady_clock deadline to a timespec, either for CLOCK_MONOTONIC
+    // (which is what steady_clock uses on Linux) or for CLOCK_REALTIME, for the
+    // POSIX calls that only accept the latter.
+    inline timespec toTimespec(const std::chrono::nanoseconds& ns) noexcept {
+        using namespace std::chrono;
+        const auto secs = duration_cast<seconds>(ns);
+        timespec ts;
+        ts.tv_sec = time_t(secs.count());
+        ts.tv_nsec = long((ns - secs).count());
+        return ts;
+    }
+
+    inline timespec monotonicTimespec(const std::chrono::steady_clock::time_point& deadline) noexcept {
+        return toTimespec(deadline.time_since_epoch());
+    }
+
+    inline timespec realtimeTimespec(const std::chrono::steady_clock::time_point& deadline) noexcept {
+        using namespace std::chrono;
+        const auto realDeadline = system_clock::now() + (deadline - steady_clock::now());
+        return toTimespec(realDeadline.time_since_epoch());
+    }
+
+    // Block while word == expected, or until woken by atomicNotifyAll(). (Like
+    // std::atomic::wait(), this may return spuriously, hence the caller must
+    // re-check its condition.) This is a futex on Linux, and a table of condition
+    // variables elsewhere.
+    void atomicWait(const std::atomic<uint32_t>& word, uint32_t expected) noexcept;
+
+    // As atomicWait(), but returns false if the deadline passed.
+    bool atomicWaitUntil(const std::atomic<uint32_t>& word,
+                         uint32_t expected,
+                         const std::chrono::steady_clock::time_point& deadline) noexcept;
+
+    // Wake all the threads blocked in atomicWait() on the given word. This must be
+    // called after the word has been changed.
+    void atomicNotifyAll(const std::atomic<uint32_t>& word) noexcept;
+
+    // Wake at least one of the threads blocked in atomicWait() on the given word. The
+    // word need not still exist, only the address is used.
+    void atomicNotifyOne(const std::atomic<uint32_t>& word) noexcept;
+
+    // Convert any time point to a steady_clock deadline.
+    template <class TimePoint>
+    std::chrono::steady_clock::time_point toSteadyDeadline(const TimePoint& tp) {
+        using namespace std::chrono;
+        const auto remaining = tp - TimePoint::clock::now();
+        return steady_clock::now() + duration_cast<steady_clock::duration>(remaining);
+    }
+
+    inline std::chrono::steady_clock::time_point
+    toSteadyDeadline(const std::chrono::steady_clock::time_point& tp) {
+        return tp;
+    }
+}}}
+
+#endif
@@ -0,0 +1,202 @@
+//
+//  bounded_queue.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_bounded_queue_hpp
+#define kssthread_bounded_queue_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <kss/contract/all.h>
+
+namespace kss { namespace thread {
+
+    /*!
+     A BoundedQueue is a fixed capacity, lock-free, multi-producer multi-consumer FIFO
+     queue. It is a ring buffer in which each slot carries a sequence number that tells
+     producers when the slot is free and consumers when it is filled (D. Vyukov's
+     bounded MPMC queue). Pushing or popping an item is a single compare-and-swap on
+     the shared position plus a store to the slot, and producers and consumers only
+     contend with each other when the queue is nearly empty or nearly full. The two
+     shared positions are kept in separate cache lines.
+
+     None of the methods block. When the queue is full tryPush() returns false, and
+     when it is empty tryPop() returns false. For a queue that waits, see Channel.
+
+     T must be nothrow move constructible and nothrow move assignable, which ensures
+     that an item can never be left half way into or out of a slot.
+
+     @code
+     BoundedQueue<Request> q(1024);
+     if (!q.tryPush(std::move(req))) {   // producers
+        reject(req);
+     }
+     Request r;
+     while (q.tryPop(r)) {               // consumers
+        handle(r);
+     }
+     @endcode
+     */
+    template <class T>
+    class BoundedQueue {
+    public:
+        static_assert(std::is_nothrow_move_constructible<T>::value, "T must be nothrow move constructible");
+        static_assert(std::is_nothrow_move_assignable<T>::value, "T must be nothrow move assignable");
+
+        /*!
+         Construct a queue that can hold up to capacity items.
+         @throws std::invalid_argument if capacity is 0
+         @throws std::bad_alloc if the slots could not be allocated
+         */
+        explicit BoundedQueue(std::size_t capacity) : _capacity(capacity) {
+            kss::contract::parameters({
+                KSS_EXPR(capacity > 0)
+            });
+
+            slots.reset(new Slot[capacity]);
+            for (std::size_t i = 0; i < capacity; ++i) {
+                slots[i].sequence.store(2 * i, std::memory_order_relaxed);
+            }
+        }
+
+        /*!
+         Destroy the queue and any items still in it. There must not be any
+         concurrent operations on it.
+         */
+        ~BoundedQueue() noexcept {
+            const auto last = enqueuePos.load();
+            for (auto pos = dequeuePos.load(); pos != last; ++pos) {
+                slots[pos % _capacity].item()->~T();
+            }
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /*!
+         Add an item to the end of the queue. Returns false if the queue is full. Note
+         that value is only moved from if it was added.
+         */
+        bool tryPush(T&& value) noexcept {
+            Slot* slot = nullptr;
+            auto pos = enqueuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                slot = &slots[pos % _capacity];
+                const auto seq = slot->sequence.load(std::memory_order_acquire);
+                const auto diff = std::intptr_t(seq) - std::intptr_t(2 * pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;       // the slot still holds the item from the previous lap
+                }
+                else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            ::new (&slot->storage) T(std::move(value));
+            slot->sequence.store((2 * pos) + 1, std::memory_order_release);
+            return true;
+        }
+
+        /*!
+         Add a copy of an item to the end of the queue. Returns false if the queue
+         is full.
+         @throws any exception that copying a T may throw
+         */
+        bool tryPush(const T& value) {
+            T copy(value);
+            return tryPush(std::move(copy));
+        }
+
+        /*!
+         Remove the item at the front of the queue, moving it into value. Returns false,
+         leaving value unchanged, if the queue is empty.
+         */
+        bool tryPop(T& value) noexcept {
+            Slot* slot = nullptr;
+            auto pos = dequeuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                slot = &slots[pos % _capacity];
+                const auto seq = slot->sequence.load(std::memory_order_acquire);
+                const auto diff = std::intptr_t(seq) - std::intptr_t((2 * pos) + 1);
+                if (diff == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;       // the slot has not been filled for this lap
+                }
+                else {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            T* item = slot->item();
+            value = std::move(*item);
+            item->~T();
+            slot->sequence.store(2 * (pos + _capacity), std::memory_order_release);
+            return true;
+        }
+
+        /*!
+         Returns the maximum number of items the queue can hold.
+         */
+        std::size_t capacity() const noexcept { return _capacity; }
+
+        /*!
+         Returns the approximate number of items in the queue. When there are
+         concurrent operations this may have changed by the time it is examined.
+         */
+        std::size_t size() const noexcept {
+            const auto deq = dequeuePos.load(std::memory_order_relaxed);
+            const auto enq = enqueuePos.load(std::memory_order_relaxed);
+            return (enq > deq ? std::min(enq - deq, _capacity) : 0);
+        }
+
+        /*!
+         Returns true if the queue was empty. See size() for details.
+         */
+        bool empty() const noexcept { return size() == 0; }
+
+    private:
+        // For the item at position pos, the sequence of its slot is 2*pos when the slot is
+        // free for it, and 2*pos+1 once it has been stored. (Using pos and pos+1, as in
+        // the original algorithm, would not distinguish the two when the capacity is 1.)
+        struct Slot {
+            std::atomic<std::size_t>                                    sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type  storage;
+
+            T* item() noexcept { return reinterpret_cast<T*>(&storage); }
+        };
+
+        const std::size_t           _capacity;
+        std::unique_ptr<Slot[]>     slots;
+
+        // The producer and consumer positions are kept away from each other, and from
+        // the fields above, since they are written by different threads.
+        char                        padding0[64];
+        std::atomic<std::size_t>    enqueuePos { 0 };
+        char                        padding1[64 - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t>    dequeuePos { 0 };
+        char                        padding2[64 - sizeof(std::atomic<std::size_t>)];
+    };
+}}
+
+#endif
@@ -0,0 +1,320 @@
+//
+//  channel.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_channel_hpp
+#define kssthread_channel_hpp
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "atomic_wait.hpp"
+#include "bounded_queue.hpp"
+#include "interruptible.hpp"
+#include "lock.hpp"
+#include "stop_token.hpp"
+
+namespace kss { namespace thread {
+
+    /*!
+     A Channel passes items from producer threads to consumer threads through a
+     BoundedQueue, blocking producers while it is full and consumers while it is
+     empty. The blocking methods follow the synchronizer conventions: push() and pop()
+     wait as long as necessary, while pushFor(), pushUntil(), popFor(), and popUntil()
+     give up, returning false, once the given duration or time point is reached.
+     Waiting is a thread interruption point, and in a stoppable section a stop request
+     wakes the waiting thread, which then throws Stopped.
+
+     Items are passed lock-free when the channel is neither full nor empty. A thread
+     only takes the internal lock when it has to wait, or when it must wake a thread
+     that is waiting.
+
+     When the producers are done, close() the channel. Subsequent pushes fail, and once
+     the remaining items have been popped, all pops fail. This allows the stages of a
+     pipeline to be shut down in order:
+
+     @code
+     Channel<Record> stage1(256);
+     thread producer { [&] {
+        Record r;
+        while (readRecord(r)) {
+            stage1.push(std::move(r));
+        }
+        stage1.close();
+     }};
+     thread consumer { [&] {
+        Record r;
+        while (stage1.pop(r)) {
+            process(r);
+        }
+     }};
+     @endcode
+
+     Note that close() should only be called once all the pushes have completed, since
+     an item pushed concurrently with (or after) the last pop that returned false would
+     never be seen.
+
+     The lock used by waiting threads may be any Lockable type, such as AdaptiveMutex.
+     Types other than std::mutex are waited on with a std::condition_variable_any.
+     */
+    template <class T, class Lockable = std::mutex>
+    class Channel {
+    public:
+
+        /*!
+         Construct a channel that can hold up to capacity items.
+         @throws std::invalid_argument if capacity is 0
+         @throws std::bad_alloc if the queue could not be allocated
+         */
+        explicit Channel(std::size_t capacity) : queue(capacity) {}
+
+        Channel(const Channel&) = delete;
+        Channel& operator=(const Channel&) = delete;
+
+        /*!
+         Add an item, waiting while the channel is full. Returns false if the channel
+         has been closed.
+         @throws kss::thread::Interrupted if interrupted in an interruptible section
+         @throws kss::thread::Stopped if a stop is requested in a stoppable section
+         @throws any exception that the underlying mutex or condition variable may throw
+         */
+        bool push(T value) {
+            return pushUntilDeadline(value, nullptr);
+        }
+
+        /*!
+         Add an item, waiting up to the given duration while the channel is full.
+         Returns false if the item could not be added in time or the channel has been
+         closed. Note that value is only moved from if it was added, and that a const
+         value is copied.
+         */
+        template <class Duration>
+        bool pushFor(T&& value, const Duration& dur) {
+            using namespace std::chrono;
+            return pushUntil(std::move(value), steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        template <class Duration>
+        bool pushFor(const T& value, const Duration& dur) {
+            T copy(value);
+            return pushFor(std::move(copy), dur);
+        }
+
+        /*!
+         Add an item, waiting up to the given time point while the channel is full. See
+         pushFor() for details.
+         */
+        template <class TimePoint>
+        bool pushUntil(T&& value, const TimePoint& tp) {
+            const auto deadline = _private::toSteadyDeadline(tp);
+            return pushUntilDeadline(value, &deadline);
+        }
+
+        template <class TimePoint>
+        bool pushUntil(const T& value, const TimePoint& tp) {
+            T copy(value);
+            return pushUntil(std::move(copy), tp);
+        }
+
+        /*!
+         Add an item if there is room for it now. Returns false if the channel is
+         full or has been closed. Note that value is only moved from if it was added,
+         and that a const value is copied.
+         */
+        bool tryPush(T&& value) {
+            bool added = false;
+            attemptPush(value, added);
+            if (added) {
+                wake(notEmpty, numberWaitingToPop);
+            }
+            return added;
+        }
+
+        bool tryPush(const T& value) {
+            T copy(value);
+            return tryPush(std::move(copy));
+        }
+
+        /*!
+         Remove the next item, waiting while the channel is empty. Returns false if the
+         channel has been closed and all its items have been removed.
+         @throws kss::thread::Interrupted if interrupted in an interruptible section
+         @throws kss::thread::Stopped if a stop is requested in a stoppable section
+         @throws any exception that the underlying mutex or condition variable may throw
+         */
+        bool pop(T& value) {
+            return popUntilDeadline(value, nullptr);
+        }
+
+        /*!
+         Remove the next item, waiting up to the given duration while the channel is
+         empty. Returns false if no item was available in time, or if the channel has
+         been closed and all its items have been removed.
+         */
+        template <class Duration>
+        bool popFor(T& value, const Duration& dur) {
+            using namespace std::chrono;
+            return popUntil(value, steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        /*!
+         Remove the next item, waiting up to the given time point while the channel is
+         empty. See popFor() for details.
+         */
+        template <class TimePoint>
+        bool popUntil(T& value, const TimePoint& tp) {
+            const auto deadline = _private::toSteadyDeadline(tp);
+            return popUntilDeadline(value, &deadline);
+        }
+
+        /*!
+         Remove the next item if there is one now. Returns false if the channel is empty.
+         */
+        bool tryPop(T& value) {
+            bool removed = false;
+            attemptPop(value, removed);
+            if (removed) {
+                wake(notFull, numberWaitingToPush);
+            }
+            return removed;
+        }
+
+        /*!
+         Close the channel. All threads waiting on it are woken, pushes now fail, and
+         pops fail once the channel is empty.
+         */
+        void close() {
+            closed.store(true);
+            std::lock_guard<Lockable> l(lock);
+            notFull.notify_all();
+            notEmpty.notify_all();
+        }
+
+        /*!
+         Returns true if the channel has been closed.
+         */
+        bool isClosed() const noexcept {
+            return closed.load();
+        }
+
+        /*!
+         Returns the maximum number of items the channel can hold.
+         */
+        std::size_t capacity() const noexcept { return queue.capacity(); }
+
+        /*!
+         Returns the approximate number of items in the channel.
+         */
+        std::size_t size() const noexcept { return queue.size(); }
+
+    private:
+        BoundedQueue<T>             queue;
+        std::atomic<bool>           closed { false };
+        std::atomic<uint32_t>       numberWaitingToPush { 0 };
+        std::atomic<uint32_t>       numberWaitingToPop { 0 };
+        using condition_t = _private::condition_variable_for_t<Lockable>;
+
+        Lockable                    lock;
+        condition_t                 notFull;
+        condition_t                 notEmpty;
+
+        // Returns true if the push is finished, i.e. if it succeeded or never will.
+        bool attemptPush(T& value, bool& added) {
+            if (closed.load()) {
+                return true;
+            }
+            if (queue.tryPush(std::move(value))) {
+                added = true;
+                return true;
+            }
+            return false;
+        }
+
+        // Returns true if the pop is finished, i.e. if it succeeded or never will.
+        // When closed we check once more, since an item may have been pushed just
+        // before the close.
+        bool attemptPop(T& value, bool& removed) {
+            if (queue.tryPop(value) || (closed.load() && queue.tryPop(value))) {
+                removed = true;
+                return true;
+            }
+            return closed.load();
+        }
+
+        bool pushUntilDeadline(T& value, const std::chrono::steady_clock::time_point* deadline) {
+            bool added = false;
+            blockUntil(notFull, numberWaitingToPush, [&] { return attemptPush(value, added); }, deadline);
+            if (added) {
+                wake(notEmpty, numberWaitingToPop);
+            }
+            return added;
+        }
+
+        bool popUntilDeadline(T& value, const std::chrono::steady_clock::time_point* deadline) {
+            bool removed = false;
+            blockUntil(notEmpty, numberWaitingToPop, [&] { return attemptPop(value, removed); }, deadline);
+            if (removed) {
+                wake(notFull, numberWaitingToPush);
+            }
+            return removed;
+        }
+
+        // A waiter registers itself, and then tries again, while holding the lock. The
+        // fences ensure that either the waiter sees the other thread's change, or the
+        // other thread sees the waiter and wakes it. Since the waker takes the lock,
+        // it cannot do so between the waiter's last attempt and its wait.
+        void wake(condition_t& cv, const std::atomic<uint32_t>& numberWaiting) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (numberWaiting.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<Lockable> l(lock);
+                cv.notify_one();
+            }
+        }
+
+        struct WaitRegistration {
+            explicit WaitRegistration(std::atomic<uint32_t>& n) : numberWaiting(n) {
+                ++numberWaiting;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            ~WaitRegistration() noexcept { --numberWaiting; }
+            std::atomic<uint32_t>& numberWaiting;
+        };
+
+        template <class AttemptFn>
+        void blockUntil(condition_t& cv,
+                        std::atomic<uint32_t>& numberWaiting,
+                        AttemptFn&& attempt,
+                        const std::chrono::steady_clock::time_point* deadline)
+        {
+            if (attempt()) {
+                return;
+            }
+
+            _private::WakeOnStop waker(lock, cv);
+            std::unique_lock<Lockable> l(lock);
+            WaitRegistration registration(numberWaiting);
+            while (!attempt()) {
+                interruptionPoint();
+                if (!deadline) {
+                    cv.wait(l);
+                }
+                else if (cv.wait_until(l, *deadline) == std::cv_status::timeout) {
+                    attempt();
+                    return;
+                }
+            }
+        }
+    };
+}}
+
+#endif
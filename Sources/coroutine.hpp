@@ -0,0 +1,66 @@
+//
+//  coroutine.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// The library itself is built as C++14, hence the coroutine support is entirely
+// header-only and is only enabled when the including code is compiled with C++20
+// coroutines. KSS_THREAD_HAVE_COROUTINES is defined when it is available.
+//
+
+#ifndef kssthread_coroutine_hpp
+#define kssthread_coroutine_hpp
+
+#if defined(__has_include) && defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+#   if __has_include(<coroutine>)
+#       define KSS_THREAD_HAVE_COROUTINES 1
+#   endif
+#endif
+
+#if defined(KSS_THREAD_HAVE_COROUTINES)
+
+#include <coroutine>
+#include <exception>
+
+namespace kss { namespace thread {
+
+    /*!
+     A DetachedTask is the simplest possible coroutine type. The coroutine starts
+     running as soon as it is called, nothing waits for it to complete, and its frame
+     is destroyed when it finishes. This makes it suitable for state machines that
+     are driven by ActionQueue::after() and ActionQueue::schedule(), each of which
+     costs a single pending action while suspended and no thread.
+
+     As with a std::thread, an exception escaping from the coroutine will call
+     std::terminate.
+
+     Note that a coroutine that is suspended on an ActionQueue is only resumed by
+     that queue. If the queue is destroyed, or its pending actions cancelled, before
+     the coroutine is resumed, it is never resumed and its frame is not destroyed.
+
+     @code
+     DetachedTask blink(ActionQueue& q, Led& led) {
+        for (int i = 0; i < 10; ++i) {
+            led.toggle();
+            co_await q.after(500ms);
+        }
+     }
+     @endcode
+     */
+    class DetachedTask {
+    public:
+        struct promise_type {
+            DetachedTask get_return_object() const noexcept { return DetachedTask(); }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+}}
+
+#endif
+#endif
@@ -0,0 +1,753 @@
+//
+//  future.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_future_hpp
+#define kssthread_future_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <syslog.h>
+#include <kss/contract/all.h>
+
+#include "action_queue.hpp"
+#include "inline_function.hpp"
+
+namespace kss { namespace thread {
+
+    template <class T> class Future;
+    template <class T> class Promise;
+
+    namespace _private {
+
+        // Holds a result, or the exception that was thrown instead of producing it.
+        template <class T>
+        class ResultSlot {
+        public:
+            ResultSlot() = default;
+            ~ResultSlot() noexcept { reset(); }
+
+            ResultSlot(const ResultSlot&) = delete;
+            ResultSlot& operator=(const ResultSlot&) = delete;
+
+            template <class Fn>
+            void set(Fn& fn) noexcept {
+                reset();
+                try {
+                    ::new (&storage) T(fn());
+                    hasValue = true;
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            void setException(std::exception_ptr ep) noexcept {
+                reset();
+                error = ep;
+            }
+
+            bool failed() const noexcept { return bool(error); }
+
+            T take() {
+                if (error) {
+                    auto ep = error;
+                    error = nullptr;
+                    std::rethrow_exception(ep);
+                }
+                T ret(std::move(*reinterpret_cast<T*>(&storage)));
+                reset();
+                return ret;
+            }
+
+            void reset() noexcept {
+                if (hasValue) {
+                    reinterpret_cast<T*>(&storage)->~T();
+                    hasValue = false;
+                }
+                error = nullptr;
+            }
+
+        private:
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            bool                hasValue = false;
+            std::exception_ptr  error;
+        };
+
+        template <>
+        class ResultSlot<void> {
+        public:
+            template <class Fn>
+            void set(Fn& fn) noexcept {
+                error = nullptr;
+                try {
+                    fn();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            void setException(std::exception_ptr ep) noexcept { error = ep; }
+
+            bool failed() const noexcept { return bool(error); }
+
+            void take() {
+                if (error) {
+                    auto ep = error;
+                    error = nullptr;
+                    std::rethrow_exception(ep);
+                }
+            }
+
+            void reset() noexcept { error = nullptr; }
+
+        private:
+            std::exception_ptr  error;
+        };
+
+        // The state shared by a Promise and its Future. The continuation, if there is
+        // one, is run by whichever of the two sides arrives second: by complete() if
+        // the continuation was already set, otherwise by setContinuation().
+        //
+        // There is a single producer, which writes the result without the lock (so
+        // that fn is not run while holding it), and a single consumer, which does not
+        // read the result until it has seen ready.
+        template <class T>
+        class FutureState {
+        public:
+            using continuation_t = InlineFunction<void()>;
+
+            template <class Fn>
+            void complete(Fn& fn) {
+                checkNotReady();
+                result.set(fn);
+                publish();
+            }
+
+            void fail(std::exception_ptr ep) {
+                checkNotReady();
+                result.setException(ep);
+                publish();
+            }
+
+            void setContinuation(continuation_t&& c) {
+                {
+                    std::lock_guard<std::mutex> l(lock);
+                    if (!ready) {
+                        continuation = std::move(c);
+                        return;
+                    }
+                }
+                c();
+            }
+
+            bool isReady() const noexcept { return ready.load(std::memory_order_acquire); }
+
+            void wait() {
+                if (isReady()) {
+                    return;
+                }
+                std::unique_lock<std::mutex> l(lock);
+                ++waiters;
+                cv.wait(l, [this] { return ready.load(); });
+                --waiters;
+            }
+
+            // Only the single consumer may call this, and only once it is ready.
+            T take() { return result.take(); }
+            bool failed() const noexcept { return result.failed(); }
+
+        private:
+            std::mutex              lock;
+            std::condition_variable cv;
+            std::atomic<bool>       ready { false };
+            unsigned                waiters = 0;
+            continuation_t          continuation;
+            ResultSlot<T>           result;
+
+            void checkNotReady() const {
+                if (isReady()) {
+                    throw std::future_error(std::future_errc::promise_already_satisfied);
+                }
+            }
+
+            void publish() {
+                continuation_t c;
+                {
+                    std::lock_guard<std::mutex> l(lock);
+                    ready.store(true, std::memory_order_release);
+                    c = std::move(continuation);
+                    if (waiters > 0) {
+                        cv.notify_all();
+                    }
+                }
+                if (c) {
+                    c();
+                }
+            }
+        };
+
+        // Gives the helpers below access to the state of a Future.
+        struct FutureAccess {
+            template <class T>
+            static std::shared_ptr<FutureState<T>> release(Future<T>& f) {
+                f.checkValid();
+                return std::move(f.state);
+            }
+        };
+
+        template <class T> struct UnwrapFuture { using type = T; };
+        template <class T> struct UnwrapFuture<Future<T>> { using type = T; };
+
+        // The type returned by a continuation given the value of a Future<T>.
+        template <class T, class Fn>
+        struct ContinuationResult { using type = decltype(std::declval<Fn&>()(std::declval<T>())); };
+
+        template <class Fn>
+        struct ContinuationResult<void, Fn> { using type = decltype(std::declval<Fn&>()()); };
+
+        // Call a continuation with the value held by the state, which must be ready.
+        template <class T>
+        struct Invoker {
+            template <class Fn>
+            static typename ContinuationResult<T, Fn>::type invoke(Fn& fn, FutureState<T>& st) {
+                return fn(st.take());
+            }
+        };
+
+        template <>
+        struct Invoker<void> {
+            template <class Fn>
+            static typename ContinuationResult<void, Fn>::type invoke(Fn& fn, FutureState<void>& st) {
+                st.take();
+                return fn();
+            }
+        };
+
+        // Complete the promise with the result of fn(), which returns R. When R is
+        // itself a Future, the promise is instead completed once that future is.
+        template <class R>
+        struct Fulfil {
+            template <class Fn>
+            static void run(Promise<R>& p, Fn&& fn) noexcept {
+                p.setWith(fn);
+            }
+        };
+
+        template <class U>
+        struct Fulfil<Future<U>> {
+            template <class Fn>
+            static void run(Promise<U>& p, Fn&& fn) noexcept {
+                try {
+                    fn().forwardTo(std::move(p));
+                }
+                catch (...) {
+                    if (p.valid()) {
+                        p.setException(std::current_exception());
+                    }
+                }
+            }
+        };
+    }
+
+
+    /*!
+     A Promise is used to provide the result (or exception) of a Future. Unlike a
+     std::promise it does not wait for anything. Setting the result immediately runs
+     the continuation attached to the future, if there is one, on the setting thread.
+
+     If a Promise is destroyed without setting a result, its future is given a
+     std::future_error with a code of broken_promise. A Promise must only be used by
+     one thread at a time.
+     */
+    template <class T>
+    class Promise {
+    public:
+        /*!
+         @throws std::bad_alloc if the shared state could not be allocated
+         */
+        Promise() : state(std::make_shared<_private::FutureState<T>>()) {}
+
+        ~Promise() noexcept {
+            if (state && !state->isReady()) {
+                try {
+                    state->fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+                }
+                catch (const std::exception& e) {
+                    // Best we can do is log the error and continue.
+                    syslog(LOG_ERR, "[%s] Exception breaking promise: %s", __PRETTY_FUNCTION__, e.what());
+                }
+            }
+        }
+
+        Promise(Promise&&) noexcept = default;
+        Promise& operator=(Promise&& other) noexcept {
+            if (this != &other) {
+                Promise tmp(std::move(*this));
+                state = std::move(other.state);
+                retrieved = other.retrieved;
+            }
+            return *this;
+        }
+
+        Promise(const Promise&) = delete;
+        Promise& operator=(const Promise&) = delete;
+
+        /*!
+         Returns true if this promise has a state, i.e. has not been moved from.
+         */
+        bool valid() const noexcept { return bool(state); }
+
+        /*!
+         Returns the future for this promise. This may only be called once.
+         @throws std::future_error with future_already_retrieved if it has already
+            been called, or no_state if the promise has been moved from
+         */
+        Future<T> getFuture() {
+            checkValid();
+            if (retrieved) {
+                throw std::future_error(std::future_errc::future_already_retrieved);
+            }
+            retrieved = true;
+            return Future<T>(state);
+        }
+
+        /*!
+         Set the result. For Promise<void> this takes no arguments, otherwise the
+         arguments are used to construct the T.
+         @throws std::future_error with promise_already_satisfied if a result has
+            already been set, or no_state if the promise has been moved from
+         */
+        template <class... Args>
+        void setValue(Args&&... args) {
+            auto fn = [&]() -> T { return T(std::forward<Args>(args)...); };
+            checkValid();
+            state->complete(fn);
+        }
+
+        /*!
+         Set the exception that the future will throw instead of giving a result.
+         @throws std::future_error as for setValue()
+         */
+        void setException(std::exception_ptr ep) {
+            checkValid();
+            state->fail(ep);
+        }
+
+        /*!
+         Set the result to the value returned by fn() or, if fn() throws, set the
+         exception instead.
+         @throws std::future_error as for setValue()
+         */
+        template <class Fn>
+        void setWith(Fn&& fn) {
+            checkValid();
+            state->complete(fn);
+        }
+
+    private:
+        std::shared_ptr<_private::FutureState<T>> state;
+        bool retrieved = false;
+
+        void checkValid() const {
+            if (!state) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+        }
+    };
+
+
+    /*!
+     A Future is a lightweight alternative to std::future whose result may be
+     consumed by a continuation rather than by a blocked thread. A continuation added
+     by then() is run by the thread that sets the result (or immediately, by the
+     calling thread, if the result is already available), or is added to an
+     ActionQueue. whenAll() and whenAny() combine a number of futures without
+     waiting for them.
+
+     Each future has a single consumer: get(), then(), recover(), forwardTo(),
+     whenAll(), and whenAny() all consume it, leaving it invalid.
+
+     @code
+     auto f = thread.submit([] { return fetch(); })
+        .then([](Response r) { return parse(r); })
+        .then(queue, [](Document d) { publish(d); });
+     @endcode
+     */
+    template <class T>
+    class Future {
+    public:
+        using value_type = T;
+
+        Future() noexcept = default;
+        Future(Future&&) noexcept = default;
+        Future& operator=(Future&&) noexcept = default;
+
+        Future(const Future&) = delete;
+        Future& operator=(const Future&) = delete;
+
+        /*!
+         Returns true if this future refers to a state, i.e. it was obtained from a
+         Promise (or one of the functions returning a Future) and has not yet been
+         consumed.
+         */
+        bool valid() const noexcept { return bool(state); }
+
+        /*!
+         Returns true if the result (or exception) is available.
+         @throws std::future_error with no_state if the future is not valid
+         */
+        bool isReady() const {
+            checkValid();
+            return state->isReady();
+        }
+
+        /*!
+         Block until the result is available. Note that this does tie up the calling
+         thread, which is what a continuation avoids.
+         @throws std::future_error with no_state if the future is not valid
+         */
+        void wait() const {
+            checkValid();
+            state->wait();
+        }
+
+        /*!
+         Block until the result is available and return it, consuming the future.
+         @throws std::future_error with no_state if the future is not valid
+         @throws the exception that was set instead of a result
+         */
+        T get() {
+            auto st = _private::FutureAccess::release(*this);
+            st->wait();
+            return st->take();
+        }
+
+        /*!
+         Attach a continuation, consuming this future. Once the result is available,
+         fn is called with it (or without an argument for a Future<void>) by the
+         thread that provided the result. If the result is already available, fn is
+         called immediately by this thread.
+
+         If this future holds an exception, fn is not called and the exception is
+         passed on to the returned future. Likewise an exception thrown by fn becomes
+         the exception of the returned future. If fn returns a Future<U>, the returned
+         future is a Future<U> that completes when that one does.
+
+         Since the continuation runs on the producing thread (e.g. an ActionThread
+         or a thread of a ParallelThreadGroup) it should be quick. Use the ActionQueue
+         version for anything more.
+         @return a future for the result of fn.
+         @throws std::future_error with no_state if the future is not valid
+         @throws std::bad_alloc if the continuation could not be allocated
+         */
+        template <class Fn>
+        Future<typename _private::UnwrapFuture<typename _private::ContinuationResult<T, Fn>::type>::type>
+        then(Fn&& fn) {
+            using R = typename _private::ContinuationResult<T, Fn>::type;
+            using U = typename _private::UnwrapFuture<R>::type;
+
+            Promise<U> p;
+            auto ret = p.getFuture();
+            auto st = _private::FutureAccess::release(*this);
+            auto* raw = st.get();
+            raw->setContinuation([st = std::move(st), p = std::move(p),
+                                  fn = typename std::decay<Fn>::type(std::forward<Fn>(fn))]() mutable
+            {
+                _private::Fulfil<R>::run(p, [&]() -> R { return _private::Invoker<T>::invoke(fn, *st); });
+            });
+            return ret;
+        }
+
+        /*!
+         As then(), except that fn is run by an action added to the queue, rather
+         than by the thread that provided the result. If the action cannot be added
+         (e.g. the queue is full) or is cancelled, the returned future is given that
+         exception (or a future_error with broken_promise) instead. The queue need not
+         outlive this future: if it has been destroyed by the time the result is
+         provided, the returned future is given a future_error with broken_promise.
+         */
+        template <class Fn>
+        Future<typename _private::UnwrapFuture<typename _private::ContinuationResult<T, Fn>::type>::type>
+        then(ActionQueue& queue, Fn&& fn) {
+            using R = typename _private::ContinuationResult<T, Fn>::type;
+            using U = typename _private::UnwrapFuture<R>::type;
+            using F = typename std::decay<Fn>::type;
+
+            struct Job {
+                Job(Promise<U>&& p_, F&& fn_, std::shared_ptr<_private::FutureState<T>>&& st_)
+                : p(std::move(p_)), fn(std::move(fn_)), st(std::move(st_)) {}
+
+                Promise<U>                                  p;
+                F                                           fn;
+                std::shared_ptr<_private::FutureState<T>>   st;
+            };
+
+            Promise<U> p;
+            auto ret = p.getFuture();
+            auto st = _private::FutureAccess::release(*this);
+            auto* raw = st.get();
+            auto job = std::make_shared<Job>(std::move(p), F(std::forward<Fn>(fn)), std::move(st));
+            raw->setContinuation([link = _private::QueueLink::of(queue), job]() mutable {
+                try {
+                    const auto added = link && link->addAction([job] {
+                        _private::Fulfil<R>::run(job->p, [&]() -> R {
+                            return _private::Invoker<T>::invoke(job->fn, *job->st);
+                        });
+                    });
+                    if (!added) {
+                        job->p.setException(std::make_exception_ptr(
+                            std::future_error(std::future_errc::broken_promise)));
+                    }
+                }
+                catch (...) {
+                    job->p.setException(std::current_exception());
+                }
+            });
+            return ret;
+        }
+
+        /*!
+         Attach an error handler, consuming this future. If this future holds an
+         exception, fn is called with its exception_ptr and the value it returns (which
+         must be a T) becomes the result of the returned future. Otherwise the result
+         is passed on unchanged and fn is not called. It is run in the same manner as
+         the continuation given to then().
+         @throws std::future_error with no_state if the future is not valid
+         @throws std::bad_alloc if the handler could not be allocated
+         */
+        template <class Fn>
+        Future<T> recover(Fn&& fn) {
+            Promise<T> p;
+            auto ret = p.getFuture();
+            auto st = _private::FutureAccess::release(*this);
+            auto* raw = st.get();
+            raw->setContinuation([st = std::move(st), p = std::move(p),
+                                  fn = typename std::decay<Fn>::type(std::forward<Fn>(fn))]() mutable
+            {
+                if (!st->failed()) {
+                    p.setWith([&]() -> T { return st->take(); });
+                    return;
+                }
+
+                std::exception_ptr ep;
+                try {
+                    st->take();
+                }
+                catch (...) {
+                    ep = std::current_exception();
+                }
+                p.setWith([&]() -> T { return fn(ep); });
+            });
+            return ret;
+        }
+
+        /*!
+         Complete the given promise with the result of this future once it is
+         available, consuming this future.
+         @throws std::future_error with no_state if the future is not valid
+         */
+        void forwardTo(Promise<T>&& promise) {
+            auto st = _private::FutureAccess::release(*this);
+            auto* raw = st.get();
+            raw->setContinuation([st = std::move(st), p = std::move(promise)]() mutable {
+                p.setWith([&]() -> T { return st->take(); });
+            });
+        }
+
+    private:
+        friend class Promise<T>;
+        friend struct _private::FutureAccess;
+
+        explicit Future(const std::shared_ptr<_private::FutureState<T>>& st) noexcept : state(st) {}
+
+        std::shared_ptr<_private::FutureState<T>> state;
+
+        void checkValid() const {
+            if (!state) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+        }
+    };
+
+
+    /*!
+     Returns a future that already holds the given value.
+     @throws std::bad_alloc if the shared state could not be allocated
+     */
+    template <class T>
+    Future<typename std::decay<T>::type> makeReadyFuture(T&& value) {
+        Promise<typename std::decay<T>::type> p;
+        auto ret = p.getFuture();
+        p.setValue(std::forward<T>(value));
+        return ret;
+    }
+
+    inline Future<void> makeReadyFuture() {
+        Promise<void> p;
+        auto ret = p.getFuture();
+        p.setValue();
+        return ret;
+    }
+
+    /*!
+     Returns a future that already holds the given exception.
+     @throws std::bad_alloc if the shared state could not be allocated
+     */
+    template <class T>
+    Future<T> makeExceptionalFuture(std::exception_ptr ep) {
+        Promise<T> p;
+        auto ret = p.getFuture();
+        p.setException(ep);
+        return ret;
+    }
+
+
+    namespace _private {
+
+        template <class T> struct WhenAllResult { using type = std::vector<T>; };
+        template <> struct WhenAllResult<void> { using type = void; };
+
+        template <class T> struct WhenAnyResult { using type = std::pair<std::size_t, T>; };
+        template <> struct WhenAnyResult<void> { using type = std::size_t; };
+
+        template <class T>
+        struct WhenAllState {
+            explicit WhenAllState(std::size_t n) : results(n), remaining(n) {}
+
+            std::vector<ResultSlot<T>>                      results;
+            std::atomic<std::size_t>                        remaining;
+            Promise<typename WhenAllResult<T>::type>        promise;
+
+            // Rethrows the first exception in the order of the inputs.
+            typename WhenAllResult<T>::type collect() {
+                std::vector<T> ret;
+                ret.reserve(results.size());
+                for (auto& r : results) {
+                    ret.push_back(r.take());
+                }
+                return ret;
+            }
+        };
+
+        template <>
+        inline void WhenAllState<void>::collect() {
+            for (auto& r : results) {
+                r.take();
+            }
+        }
+
+        template <class T>
+        struct WhenAnyState {
+            std::atomic<bool>                           done { false };
+            Promise<typename WhenAnyResult<T>::type>    promise;
+
+            void complete(std::size_t i, FutureState<T>& st) {
+                promise.setWith([&] { return std::make_pair(i, st.take()); });
+            }
+        };
+
+        template <>
+        inline void WhenAnyState<void>::complete(std::size_t i, FutureState<void>& st) {
+            promise.setWith([&] { st.take(); return i; });
+        }
+    }
+
+    /*!
+     Combine a number of futures into one, without waiting for them. The returned
+     future becomes ready once all of the inputs are ready. For Future<T> its result
+     is a std::vector<T> holding the results in the order of the inputs, and for
+     Future<void> it has no result. If any of the inputs hold an exception, the
+     returned future holds the first of them (in the order of the inputs).
+
+     The inputs are consumed. Whichever thread completes the last of them is the one
+     that runs the continuation of the returned future.
+     @throws std::future_error with no_state if any of the inputs are not valid
+     @throws std::bad_alloc if the shared state could not be allocated
+     */
+    template <class T>
+    Future<typename _private::WhenAllResult<T>::type> whenAll(std::vector<Future<T>> futures) {
+        for (const auto& f : futures) {
+            if (!f.valid()) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+        }
+
+        const auto n = futures.size();
+        auto all = std::make_shared<_private::WhenAllState<T>>(n);
+        auto ret = all->promise.getFuture();
+        if (n == 0) {
+            all->promise.setWith([&] { return all->collect(); });
+            return ret;
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            auto st = _private::FutureAccess::release(futures[i]);
+            auto* raw = st.get();
+            raw->setContinuation([all, i, st = std::move(st)] {
+                auto fn = [&]() -> T { return st->take(); };
+                all->results[i].set(fn);
+                if (all->remaining.fetch_sub(1) == 1) {
+                    all->promise.setWith([&] { return all->collect(); });
+                }
+            });
+        }
+        return ret;
+    }
+
+    /*!
+     Combine a number of futures into one that becomes ready as soon as the first of
+     them does. For Future<T> its result is a std::pair holding the index of that
+     input and its result, and for Future<void> it is the index. If that input holds
+     an exception, the returned future holds it instead. The results of the other
+     inputs are discarded as they arrive.
+
+     The inputs are consumed. The thread that completes the first of them is the one
+     that runs the continuation of the returned future.
+     @throws std::invalid_argument if there are no inputs
+     @throws std::future_error with no_state if any of the inputs are not valid
+     @throws std::bad_alloc if the shared state could not be allocated
+     */
+    template <class T>
+    Future<typename _private::WhenAnyResult<T>::type> whenAny(std::vector<Future<T>> futures) {
+        kss::contract::parameters({
+            KSS_EXPR(!futures.empty())
+        });
+        for (const auto& f : futures) {
+            if (!f.valid()) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+        }
+
+        auto any = std::make_shared<_private::WhenAnyState<T>>();
+        auto ret = any->promise.getFuture();
+        for (std::size_t i = 0; i < futures.size(); ++i) {
+            auto st = _private::FutureAccess::release(futures[i]);
+            auto* raw = st.get();
+            raw->setContinuation([any, i, st = std::move(st)] {
+                if (!any->done.exchange(true)) {
+                    any->complete(i, *st);
+                }
+            });
+        }
+        return ret;
+    }
+}}
+
+#endif
@@ -0,0 +1,220 @@
+//
+//  inline_function.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_inline_function_hpp
+#define kssthread_inline_function_hpp
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kss { namespace thread {
+
+    namespace _private {
+
+        template <class Fn>
+        inline bool isNullCallable(const Fn&) noexcept { return false; }
+
+        template <class Fn>
+        inline bool isNullCallable(Fn* fn) noexcept { return (fn == nullptr); }
+
+        template <class Signature>
+        inline bool isNullCallable(const std::function<Signature>& fn) noexcept { return !fn; }
+    }
+
+    template <class Signature, std::size_t Capacity = 64>
+    class InlineFunction;
+
+    /*!
+     An InlineFunction is a move-only replacement for std::function. Callables that fit
+     within Capacity bytes (and that may be moved without throwing) are stored directly
+     within the object, hence constructing, moving, and destroying them never touches
+     the heap. Larger callables are still accepted, but are allocated on the heap.
+
+     Since it is move-only, an InlineFunction may hold callables that std::function
+     cannot, such as lambdas that capture a std::unique_ptr or a std::promise.
+
+     @code
+     InlineFunction<int(int)> fn = [offset](int i) { return i + offset; };
+     auto j = fn(3);
+     @endcode
+     */
+    template <class R, class... Args, std::size_t Capacity>
+    class InlineFunction<R(Args...), Capacity> {
+    public:
+        InlineFunction() noexcept = default;
+        InlineFunction(std::nullptr_t) noexcept {}
+
+        /*!
+         Construct from any callable. If the callable is a null function pointer or an
+         empty std::function, the InlineFunction will be empty.
+         @throws std::bad_alloc if the callable does not fit and the heap allocation fails
+         @throws any exception the callable's constructor may throw
+         */
+        template <class Fn,
+                  class = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type,
+                                                                InlineFunction>::value>::type>
+        InlineFunction(Fn&& fn) {
+            if (!_private::isNullCallable(fn)) {
+                construct<typename std::decay<Fn>::type>(std::forward<Fn>(fn));
+            }
+        }
+
+        InlineFunction(InlineFunction&& other) noexcept {
+            moveFrom(other);
+        }
+
+        InlineFunction& operator=(InlineFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        InlineFunction& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        template <class Fn,
+                  class = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type,
+                                                                InlineFunction>::value>::type>
+        InlineFunction& operator=(Fn&& fn) {
+            InlineFunction tmp(std::forward<Fn>(fn));
+            return (*this = std::move(tmp));
+        }
+
+        ~InlineFunction() noexcept {
+            reset();
+        }
+
+        InlineFunction(const InlineFunction&) = delete;
+        InlineFunction& operator=(const InlineFunction&) = delete;
+
+        /*!
+         Returns true if a callable is being held.
+         */
+        explicit operator bool() const noexcept { return (ops != nullptr); }
+
+        /*!
+         Returns true if the callable is stored within the object, i.e. if it did
+         not require a heap allocation. An empty InlineFunction is considered inline.
+         */
+        bool isInline() const noexcept { return (!ops || ops->isInline); }
+
+        /*!
+         Call the callable.
+         @throws std::bad_function_call if the InlineFunction is empty
+         @throws any exception the callable may throw
+         */
+        R operator()(Args... args) const {
+            if (!ops) {
+                throw std::bad_function_call();
+            }
+            return ops->invoke(const_cast<void*>(static_cast<const void*>(&storage)),
+                               std::forward<Args>(args)...);
+        }
+
+    private:
+        using storage_t = typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+
+        struct Ops {
+            R       (*invoke)(void* storage, Args&&... args);
+            void    (*move)(void* from, void* to);
+            void    (*destroy)(void* storage);
+            bool    isInline;
+        };
+
+        template <class Fn>
+        struct InlineOps {
+            static R invoke(void* storage, Args&&... args) {
+                return (*static_cast<Fn*>(storage))(std::forward<Args>(args)...);
+            }
+            static void move(void* from, void* to) {
+                ::new (to) Fn(std::move(*static_cast<Fn*>(from)));
+                static_cast<Fn*>(from)->~Fn();
+            }
+            static void destroy(void* storage) {
+                static_cast<Fn*>(storage)->~Fn();
+            }
+            static constexpr Ops ops { &invoke, &move, &destroy, true };
+        };
+
+        template <class Fn>
+        struct HeapOps {
+            static Fn*& ptr(void* storage) { return *static_cast<Fn**>(storage); }
+            static R invoke(void* storage, Args&&... args) {
+                return (*ptr(storage))(std::forward<Args>(args)...);
+            }
+            static void move(void* from, void* to) {
+                ::new (to) Fn*(ptr(from));
+            }
+            static void destroy(void* storage) {
+                delete ptr(storage);
+            }
+            static constexpr Ops ops { &invoke, &move, &destroy, false };
+        };
+
+        template <class Fn>
+        using fitsInline = std::integral_constant<bool,
+            sizeof(Fn) <= Capacity
+            && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Fn>::value>;
+
+        storage_t   storage;
+        const Ops*  ops = nullptr;
+
+        template <class Fn, class Arg>
+        void construct(Arg&& fn) {
+            constructImpl<Fn>(std::forward<Arg>(fn), fitsInline<Fn>());
+        }
+
+        template <class Fn, class Arg>
+        void constructImpl(Arg&& fn, std::true_type) {
+            ::new (&storage) Fn(std::forward<Arg>(fn));
+            ops = &InlineOps<Fn>::ops;
+        }
+
+        template <class Fn, class Arg>
+        void constructImpl(Arg&& fn, std::false_type) {
+            ::new (&storage) Fn*(new Fn(std::forward<Arg>(fn)));
+            ops = &HeapOps<Fn>::ops;
+        }
+
+        void moveFrom(InlineFunction& other) noexcept {
+            if (other.ops) {
+                other.ops->move(&other.storage, &storage);
+                ops = other.ops;
+                other.ops = nullptr;
+            }
+        }
+
+        void reset() noexcept {
+            if (ops) {
+                ops->destroy(&storage);
+                ops = nullptr;
+            }
+        }
+    };
+
+    template <class R, class... Args, std::size_t Capacity>
+    template <class Fn>
+    constexpr typename InlineFunction<R(Args...), Capacity>::Ops
+    InlineFunction<R(Args...), Capacity>::InlineOps<Fn>::ops;
+
+    template <class R, class... Args, std::size_t Capacity>
+    template <class Fn>
+    constexpr typename InlineFunction<R(Args...), Capacity>::Ops
+    InlineFunction<R(Args...), Capacity>::HeapOps<Fn>::ops;
+}}
+
+#endif
@@ -0,0 +1,128 @@
+//
+//  instrumented_lock.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <kss/contract/all.h>
+
+#include "instrumented_lock.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+
+namespace contract = kss::contract;
+
+namespace {
+    // The registry is intentionally never destroyed so that locks living in static
+    // objects may still record into it during program exit.
+    struct Registry {
+        mutex                                   m;
+        map<string, shared_ptr<LockProfile>>    profiles;
+    };
+
+    Registry& registry() {
+        static Registry* r = new Registry();
+        return *r;
+    }
+
+    uint64_t totalWait(const LockStatistics& st) noexcept {
+        return uint64_t(st.waitTime.mean().count()) * st.waitTime.count();
+    }
+
+    string formatted(const nanoseconds& ns) {
+        const auto n = ns.count();
+        if (n < 10'000) { return to_string(n) + "ns"; }
+        if (n < 10'000'000) { return to_string(n / 1'000) + "us"; }
+        return to_string(n / 1'000'000) + "ms";
+    }
+}
+
+
+shared_ptr<LockProfile> LockProfile::named(const string& name) {
+    contract::parameters({
+        KSS_EXPR(!name.empty())
+    });
+
+    auto& r = registry();
+    lock_guard<mutex> l(r.m);
+    auto& profile = r.profiles[name];
+    if (!profile) {
+        profile = make_shared<LockProfile>(name);
+    }
+    return profile;
+}
+
+vector<LockStatistics> LockProfile::all() {
+    auto& r = registry();
+    vector<shared_ptr<LockProfile>> profiles;
+    {
+        lock_guard<mutex> l(r.m);
+        profiles.reserve(r.profiles.size());
+        for (const auto& p : r.profiles) {
+            profiles.push_back(p.second);
+        }
+    }
+
+    vector<LockStatistics> stats;
+    stats.reserve(profiles.size());
+    for (const auto& p : profiles) {
+        stats.push_back(p->statistics());
+    }
+    return stats;
+}
+
+vector<LockStatistics> LockProfile::mostContended(size_t n) {
+    auto stats = all();
+    stable_sort(stats.begin(), stats.end(), [](const LockStatistics& a, const LockStatistics& b) {
+        if (a.contended != b.contended) {
+            return a.contended > b.contended;
+        }
+        return totalWait(a) > totalWait(b);
+    });
+    if (stats.size() > n) {
+        stats.erase(stats.begin() + ptrdiff_t(n), stats.end());
+    }
+    return stats;
+}
+
+void LockProfile::dump(ostream& strm, size_t n) {
+    for (const auto& st : mostContended(n)) {
+        const auto contendedPct = (st.acquisitions ? 100.0 * double(st.contended) / double(st.acquisitions) : 0.0);
+        strm << st.name
+             << ": acquisitions=" << st.acquisitions
+             << " contended=" << st.contended
+             << " (" << fixed << setprecision(1) << contendedPct << "%)"
+             << " tryFailures=" << st.tryFailures << "/" << st.tryAttempts
+             << " (" << fixed << setprecision(1) << (100.0 * st.tryFailureRate()) << "%)"
+             << " wait[p50=" << formatted(st.waitTime.percentile(50))
+             << " p99=" << formatted(st.waitTime.percentile(99))
+             << " max=" << formatted(st.waitTime.max()) << "]"
+             << " hold[p50=" << formatted(st.holdTime.percentile(50))
+             << " p99=" << formatted(st.holdTime.percentile(99))
+             << " max=" << formatted(st.holdTime.max()) << "]"
+             << endl;
+    }
+}
+
+void LockProfile::resetAll() {
+    auto& r = registry();
+    lock_guard<mutex> l(r.m);
+    for (auto& p : r.profiles) {
+        p.second->reset();
+    }
+}
@@ -0,0 +1,351 @@
+//
+//  instrumented_lock.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// The profiling is only compiled in when KSS_THREAD_LOCK_PROFILING is defined.
+// Otherwise InstrumentedLock simply forwards to the lock it wraps. As with NDEBUG,
+// the setting must be the same in every translation unit that uses a given
+// InstrumentedLock type.
+//
+
+#ifndef kssthread_instrumented_lock_hpp
+#define kssthread_instrumented_lock_hpp
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "latency_histogram.hpp"
+
+namespace kss { namespace thread {
+
+    /*!
+     A snapshot of the contention statistics of a named lock.
+     */
+    struct LockStatistics {
+        std::string         name;
+
+        /*! Number of times the lock was obtained, by any of the locking methods. */
+        uint64_t            acquisitions = 0;
+
+        /*! Number of lock() calls that could not obtain the lock immediately. */
+        uint64_t            contended = 0;
+
+        /*! Number of try_lock(), try_lock_for() and try_lock_until() calls. */
+        uint64_t            tryAttempts = 0;
+
+        /*! Number of those that did not obtain the lock. */
+        uint64_t            tryFailures = 0;
+
+        /*! Time spent waiting for the lock by the calls that obtained it. */
+        LatencyHistogram    waitTime;
+
+        /*!
+         Time the lock was held. Only recorded when the lock is released by the thread
+         that obtained it.
+         */
+        LatencyHistogram    holdTime;
+
+        /*!
+         Returns the fraction of the try_lock calls that failed, or 0 if there were none.
+         */
+        double tryFailureRate() const noexcept {
+            return (tryAttempts ? double(tryFailures) / double(tryAttempts) : 0.0);
+        }
+    };
+
+
+    /*!
+     A LockProfile accumulates the statistics of all the instrumented locks sharing a
+     name. Profiles are created on demand by named() and live for the remainder of the
+     program, hence the static methods can report on locks that no longer exist.
+
+     All the methods are thread safe. Since a profile is shared by every lock of its
+     name, and try_lock failures are recorded without holding the lock, the recording
+     uses relaxed atomic operations rather than a mutex. Hence profiling does not
+     serialize threads that use different locks. A snapshot taken while the locks are
+     in use is not an atomic view of all the statistics, e.g. a concurrent acquisition
+     may be included in acquisitions but not yet in waitTime.
+     */
+    class LockProfile {
+    public:
+        /*!
+         Returns the profile for the given name, creating it if necessary.
+         @throws std::invalid_argument if name is empty
+         @throws std::bad_alloc if memory could not be allocated
+         */
+        static std::shared_ptr<LockProfile> named(const std::string& name);
+
+        /*!
+         Returns a snapshot of every profile, sorted by name.
+         */
+        static std::vector<LockStatistics> all();
+
+        /*!
+         Returns a snapshot of the n most contended profiles. They are ordered by the
+         number of contended acquisitions, then by the total time spent waiting.
+         */
+        static std::vector<LockStatistics> mostContended(std::size_t n);
+
+        /*!
+         Write a human readable report of the n most contended profiles to the stream,
+         one line per lock.
+         */
+        static void dump(std::ostream& strm, std::size_t n = 10);
+
+        /*!
+         Clear the statistics of every profile.
+         */
+        static void resetAll();
+
+        explicit LockProfile(const std::string& name) : profileName(name) {}
+        LockProfile(const LockProfile&) = delete;
+        LockProfile& operator=(const LockProfile&) = delete;
+
+        const std::string& name() const noexcept { return profileName; }
+
+        void recordAcquisition(const std::chrono::nanoseconds& wait, bool wasContended) noexcept {
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if (wasContended) {
+                contended.fetch_add(1, std::memory_order_relaxed);
+            }
+            waitTime.record(wait);
+        }
+
+        void recordTry(const std::chrono::nanoseconds& wait, bool obtained) noexcept {
+            tryAttempts.fetch_add(1, std::memory_order_relaxed);
+            if (obtained) {
+                acquisitions.fetch_add(1, std::memory_order_relaxed);
+                waitTime.record(wait);
+            }
+            else {
+                tryFailures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void recordHold(const std::chrono::nanoseconds& held) noexcept {
+            holdTime.record(held);
+        }
+
+        LockStatistics statistics() const {
+            LockStatistics st;
+            st.name = profileName;
+            st.acquisitions = acquisitions.load(std::memory_order_relaxed);
+            st.contended = contended.load(std::memory_order_relaxed);
+            st.tryAttempts = tryAttempts.load(std::memory_order_relaxed);
+            st.tryFailures = tryFailures.load(std::memory_order_relaxed);
+            st.waitTime = waitTime.snapshot();
+            st.holdTime = holdTime.snapshot();
+            return st;
+        }
+
+        void reset() noexcept {
+            acquisitions.store(0, std::memory_order_relaxed);
+            contended.store(0, std::memory_order_relaxed);
+            tryAttempts.store(0, std::memory_order_relaxed);
+            tryFailures.store(0, std::memory_order_relaxed);
+            waitTime.clear();
+            holdTime.clear();
+        }
+
+    private:
+        const std::string                   profileName;
+        std::atomic<uint64_t>               acquisitions { 0 };
+        std::atomic<uint64_t>               contended { 0 };
+        std::atomic<uint64_t>               tryAttempts { 0 };
+        std::atomic<uint64_t>               tryFailures { 0 };
+        _private::AtomicLatencyHistogram    waitTime;
+        _private::AtomicLatencyHistogram    holdTime;
+    };
+
+
+    namespace _private {
+
+        // The locks currently held by this thread, along with when they were obtained.
+        // Locks that are shared (read locks, semaphores) may be held by several threads
+        // at once, hence the acquisition time cannot be kept in the lock itself.
+        class HeldLocks {
+        public:
+            void push(const void* lock, const std::chrono::steady_clock::time_point& since) noexcept {
+                if (count < entries.size()) {
+                    entries[count++] = std::make_pair(lock, since);
+                }
+            }
+
+            bool pop(const void* lock, std::chrono::steady_clock::time_point& since) noexcept {
+                for (std::size_t i = count; i > 0; --i) {
+                    if (entries[i-1].first == lock) {
+                        since = entries[i-1].second;
+                        entries[i-1] = entries[--count];
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static HeldLocks& forThisThread() noexcept {
+                static thread_local HeldLocks held;
+                return held;
+            }
+
+        private:
+            std::array<std::pair<const void*, std::chrono::steady_clock::time_point>, 16> entries;
+            std::size_t count = 0;
+        };
+    }
+
+
+    /*!
+     An InstrumentedLock wraps any Lockable type (std::mutex, the locks of a
+     ReadWriteLock, Semaphore, and so on) and records how it is used in the LockProfile
+     of the given name. It is itself Lockable, and TimedLockable if the wrapped type is,
+     hence it can be used with std::lock_guard, std::unique_lock, locked(),
+     uniqueLocked(), ifLocked() and TryLockGuard.
+
+     Lockable may be a reference type, in which case the InstrumentedLock wraps an
+     existing lock. This is how the read and write locks of a ReadWriteLock, which are
+     owned by it, are instrumented.
+
+     When KSS_THREAD_LOCK_PROFILING is not defined the name is ignored and each method
+     simply calls the wrapped lock, hence the instrumentation can be left in the code.
+
+     @code
+     InstrumentedLock<std::mutex> m("cache");
+     ReadWriteLock rw;
+     InstrumentedLock<ReadWriteLock::WriteLock&> w("index.write", rw.writeLock());
+     ...
+     LockProfile::dump(std::cerr, 5);
+     @endcode
+     */
+    template <class Lockable>
+    class InstrumentedLock {
+    public:
+        /*!
+         Construct the wrapped lock from args and associate it with the named profile.
+         @throws std::invalid_argument if name is empty (profiling only)
+         @throws any exception that the wrapped lock's constructor may throw
+         */
+        template <class... Args>
+        explicit InstrumentedLock(const std::string& name, Args&&... args)
+        : _lock(std::forward<Args>(args)...)
+#if defined(KSS_THREAD_LOCK_PROFILING)
+        , _profile(LockProfile::named(name))
+#endif
+        {
+            (void)name;
+        }
+
+        InstrumentedLock(const InstrumentedLock&) = delete;
+        InstrumentedLock& operator=(const InstrumentedLock&) = delete;
+
+        /*!
+         Returns the wrapped lock.
+         */
+        std::remove_reference_t<Lockable>& underlying() noexcept { return _lock; }
+
+#if defined(KSS_THREAD_LOCK_PROFILING)
+        /*!
+         Returns the profile this lock is recording into.
+         */
+        LockProfile& profile() const noexcept { return *_profile; }
+
+        void lock() {
+            using namespace std::chrono;
+            if (_lock.try_lock()) {
+                const auto now = steady_clock::now();
+                _profile->recordAcquisition(nanoseconds::zero(), false);
+                noteHeld(now);
+            }
+            else {
+                const auto start = steady_clock::now();
+                _lock.lock();
+                const auto now = steady_clock::now();
+                _profile->recordAcquisition(duration_cast<nanoseconds>(now - start), true);
+                noteHeld(now);
+            }
+        }
+
+        bool try_lock() {
+            using namespace std::chrono;
+            const bool obtained = _lock.try_lock();
+            _profile->recordTry(nanoseconds::zero(), obtained);
+            if (obtained) {
+                noteHeld(steady_clock::now());
+            }
+            return obtained;
+        }
+
+        template <class Rep, class Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+            using namespace std::chrono;
+            const auto start = steady_clock::now();
+            return noteTimed(start, _lock.try_lock_for(dur));
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+            using namespace std::chrono;
+            const auto start = steady_clock::now();
+            return noteTimed(start, _lock.try_lock_until(tp));
+        }
+
+        void unlock() {
+            using namespace std::chrono;
+            steady_clock::time_point since;
+            if (_private::HeldLocks::forThisThread().pop(this, since)) {
+                _profile->recordHold(duration_cast<nanoseconds>(steady_clock::now() - since));
+            }
+            _lock.unlock();
+        }
+
+#else
+        void lock() { _lock.lock(); }
+        bool try_lock() { return _lock.try_lock(); }
+        void unlock() { _lock.unlock(); }
+
+        template <class Rep, class Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+            return _lock.try_lock_for(dur);
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+            return _lock.try_lock_until(tp);
+        }
+#endif
+
+    private:
+        Lockable                        _lock;
+#if defined(KSS_THREAD_LOCK_PROFILING)
+        std::shared_ptr<LockProfile>    _profile;
+
+        void noteHeld(const std::chrono::steady_clock::time_point& now) noexcept {
+            _private::HeldLocks::forThisThread().push(this, now);
+        }
+
+        bool noteTimed(const std::chrono::steady_clock::time_point& start, bool obtained) {
+            using namespace std::chrono;
+            const auto now = steady_clock::now();
+            _profile->recordTry(duration_cast<nanoseconds>(now - start), obtained);
+            if (obtained) {
+                noteHeld(now);
+            }
+            return obtained;
+        }
+#endif
+    };
+}}
+
+#endif
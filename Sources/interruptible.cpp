@@ -19,6 +19,7 @@
 #include <kss/contract/all.h>
 
 #include "interruptible.hpp"
+#include "stop_token.hpp"
 
 using namespace std;
 using namespace kss::thread;
@@ -32,6 +33,9 @@ namespace {
 // MARK: Interruptible threads
 
 void kss::thread::interruptionPoint() {
+    if (_private::currentStopToken().stopRequested()) {
+        throw Stopped();
+    }
     pthread_testcancel();
 }
 
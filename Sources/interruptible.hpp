@@ -32,6 +32,10 @@ namespace kss { namespace thread {
      ability to the thread class based on the use of the pthread_cancel and associated
      methods.
 
+     For a cheaper, cooperative alternative, see the stoppable class in stop_token.hpp.
+     It requires no system calls on entry, and a stop request directly wakes a thread
+     blocked in one of the synchronizers, an ActionQueue::wait(), or a Channel.
+
      First, some terminology. The POSIX threads discuss cancellation. This simply stops
      the thread at some point. In the following discussion I use cancellation and
      interruption almost as synonyms. The difference being that "cancel" refers to the
@@ -143,6 +147,10 @@ namespace kss { namespace thread {
      been requested. If so the thread will be cancelled. Use this in long-running
      threads that do not already have a natural interruption point.
 
+     Within a stoppable section (see stop_token.hpp) this also checks the section's
+     token, and throws Stopped if a stop has been requested.
+
+     @throws kss::thread::Stopped if a stop has been requested in a stoppable section
      @throws (sort of) an internal exception used to implement the thread cancellation.
         This method does not actually throw the exception itself, but will cause it
         to be thrown at this point if the thread has had a cancel request.
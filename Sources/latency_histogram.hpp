@@ -0,0 +1,238 @@
+//
+//  latency_histogram.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_latency_histogram_hpp
+#define kssthread_latency_histogram_hpp
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <kss/contract/all.h>
+
+namespace kss { namespace thread {
+
+    namespace _private {
+        class AtomicLatencyHistogram;
+    }
+
+    /*!
+     A LatencyHistogram counts durations in a fixed set of buckets. Each power of two
+     (in nanoseconds) is split into four equal buckets, hence a bucket is never wider
+     than 25% of its lower bound, and the whole range of std::chrono::nanoseconds is
+     covered without any allocation. Recording a value is a few arithmetic operations
+     plus an increment, which makes this suitable for recording every action or lock
+     acquisition.
+
+     This is not thread safe. The intended use is for an object to record into its
+     histogram while holding its own lock, and to hand out copies as snapshots.
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr std::size_t numberOfBuckets = 248;
+
+        /*!
+         Record a single duration. Negative durations are counted as zero.
+         */
+        void record(const std::chrono::nanoseconds& value) noexcept {
+            const auto ns = uint64_t(std::max(value.count(), std::chrono::nanoseconds::rep(0)));
+            ++buckets[bucketFor(ns)];
+            ++total;
+            sum += ns;
+            smallest = std::min(smallest, ns);
+            largest = std::max(largest, ns);
+        }
+
+        /*!
+         Add the counts of another histogram to this one.
+         */
+        void merge(const LatencyHistogram& other) noexcept {
+            for (std::size_t i = 0; i < numberOfBuckets; ++i) {
+                buckets[i] += other.buckets[i];
+            }
+            total += other.total;
+            sum += other.sum;
+            smallest = std::min(smallest, other.smallest);
+            largest = std::max(largest, other.largest);
+        }
+
+        void clear() noexcept {
+            *this = LatencyHistogram();
+        }
+
+        /*!
+         Returns the number of values that have been recorded.
+         */
+        uint64_t count() const noexcept { return total; }
+
+        /*!
+         Returns the exact minimum, maximum, and mean of the recorded values. These are
+         all zero if nothing has been recorded.
+         */
+        std::chrono::nanoseconds min() const noexcept {
+            return std::chrono::nanoseconds(total ? int64_t(smallest) : 0);
+        }
+
+        std::chrono::nanoseconds max() const noexcept {
+            return std::chrono::nanoseconds(int64_t(largest));
+        }
+
+        std::chrono::nanoseconds mean() const noexcept {
+            return std::chrono::nanoseconds(total ? int64_t(sum / total) : 0);
+        }
+
+        /*!
+         Returns an upper bound on the given percentile of the recorded values. This is
+         the upper bound of the bucket holding that value, limited to the maximum value
+         recorded. Hence percentile(100) is the exact maximum.
+         @param pct the percentile, which must be in the range [0, 100].
+         @throws std::invalid_argument if pct is out of range
+         */
+        std::chrono::nanoseconds percentile(double pct) const {
+            kss::contract::parameters({
+                KSS_EXPR(pct >= 0.0 && pct <= 100.0)
+            });
+
+            if (total == 0) {
+                return std::chrono::nanoseconds::zero();
+            }
+            const auto rank = std::max(uint64_t(1), uint64_t((pct / 100.0) * double(total) + 0.5));
+            uint64_t seen = 0;
+            for (std::size_t i = 0; i < numberOfBuckets; ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return std::chrono::nanoseconds(int64_t(std::min(upperBoundOf(i), largest)));
+                }
+            }
+            return max();
+        }
+
+        /*!
+         Access the individual buckets, e.g. to export them. Bucket i holds the values
+         in the range [bucketLowerBound(i), bucketUpperBound(i)].
+         @throws std::out_of_range if i is not less than numberOfBuckets
+         */
+        uint64_t bucketCount(std::size_t i) const { return buckets.at(i); }
+
+        static std::chrono::nanoseconds bucketLowerBound(std::size_t i) {
+            checkBucket(i);
+            return toDuration(lowerBoundOf(i));
+        }
+
+        static std::chrono::nanoseconds bucketUpperBound(std::size_t i) {
+            checkBucket(i);
+            return toDuration(upperBoundOf(i));
+        }
+
+        /*!
+         Returns the index of the bucket that the given duration would be counted in.
+         */
+        static std::size_t bucketFor(const std::chrono::nanoseconds& value) noexcept {
+            return bucketFor(uint64_t(std::max(value.count(), std::chrono::nanoseconds::rep(0))));
+        }
+
+    private:
+        friend class _private::AtomicLatencyHistogram;
+
+        std::array<uint64_t, numberOfBuckets> buckets {};
+        uint64_t total = 0;
+        uint64_t sum = 0;
+        uint64_t smallest = std::numeric_limits<uint64_t>::max();
+        uint64_t largest = 0;
+
+        // Values below 4 have a bucket each. Above that, a value with its highest bit
+        // at position e lands in one of the four buckets starting at 4*(e-1), chosen
+        // by the two bits that follow the highest one.
+        static std::size_t bucketFor(uint64_t ns) noexcept {
+            if (ns < 4) {
+                return std::size_t(ns);
+            }
+            const unsigned e = 63U - unsigned(__builtin_clzll(ns));
+            return std::size_t(4 * (e - 1) + ((ns >> (e - 2)) & 3));
+        }
+
+        static uint64_t lowerBoundOf(std::size_t i) noexcept {
+            if (i < 4) {
+                return i;
+            }
+            const unsigned e = unsigned(i / 4) + 1;
+            return (uint64_t(4) | (i % 4)) << (e - 2);
+        }
+
+        static uint64_t upperBoundOf(std::size_t i) noexcept {
+            return (i + 1 < numberOfBuckets ? lowerBoundOf(i + 1) - 1 : std::numeric_limits<uint64_t>::max());
+        }
+
+        static void checkBucket(std::size_t i) {
+            kss::contract::parameters({
+                KSS_EXPR(i < numberOfBuckets)
+            });
+        }
+
+        static std::chrono::nanoseconds toDuration(uint64_t ns) noexcept {
+            const auto limit = uint64_t(std::numeric_limits<std::chrono::nanoseconds::rep>::max());
+            return std::chrono::nanoseconds(int64_t(std::min(ns, limit)));
+        }
+    };
+
+
+    namespace _private {
+
+        // A LatencyHistogram that may be recorded into by several threads at once, using
+        // relaxed atomic operations rather than a lock. A snapshot taken while values are
+        // being recorded is not an atomic view of the whole histogram, but its count is
+        // always the sum of its buckets.
+        class AtomicLatencyHistogram {
+        public:
+            void record(const std::chrono::nanoseconds& value) noexcept {
+                const auto ns = uint64_t(std::max(value.count(), std::chrono::nanoseconds::rep(0)));
+                buckets[LatencyHistogram::bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+                sum.fetch_add(ns, std::memory_order_relaxed);
+
+                auto current = smallest.load(std::memory_order_relaxed);
+                while (ns < current && !smallest.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+                current = largest.load(std::memory_order_relaxed);
+                while (ns > current && !largest.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+            }
+
+            LatencyHistogram snapshot() const noexcept {
+                LatencyHistogram h;
+                for (std::size_t i = 0; i < LatencyHistogram::numberOfBuckets; ++i) {
+                    h.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+                    h.total += h.buckets[i];
+                }
+                h.sum = sum.load(std::memory_order_relaxed);
+                h.smallest = smallest.load(std::memory_order_relaxed);
+                h.largest = largest.load(std::memory_order_relaxed);
+                return h;
+            }
+
+            void clear() noexcept {
+                for (auto& b : buckets) {
+                    b.store(0, std::memory_order_relaxed);
+                }
+                sum.store(0, std::memory_order_relaxed);
+                smallest.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+                largest.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            std::array<std::atomic<uint64_t>, LatencyHistogram::numberOfBuckets> buckets {};
+            std::atomic<uint64_t> sum { 0 };
+            std::atomic<uint64_t> smallest { std::numeric_limits<uint64_t>::max() };
+            std::atomic<uint64_t> largest { 0 };
+        };
+    }
+}}
+
+#endif
@@ -10,10 +10,22 @@
 #ifndef kssthread_lock_hpp
 #define kssthread_lock_hpp
 
+#include <condition_variable>
 #include <mutex>
+#include <type_traits>
 
 namespace kss { namespace thread {
 
+    namespace _private {
+        // The condition variable type to use with a given lockable type. The classes
+        // that are parameterized on their lock type use this so that the default,
+        // std::mutex, keeps the cheaper std::condition_variable.
+        template <class Lockable>
+        using condition_variable_for_t = typename std::conditional<std::is_same<Lockable, std::mutex>::value,
+                                                                   std::condition_variable,
+                                                                   std::condition_variable_any>::type;
+    }
+
     /*!
      The locked method allows for a short-hand version of a lock_guard. Specifically
      you pass in a lambda that you wish to execute while protected by the given lock
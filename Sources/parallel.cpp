@@ -7,15 +7,135 @@
 //  Licensing follows the MIT License.
 //
 
+#include <chrono>
+#include <deque>
+#include <thread>
+
 #include "parallel.hpp"
 
 using namespace std;
+using namespace std::chrono;
 using namespace kss::thread;
 
+using kss::thread::_private::ChunkScheduler;
+
+namespace {
+    // A range of chunks [lo, hi) is packed into a single word.
+    inline uint64_t pack(uint64_t lo, uint64_t hi) noexcept { return (lo << 32) | hi; }
+    inline uint64_t lowerOf(uint64_t bounds) noexcept { return bounds >> 32; }
+    inline uint64_t upperOf(uint64_t bounds) noexcept { return bounds & 0xffffffffU; }
+}
+
+
+// MARK: Shared pool
+
+namespace {
+    // Threads beyond the pool size are discarded once they have been idle this long.
+    constexpr seconds maxIdleTime { 1 };
+
+    // Idle threads are kept in a stack, so that the most recently used (and hence
+    // the most likely to still be spinning, or to be in the cache) are reused first,
+    // and those at the bottom have been idle the longest.
+    class SharedPool {
+    public:
+        static SharedPool& instance() {
+            static SharedPool pool;
+            return pool;
+        }
+
+        void acquire(_private::pooled_thread_t* threads, size_t n) {
+            size_t i = 0;
+            {
+                lock_guard<mutex> l(lock);
+                for (; i < n && !idle.empty(); ++i) {
+                    threads[i] = move(idle.back().thread);
+                    idle.pop_back();
+                }
+            }
+            try {
+                for (; i < n; ++i) {
+                    threads[i].reset(new ActionThread<void>());
+                }
+            }
+            catch (...) {
+                release(threads, i);
+                throw;
+            }
+        }
+
+        void release(_private::pooled_thread_t* threads, size_t n) noexcept {
+            const auto now = steady_clock::now();
+            deque<Idle> expired;
+            {
+                lock_guard<mutex> l(lock);
+                for (size_t i = 0; i < n; ++i) {
+                    if (threads[i]) {
+                        idle.push_back(Idle { move(threads[i]), now });
+                    }
+                }
+                while (idle.size() > size && (now - idle.front().lastUsed) > maxIdleTime) {
+                    expired.push_back(move(idle.front()));
+                    idle.pop_front();
+                }
+            }
+            // expired is destroyed, and its threads joined, after the lock is released.
+        }
+
+        void setSize(unsigned numberOfThreads) {
+            lock_guard<mutex> l(lock);
+            size = numberOfThreads;
+        }
+
+        unsigned getSize() noexcept {
+            lock_guard<mutex> l(lock);
+            return size;
+        }
+
+    private:
+        struct Idle {
+            _private::pooled_thread_t       thread;
+            steady_clock::time_point        lastUsed;
+        };
+
+        mutex       lock;
+        deque<Idle> idle;
+        unsigned    size = max(std::thread::hardware_concurrency(), 1U);
+    };
+}
+
+void kss::thread::setParallelPoolSize(unsigned numberOfThreads) {
+    kss::contract::parameters({
+        KSS_EXPR(numberOfThreads > 0)
+    });
+    SharedPool::instance().setSize(numberOfThreads);
+}
+
+unsigned kss::thread::parallelPoolSize() noexcept {
+    return SharedPool::instance().getSize();
+}
+
+void kss::thread::_private::acquirePooledThreads(pooled_thread_t* threads, size_t n) {
+    SharedPool::instance().acquire(threads, n);
+}
+
+void kss::thread::_private::releasePooledThreads(pooled_thread_t* threads, size_t n) noexcept {
+    SharedPool::instance().release(threads, n);
+}
+
+
+// MARK: FirstFailure
+
+void kss::thread::_private::FirstFailure::fail(exception_ptr ep) noexcept {
+    lock_guard<mutex> l(errorLock);
+    if (!error) {
+        error = ep;
+    }
+    source.requestStop();
+}
 
-void kss::thread::_private::waitForAll(vector<future<void>> &futures) {
-    for (auto& fut : futures) {
-        fut.wait();
+void kss::thread::_private::FirstFailure::rethrowIfFailed() {
+    if (error) {
+        rethrow_exception(error);
     }
 }
 
@@ -23,8 +143,96 @@ void kss::thread::_private::waitForAll(vector<future<void>> &futures) {
 // MARK: ParallelThreadGroup
 
 void ParallelThreadGroup::waitForAll() {
-    if (!futures.empty()) {
-        _private::waitForAll(futures);
-        futures.clear();
+    // Every thread must be waited for, and its result taken, before we may throw.
+    exception_ptr error;
+    const auto n = numberStarted;
+    numberStarted = 0;
+    for (size_t i = 0; i < n; ++i) {
+        try {
+            threads[i].get();
+        }
+        catch (...) {
+            if (!error) {
+                error = current_exception();
+            }
+        }
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+
+// MARK: ChunkScheduler
+
+constexpr size_t ChunkScheduler::maxChunks;
+
+ChunkScheduler::ChunkScheduler(size_t numberOfParticipants, size_t numberOfChunks)
+: ranges(numberOfParticipants)
+{
+    kss::contract::parameters({
+        KSS_EXPR(numberOfParticipants > 0),
+        KSS_EXPR(numberOfChunks <= maxChunks)
+    });
+
+    for (size_t p = 0; p < numberOfParticipants; ++p) {
+        const auto lo = (numberOfChunks * p) / numberOfParticipants;
+        const auto hi = (numberOfChunks * (p + 1)) / numberOfParticipants;
+        ranges[p].bounds.store(pack(lo, hi), memory_order_relaxed);
+    }
+}
+
+bool ChunkScheduler::next(size_t participant, size_t& chunk) noexcept {
+    if (failed.load(memory_order_relaxed)) {
+        return false;
+    }
+
+    auto& bounds = ranges[participant].bounds;
+    auto b = bounds.load(memory_order_acquire);
+    while (lowerOf(b) < upperOf(b)) {
+        if (bounds.compare_exchange_weak(b, pack(lowerOf(b) + 1, upperOf(b)), memory_order_acq_rel)) {
+            chunk = size_t(lowerOf(b));
+            return true;
+        }
+    }
+    return steal(participant, chunk);
+}
+
+// Steal the back half of the first non-empty range we find, keeping the first
+// stolen chunk for ourselves and placing the rest into our (currently empty) range.
+// No other thread modifies an empty range, hence we may simply store our new one.
+//
+// Note that a range may only shrink, or, when empty, be replaced by chunks
+// that have never been taken. Hence a stale value can never match a newer one,
+// and the compare-and-swap operations are not subject to the ABA problem.
+bool ChunkScheduler::steal(size_t participant, size_t& chunk) noexcept {
+    const auto n = ranges.size();
+    for (size_t i = 1; i < n; ++i) {
+        auto& victim = ranges[(participant + i) % n].bounds;
+        auto b = victim.load(memory_order_acquire);
+        while (lowerOf(b) < upperOf(b)) {
+            const auto remaining = upperOf(b) - lowerOf(b);
+            const auto newUpper = upperOf(b) - ((remaining + 1) / 2);
+            if (victim.compare_exchange_weak(b, pack(lowerOf(b), newUpper), memory_order_acq_rel)) {
+                chunk = size_t(newUpper);
+                ranges[participant].bounds.store(pack(newUpper + 1, upperOf(b)), memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ChunkScheduler::fail(exception_ptr ep) noexcept {
+    lock_guard<mutex> l(errorLock);
+    if (!error) {
+        error = ep;
+    }
+    failed = true;
+}
+
+void ChunkScheduler::rethrowIfFailed() {
+    if (failed) {
+        rethrow_exception(error);
     }
 }
@@ -7,49 +7,130 @@
 //  Licensing follows the MIT License.
 //
 
-// This is a re-write of the earlier "Processor" class to make use of the C++11 async
-// call. As part of this we have dropped the sequential portions of the class and have
-// replaced the parallel portions with a single "parallel" function. This function runs
-// all the actions it is given using async, then waits for all the futures to complete
-// before returning.
+// This is a re-write of the earlier "Processor" class. As part of this we have dropped
+// the sequential portions of the class and have replaced the parallel portions with a
+// single "parallel" function. This function runs all the actions it is given using
+// threads from a process-wide pool, then waits for all of them to complete before
+// returning.
 
 // There is a second version of parallel() that takes a pre-defined cache of threads
 // (called a ParallelThreadGroup in this API). This runs the workers in the existing
 // threads rather than generating new ones each time.
 
+// Both versions have a parallelCancellable() counterpart whose actions are given a
+// StopToken. When one of those actions throws, a stop is requested of the others
+// so that they may return early, and the first exception is rethrown once all the
+// actions have returned.
+
 #ifndef kssthread_parallel_hpp
 #define kssthread_parallel_hpp
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <kss/contract/all.h>
 #include <kss/util/all.h>
 
 #include "action_thread.hpp"
+#include "future.hpp"
+#include "stop_token.hpp"
 
 namespace kss {
     namespace thread {
 
         namespace _private {
 
-            template <typename Action>
-            void startActions(std::vector<std::future<void>>& futures, const Action& action) {
-                futures.emplace_back(std::async(action));
-            }
+            using pooled_thread_t = std::unique_ptr<ActionThread<void>>;
 
-            template <typename Action, typename... Actions>
-            void startActions(std::vector<std::future<void>>& futures,
-                              const Action& action,
-                              const Actions& ... actions)
-            {
-                startActions(futures, action);
-                startActions(futures, actions...);
-            }
+            // Check out n threads from the shared pool, creating new ones if there are
+            // not enough idle ones, and return them to the pool.
+            void acquirePooledThreads(pooled_thread_t* threads, size_t n);
+            void releasePooledThreads(pooled_thread_t* threads, size_t n) noexcept;
+
+            /*!
+             Runs the actions given to parallelCancellable(). The first exception thrown
+             by an action is kept, and causes a stop to be requested of the others.
+             */
+            class FirstFailure {
+            public:
+                FirstFailure() : stopToken(source.token()) {}
+
+                template <class Action>
+                void run(const Action& action) noexcept {
+                    try {
+                        action(stopToken);
+                    }
+                    catch (...) {
+                        fail(std::current_exception());
+                    }
+                }
+
+                void fail(std::exception_ptr ep) noexcept;
+                void rethrowIfFailed();
 
-            void waitForAll(std::vector<std::future<void>>& futures);
+            private:
+                StopSource          source;
+                const StopToken     stopToken;
+                std::mutex          errorLock;
+                std::exception_ptr  error;
+            };
+
+            /*!
+             The work-stealing scheduler used by parallelFor() and parallelReduce(). The
+             chunks are initially divided evenly among the participants. Each participant
+             takes chunks from the front of its own range and, once that is empty, steals
+             half of the remaining chunks from the back of another participant's range.
+             Each range is kept in a single atomic word, so that taking and stealing are
+             both a single compare-and-swap.
+             */
+            class ChunkScheduler {
+            public:
+                ChunkScheduler(size_t numberOfParticipants, size_t numberOfChunks);
 
+                /*!
+                 Obtain the next chunk to be processed by the given participant. Returns
+                 false when there are no more chunks, or if some participant has failed.
+                 */
+                bool next(size_t participant, size_t& chunk) noexcept;
+
+                /*!
+                 Record that a participant has failed. Only the first exception is kept,
+                 and no further chunks will be handed out.
+                 */
+                void fail(std::exception_ptr ep) noexcept;
+
+                /*!
+                 Rethrow the first failure, if there was one.
+                 */
+                void rethrowIfFailed();
+
+                // The maximum number of chunks that a scheduler will accept.
+                static constexpr size_t maxChunks = std::numeric_limits<uint32_t>::max();
+
+            private:
+                // Padded to keep each participant's range in its own cache line.
+                struct Range {
+                    std::atomic<uint64_t>   bounds;
+                    char                    padding[64 - sizeof(std::atomic<uint64_t>)];
+                };
+
+                std::vector<Range>  ranges;
+                std::atomic<bool>   failed { false };
+                std::mutex          errorLock;
+                std::exception_ptr  error;
+
+                bool steal(size_t participant, size_t& chunk) noexcept;
+            };
         }
 
 
@@ -65,6 +146,19 @@ namespace kss {
              */
             explicit ParallelThreadGroup(size_t numberOfThreads) : threads(numberOfThreads) {}
 
+            /*!
+             Create a thread group with the given number of threads, applying the given
+             attributes to each of them.
+             @throws any exception that thread creation or ThreadAttributes::apply() may throw
+             */
+            ParallelThreadGroup(size_t numberOfThreads, const ThreadAttributes& attributes)
+            : threads(numberOfThreads)
+            {
+                for (auto& th : threads) {
+                    th.applyAttributes(attributes);
+                }
+            }
+
             /*!
              Returns the number of threads in this thread group.
              */
@@ -86,12 +180,12 @@ namespace kss {
                 // for creating this class is to allow a very low overhead version
                 // of the parallel() method.
                 kss::contract::preconditions({
-                    KSS_EXPR(futures.size() < threads.size())
+                    KSS_EXPR(numberStarted < threads.size())
                 });
 #               endif
 
-                const auto nextThreadNo = futures.size();
-                futures.emplace_back(threads[nextThreadNo].async(action));
+                threads[numberStarted].run(action);
+                ++numberStarted;
             }
 
             template <typename Action, typename... Actions>
@@ -100,42 +194,156 @@ namespace kss {
                 startActions(actions...);
             }
 
+            /*!
+             Start an action on the next thread, as startActions() does, but return a
+             Future for its result. The future (e.g. combined with others using
+             whenAll()) may be given a continuation instead of calling waitForAll() to
+             obtain the results. The same rules as for startActions() apply, hence
+             waitForAll() must still be called before the threads are reused. Since the
+             exceptions of these actions are given to their futures, waitForAll() will
+             not throw them.
+             @throws std::bad_alloc if the future's state could not be allocated
+             */
+            template <typename Fn>
+            Future<decltype(std::declval<typename std::decay<Fn>::type&>()())> submit(Fn&& fn) {
+#               if !defined(NDEBUG)
+                kss::contract::preconditions({
+                    KSS_EXPR(numberStarted < threads.size())
+                });
+#               endif
+
+                using R = decltype(std::declval<typename std::decay<Fn>::type&>()());
+                Promise<R> p;
+                auto fut = p.getFuture();
+                threads[numberStarted].run([p = std::move(p),
+                                            fn = typename std::decay<Fn>::type(std::forward<Fn>(fn))]() mutable
+                {
+                    p.setWith(fn);
+                });
+                ++numberStarted;
+                return fut;
+            }
+
             /*!
              Block the current thread until all the threads in this group have completed
-             their current task. Note that after this you can call runOnThread() again
+             their current task. Note that after this you can call startActions() again
              with new tasks.
-             @throws any exception that condition variables may throw
+             @throws the first exception (in the order the actions were started) thrown
+                by any of the actions. All the threads will have completed before it is
+                thrown.
              */
             void waitForAll();
 
         private:
             std::vector<ActionThread<void>> threads;
-            std::vector<std::future<void>>  futures;
+            size_t                          numberStarted = 0;
         };
 
 
         /*!
-         Run a number of actions, potentially in parallel, using the async method.
-         Note that at least two actions are required. The advantage of this over the
-         other parallel() method is that you don't have to create a ParallelThreadGroup
-         class.
-
-         This version of parallel() should be preferred if you are calling large actions
-         (i.e. ones that run for awhile) once, or at most a few times such that the
-         overhead of creating and destroying the threads is not significant.
-
-         @throws any exceptions that the actions may throw
-         @throws any exceptions that std::async may throw
-         @throws any exceptions that std::future<void>::wait may throw
+         Set the number of threads kept by the shared pool used by the non-group
+         versions of parallel() and parallelCancellable(). The default is the number
+         of hardware threads (or 1 if that cannot be determined).
+
+         The pool is created the first time it is needed, and its threads are created
+         as they are needed. A call to parallel() checks out one thread for each of its
+         actions other than the first, which runs in the calling thread, and returns
+         them when it is done. Creating a thread only happens when more threads are
+         busy than the pool has ever held, hence nested and concurrent calls still run
+         all of their actions at the same time. Idle threads beyond this number are
+         discarded once they have gone unused for about a second.
+
+         @throws std::invalid_argument if numberOfThreads is 0
+         */
+        void setParallelPoolSize(unsigned numberOfThreads);
+
+        /*!
+         Returns the number of threads kept by the shared pool.
+         */
+        unsigned parallelPoolSize() noexcept;
+
+        namespace _private {
+
+            // The threads checked out from the shared pool by a call to parallel().
+            template <size_t N>
+            class PooledThreads {
+            public:
+                PooledThreads() { acquirePooledThreads(threads, N); }
+
+                ~PooledThreads() noexcept {
+                    for (size_t i = 0; i < numberStarted; ++i) {
+                        threads[i]->wait();
+                    }
+                    releasePooledThreads(threads, N);
+                }
+
+                PooledThreads(const PooledThreads&) = delete;
+                PooledThreads& operator=(const PooledThreads&) = delete;
+
+                template <typename Action>
+                void startActions(const Action& action) {
+                    threads[numberStarted]->run(action);
+                    ++numberStarted;
+                }
+
+                template <typename Action, typename... Actions>
+                void startActions(const Action& action, const Actions& ... actions) {
+                    startActions(action);
+                    startActions(actions...);
+                }
+
+                // Wait for all the started actions, then rethrow the first exception
+                // (in the order the actions were started) that any of them threw.
+                void waitForAll() {
+                    std::exception_ptr error;
+                    const auto n = numberStarted;
+                    numberStarted = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        try {
+                            threads[i]->get();
+                        }
+                        catch (...) {
+                            if (!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                }
+
+            private:
+                pooled_thread_t threads[N];
+                size_t          numberStarted = 0;
+            };
+        }
+
+        /*!
+         Run a number of actions, potentially in parallel, using threads from a shared
+         process-wide pool (see setParallelPoolSize()). Note that at least two actions
+         are required. The advantage of this over the other parallel() method is that
+         you don't have to create a ParallelThreadGroup class.
+
+         Each action other than the first runs in its own thread, so the actions may
+         safely wait on one another. Note that the pool threads are reused, hence any
+         thread_local state they hold persists from one action to the next.
+
+         This version of parallel() should be preferred if you are calling actions
+         occasionally, or from many places, such that keeping your own thread group
+         is not worthwhile.
+
+         @throws the first exception thrown by action1, or if it does not throw, the
+            first (in argument order) exception thrown by the other actions. In either
+            case all the actions will have completed before it is thrown.
+         @throws std::system_error if a new thread needs to be created and cannot be
          */
         template <typename Action, typename... Actions>
         void parallel(const Action& action1, const Actions& ... actions) {
-            std::vector<std::future<void>> futures;
-            futures.reserve(sizeof...(Actions));
-
-            _private::startActions(futures, actions...);
+            _private::PooledThreads<sizeof...(Actions)> threads;
+            threads.startActions(actions...);
             action1();
-            _private::waitForAll(futures);
+            threads.waitForAll();
         }
 
         /*!
@@ -152,9 +360,9 @@ namespace kss {
 
          @throws std::invalid_argument if there are too many actions for the thread group
             (only checked in debug mode so be careful)
-         @throws any exceptions that the actions may throw
-         @throws any exceptions that std::async may throw
-         @throws any exceptions that std::future<void>::wait may throw
+         @throws the first exception thrown by action1, or if it does not throw, the
+            first (in argument order) exception thrown by the other actions. In either
+            case all the actions will have completed before it is thrown.
          */
         template <typename Action, typename... Actions>
         void parallel(ParallelThreadGroup& tg,
@@ -174,9 +382,214 @@ namespace kss {
 #           endif
 
             tg.startActions(actions...);
-            action1();
+            try {
+                action1();
+            }
+            catch (...) {
+                try {
+                    tg.waitForAll();
+                }
+                catch (...) {
+                    // Intentionally empty, action1's exception takes precedence.
+                }
+                throw;
+            }
             tg.waitForAll();
         }
+
+        /*!
+         Run a number of actions, potentially in parallel, that may be cooperatively
+         cancelled. Each action is called with a const StopToken& and should check
+         stopRequested() periodically, returning early when it is true. If any action
+         throws an exception, a stop is requested of the others and, once all of them
+         have returned, the first exception is rethrown.
+
+         \code
+         parallelCancellable([&](const StopToken& st) {
+            for (auto& item : firstHalf) {
+                if (st.stopRequested()) return;
+                process(item);
+            }
+         }, [&](const StopToken& st) {
+            ...
+         });
+         \endcode
+
+         Note that an action that does not check its token simply runs to completion.
+
+         @throws the first exception thrown by any of the actions
+         @throws std::system_error if a new thread needs to be created and cannot be
+         */
+        template <typename Action, typename... Actions>
+        void parallelCancellable(const Action& action1, const Actions& ... actions) {
+            _private::FirstFailure failure;
+            parallel([&failure, &action1] { failure.run(action1); },
+                     [&failure, &actions] { failure.run(actions); }...);
+            failure.rethrowIfFailed();
+        }
+
+        /*!
+         Run a number of actions that may be cooperatively cancelled, using a cache of
+         threads. This is the same as the above parallelCancellable() except that the
+         actions, other than the first, are run using the threads of the group. The
+         group must have at least (number of actions - 1) threads.
+
+         @throws std::invalid_argument if there are too many actions for the thread group
+            (only checked in debug mode so be careful)
+         @throws the first exception thrown by any of the actions
+         */
+        template <typename Action, typename... Actions>
+        void parallelCancellable(ParallelThreadGroup& tg,
+                                 const Action& action1,
+                                 const Actions& ... actions)
+        {
+            _private::FirstFailure failure;
+            parallel(tg,
+                     [&failure, &action1] { failure.run(action1); },
+                     [&failure, &actions] { failure.run(actions); }...);
+            failure.rethrowIfFailed();
+        }
+
+
+        namespace _private {
+
+            // Run body(participant) on each thread of the group and on the current
+            // thread, which is participant 0.
+            template <class Body>
+            void runParticipants(ParallelThreadGroup& tg, ChunkScheduler& scheduler, const Body& body) {
+                const auto participant = [&scheduler, &body](size_t p) {
+                    try {
+                        body(p);
+                    }
+                    catch (...) {
+                        scheduler.fail(std::current_exception());
+                    }
+                };
+
+                for (size_t p = 1; p <= tg.size(); ++p) {
+                    tg.startActions([&participant, p] { participant(p); });
+                }
+                participant(0);
+                tg.waitForAll();
+                scheduler.rethrowIfFailed();
+            }
+
+            // The chunk size for a non-empty range, which is grain unless that would
+            // produce more than maxChunks chunks.
+            template <class Index>
+            size_t chunkSizeFor(Index first, Index last, Index grain, size_t maxChunks = ChunkScheduler::maxChunks) {
+                const auto n = size_t(last - first);
+                const auto minGrain = (n / maxChunks) + 1;
+                return std::max(size_t(grain), minGrain);
+            }
+
+            // The maximum number of chunks per participant in parallelReduce(), which
+            // keeps a partial result for each chunk.
+            constexpr size_t maxReduceChunksPerParticipant = 64;
+        }
+
+        /*!
+         Call fn(i) for each i in [first, last), using the threads of the group (plus the
+         current thread) to process the range in parallel. The range is broken into chunks
+         of grain indices, and the chunks are balanced between the threads by work
+         stealing, so the amount of work per index need not be uniform. A grain should be
+         chosen large enough that the cost of processing a chunk is significantly more
+         than the cost of obtaining one (a single atomic operation).
+
+         Index must be an integral type. Note that fn may be called concurrently from
+         multiple threads, and that the order in which the indices are processed is
+         not specified.
+
+         @throws std::invalid_argument if grain is not positive
+         @throws the first exception thrown by fn. Once fn has thrown, no further chunks
+            are started, although the chunks already in progress are allowed to complete.
+         @throws std::system_error if waiting for the threads of the group fails
+         */
+        template <class Index, class Fn>
+        void parallelFor(ParallelThreadGroup& tg, Index first, Index last, Index grain, const Fn& fn) {
+            kss::contract::parameters({
+                KSS_EXPR(grain > 0)
+            });
+            if (!(first < last)) {
+                return;
+            }
+
+            const auto chunkSize = _private::chunkSizeFor(first, last, grain);
+            const auto n = size_t(last - first);
+            _private::ChunkScheduler scheduler(tg.size() + 1, (n + chunkSize - 1) / chunkSize);
+            _private::runParticipants(tg, scheduler, [&](size_t p) {
+                size_t chunk = 0;
+                while (scheduler.next(p, chunk)) {
+                    const auto b = first + Index(chunk * chunkSize);
+                    const auto e = (size_t(last - b) > chunkSize ? Index(b + Index(chunkSize)) : last);
+                    for (auto i = b; i < e; ++i) {
+                        fn(i);
+                    }
+                }
+            });
+        }
+
+        /*!
+         Compute reduce(...reduce(reduce(identity, map(first)), map(first+1))..., map(last-1))
+         in parallel using the threads of the group plus the current thread. Each chunk
+         (see parallelFor()) is folded into its own partial result, starting from identity,
+         and the partial results are then combined, in chunk order, in the current thread.
+         To bound the number of partial results, the grain is increased if the range would
+         otherwise have more than 64 chunks per thread.
+
+         Since the chunks are folded separately, reduce must be associative and identity
+         must be an identity value for reduce, but it need not be commutative. Note that
+         associativity is not quite true of floating point addition, so floating point
+         results may vary slightly from one call to the next.
+
+         @param map called as map(i) for each index, must return a value convertible to T.
+         @param reduce called as reduce(t1, t2), must return a value convertible to T.
+         @throws std::invalid_argument if grain is not positive
+         @throws the first exception thrown by map or reduce
+         @throws std::system_error if waiting for the threads of the group fails
+         */
+        template <class T, class Index, class MapFn, class ReduceFn>
+        T parallelReduce(ParallelThreadGroup& tg,
+                         Index first,
+                         Index last,
+                         Index grain,
+                         const T& identity,
+                         const MapFn& map,
+                         const ReduceFn& reduce)
+        {
+            kss::contract::parameters({
+                KSS_EXPR(grain > 0)
+            });
+            if (!(first < last)) {
+                return identity;
+            }
+
+            const auto numberOfParticipants = tg.size() + 1;
+            const auto chunkSize = _private::chunkSizeFor(first, last, grain, numberOfParticipants
+                                                          * _private::maxReduceChunksPerParticipant);
+            const auto n = size_t(last - first);
+            const auto numberOfChunks = (n + chunkSize - 1) / chunkSize;
+            std::vector<T> partials(numberOfChunks, identity);
+            _private::ChunkScheduler scheduler(numberOfParticipants, numberOfChunks);
+            _private::runParticipants(tg, scheduler, [&](size_t p) {
+                size_t chunk = 0;
+                while (scheduler.next(p, chunk)) {
+                    const auto b = first + Index(chunk * chunkSize);
+                    const auto e = (size_t(last - b) > chunkSize ? Index(b + Index(chunkSize)) : last);
+                    T local = identity;
+                    for (auto i = b; i < e; ++i) {
+                        local = reduce(local, map(i));
+                    }
+                    partials[chunk] = std::move(local);
+                }
+            });
+
+            T result = identity;
+            for (auto& partial : partials) {
+                result = reduce(result, partial);
+            }
+            return result;
+        }
     }
 }
 
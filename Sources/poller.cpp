@@ -0,0 +1,238 @@
+//
+//  poller.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+
+#include <syslog.h>
+#include <unistd.h>
+
+#if defined(__linux)
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#   define KSS_THREAD_HAVE_KQUEUE 1
+#   include <sys/types.h>
+#   include <sys/event.h>
+#   include <sys/time.h>
+#endif
+
+#include "atomic_wait.hpp"
+#include "poller.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread::_private;
+
+namespace {
+    constexpr size_t maxEventsPerWait = 64;
+
+    void throwIfError(int ret, const char* methodname) {
+        if (ret == -1) {
+            throw system_error(errno, system_category(), methodname);
+        }
+    }
+
+    // Round up so that we never return before the deadline, other than when woken.
+    // The maximum deadline is an infinite (-1) timeout.
+    int timeoutMillis(const steady_clock::time_point& deadline) noexcept {
+        if (deadline == steady_clock::time_point::max()) {
+            return -1;
+        }
+        const auto remaining = deadline - steady_clock::now();
+        if (remaining <= steady_clock::duration::zero()) {
+            return 0;
+        }
+        auto ms = duration_cast<milliseconds>(remaining);
+        if (ms < remaining) {
+            ++ms;
+        }
+        return int(min<milliseconds::rep>(ms.count(), INT32_MAX));
+    }
+}
+
+
+#if defined(__linux)
+
+Poller::Poller() {
+    pollFd = epoll_create1(EPOLL_CLOEXEC);
+    throwIfError(pollFd, "epoll_create1");
+    try {
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        throwIfError(wakeFd, "eventfd");
+
+        epoll_event ev {};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeFd;
+        throwIfError(epoll_ctl(pollFd, EPOLL_CTL_ADD, wakeFd, &ev), "epoll_ctl");
+    }
+    catch (...) {
+        if (wakeFd != -1) {
+            close(wakeFd);
+        }
+        close(pollFd);
+        throw;
+    }
+}
+
+Poller::~Poller() noexcept {
+    close(wakeFd);
+    close(pollFd);
+}
+
+void Poller::add(int fd, unsigned events) {
+    epoll_event ev {};
+    ev.events = EPOLLRDHUP;
+    if (events & readable) { ev.events |= EPOLLIN; }
+    if (events & writable) { ev.events |= EPOLLOUT; }
+    ev.data.fd = fd;
+    throwIfError(epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &ev), "epoll_ctl");
+}
+
+void Poller::remove(int fd) noexcept {
+    epoll_event ev {};
+    epoll_ctl(pollFd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+void Poller::wait(ready_t& ready, const steady_clock::time_point& deadline) noexcept {
+    epoll_event events[maxEventsPerWait];
+    const auto n = epoll_wait(pollFd, events, int(maxEventsPerWait), timeoutMillis(deadline));
+    if (n == -1) {
+        if (errno != EINTR) {
+            syslog(LOG_ERR, "[%s] epoll_wait failed, errno=%d", __PRETTY_FUNCTION__, errno);
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const auto& ev = events[i];
+        if (ev.data.fd == wakeFd) {
+            uint64_t value = 0;
+            (void)::read(wakeFd, &value, sizeof(value));
+            continue;
+        }
+
+        unsigned flags = 0;
+        if (ev.events & (EPOLLIN | EPOLLPRI)) { flags |= readable; }
+        if (ev.events & EPOLLOUT) { flags |= writable; }
+        if (ev.events & (EPOLLHUP | EPOLLRDHUP)) { flags |= hangup; }
+        if (ev.events & EPOLLERR) { flags |= error; }
+        ready.emplace_back(ev.data.fd, flags);
+    }
+}
+
+void Poller::wake() noexcept {
+    const uint64_t value = 1;
+    (void)::write(wakeFd, &value, sizeof(value));
+}
+
+#elif defined(KSS_THREAD_HAVE_KQUEUE)
+
+namespace {
+    // The identifier of the EVFILT_USER event used by wake().
+    constexpr uintptr_t wakeIdent = 0;
+}
+
+Poller::Poller() {
+    pollFd = kqueue();
+    throwIfError(pollFd, "kqueue");
+
+    struct kevent ev;
+    EV_SET(&ev, wakeIdent, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+    if (kevent(pollFd, &ev, 1, nullptr, 0, nullptr) == -1) {
+        const auto err = errno;
+        close(pollFd);
+        throw system_error(err, system_category(), "kevent");
+    }
+}
+
+Poller::~Poller() noexcept {
+    close(pollFd);
+}
+
+void Poller::add(int fd, unsigned events) {
+    struct kevent evs[2];
+    int n = 0;
+    if (events & readable) { EV_SET(&evs[n++], uintptr_t(fd), EVFILT_READ, EV_ADD, 0, 0, nullptr); }
+    if (events & writable) { EV_SET(&evs[n++], uintptr_t(fd), EVFILT_WRITE, EV_ADD, 0, 0, nullptr); }
+    throwIfError(kevent(pollFd, evs, n, nullptr, 0, nullptr), "kevent");
+}
+
+// Each filter is deleted separately, since deleting a filter that was never added
+// fails and would prevent the other from being deleted.
+void Poller::remove(int fd) noexcept {
+    struct kevent ev;
+    EV_SET(&ev, uintptr_t(fd), EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+    kevent(pollFd, &ev, 1, nullptr, 0, nullptr);
+    EV_SET(&ev, uintptr_t(fd), EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+    kevent(pollFd, &ev, 1, nullptr, 0, nullptr);
+}
+
+void Poller::wait(ready_t& ready, const steady_clock::time_point& deadline) noexcept {
+    struct kevent events[maxEventsPerWait];
+    const auto remaining = max(deadline - steady_clock::now(), steady_clock::duration::zero());
+    const auto ts = toTimespec(duration_cast<nanoseconds>(remaining));
+    const bool forever = (deadline == steady_clock::time_point::max());
+    const auto n = kevent(pollFd, nullptr, 0, events, int(maxEventsPerWait), forever ? nullptr : &ts);
+    if (n == -1) {
+        if (errno != EINTR) {
+            syslog(LOG_ERR, "[%s] kevent failed, errno=%d", __PRETTY_FUNCTION__, errno);
+        }
+        return;
+    }
+
+    // The read and write filters of a descriptor are reported separately, but
+    // are merged into a single entry.
+    const auto first = ready.size();
+    for (int i = 0; i < n; ++i) {
+        const auto& ev = events[i];
+        if (ev.filter == EVFILT_USER) {
+            continue;
+        }
+
+        unsigned flags = 0;
+        if (ev.filter == EVFILT_WRITE) { flags |= writable; } else { flags |= readable; }
+        if (ev.flags & EV_EOF) { flags |= hangup; }
+        if (ev.flags & EV_ERROR) { flags = error; }
+
+        const int fd = int(ev.ident);
+        auto it = find_if(ready.begin() + ptrdiff_t(first), ready.end(), [fd](const ready_t::value_type& r) {
+            return r.first == fd;
+        });
+        if (it != ready.end()) {
+            it->second |= flags;
+        }
+        else {
+            ready.emplace_back(fd, flags);
+        }
+    }
+}
+
+void Poller::wake() noexcept {
+    struct kevent ev;
+    EV_SET(&ev, wakeIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+    kevent(pollFd, &ev, 1, nullptr, 0, nullptr);
+}
+
+#else
+
+Poller::Poller() {
+    throw system_error(ENOTSUP, system_category(), "Poller (neither epoll nor kqueue is available)");
+}
+
+Poller::~Poller() noexcept {}
+void Poller::add(int, unsigned) {}
+void Poller::remove(int) noexcept {}
+void Poller::wait(ready_t&, const steady_clock::time_point&) noexcept {}
+void Poller::wake() noexcept {}
+
+#endif
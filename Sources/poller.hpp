@@ -0,0 +1,64 @@
+//
+//  poller.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+// Internal support for IOActionQueue. The items in this file are not intended to be
+// used directly.
+//
+
+#ifndef kssthread_poller_hpp
+#define kssthread_poller_hpp
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+namespace kss { namespace thread { namespace _private {
+
+    // A thin wrapper around epoll (Linux) or kqueue (macOS and the BSDs), along with
+    // the eventfd (or EVFILT_USER event) used to wake a thread waiting in it. The
+    // events are the IOActionQueue readable, writable, hangup and error bits. All the
+    // methods may be called from any thread.
+    class Poller {
+    public:
+        using ready_t = std::vector<std::pair<int, unsigned>>;
+
+        static constexpr unsigned readable = 1;
+        static constexpr unsigned writable = 2;
+        static constexpr unsigned hangup = 4;
+        static constexpr unsigned error = 8;
+
+        // Throws std::system_error if the poller could not be created, or if neither
+        // epoll nor kqueue is available.
+        Poller();
+        ~Poller() noexcept;
+
+        Poller(const Poller&) = delete;
+        Poller& operator=(const Poller&) = delete;
+
+        // Throws std::system_error if the descriptor could not be added.
+        void add(int fd, unsigned events);
+
+        // Errors are ignored, since the descriptor may already have been closed.
+        void remove(int fd) noexcept;
+
+        // Wait until a descriptor is ready, wake() is called, or the deadline passes,
+        // and append the ready descriptors to ready. A deadline that has passed only
+        // checks the descriptors, and time_point::max() waits without a timeout. Errors
+        // are logged and treated as a timeout.
+        void wait(ready_t& ready, const std::chrono::steady_clock::time_point& deadline) noexcept;
+
+        // Cause the current (or next) wait() to return.
+        void wake() noexcept;
+
+    private:
+        int pollFd = -1;
+        int wakeFd = -1;
+    };
+}}}
+
+#endif
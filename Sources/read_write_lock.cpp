@@ -7,17 +7,23 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
 #include <system_error>
+#include <thread>
 
 #include <syslog.h>
 #include <kss/contract/all.h>
 
+#include "atomic_wait.hpp"
 #include "read_write_lock.hpp"
 
 using namespace std;
+using namespace std::chrono;
 using namespace kss::thread;
 
 namespace contract = kss::contract;
@@ -31,6 +37,17 @@ namespace {
                "[kssthread/read_write_lock.cpp] %s returned error %d (%s)",
                methodname, err, strerror(err));
     }
+
+#if defined(KSS_THREAD_HAVE_CLOCKWAIT) || defined(__linux)
+    // Interpret the result of one of the timed pthread calls.
+    bool checkTimedResult(int err, const char* methodname) {
+        if (err == ETIMEDOUT) { return false; }     // not an error, just not available in time
+        if (err != 0) {
+            throw system_error(err, system_category(), methodname);
+        }
+        return true;
+    }
+#endif
 }
 
 
@@ -51,6 +68,10 @@ void ReadWriteLock::ReadLock::lock() {
         KSS_EXPR(_handle != nullptr)
     });
 
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return;
+    }
+
     int err = pthread_rwlock_rdlock(_handle);
     if (err != 0) {
         throw system_error(err, system_category(), "pthread_rwlock_rdlock");
@@ -58,6 +79,28 @@ void ReadWriteLock::ReadLock::lock() {
 }
 
 
+bool ReadWriteLock::ReadLock::timedLock(const steady_clock::time_point& deadline) {
+    contract::preconditions({
+        KSS_EXPR(_handle != nullptr)
+    });
+
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return true;
+    }
+
+#if defined(KSS_THREAD_HAVE_CLOCKWAIT)
+    const auto ts = _private::monotonicTimespec(deadline);
+    return checkTimedResult(pthread_rwlock_clockrdlock(_handle, CLOCK_MONOTONIC, &ts),
+                            "pthread_rwlock_clockrdlock");
+#elif defined(__linux)
+    const auto ts = _private::realtimeTimespec(deadline);
+    return checkTimedResult(pthread_rwlock_timedrdlock(_handle, &ts), "pthread_rwlock_timedrdlock");
+#else
+    return _private::pollUntil(deadline, [this] { return try_lock(); });
+#endif
+}
+
+
 bool ReadWriteLock::ReadLock::try_lock() {
     contract::preconditions({
         KSS_EXPR(_handle != nullptr)
@@ -77,6 +120,10 @@ void ReadWriteLock::WriteLock::lock() {
         KSS_EXPR(_handle != nullptr)
     });
 
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return;
+    }
+
     int err = pthread_rwlock_wrlock(_handle);
     if (err != 0) {
         throw system_error(err, system_category(), "pthread_rwlock_wrlock");
@@ -84,6 +131,28 @@ void ReadWriteLock::WriteLock::lock() {
 }
 
 
+bool ReadWriteLock::WriteLock::timedLock(const steady_clock::time_point& deadline) {
+    contract::preconditions({
+        KSS_EXPR(_handle != nullptr)
+    });
+
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return true;
+    }
+
+#if defined(KSS_THREAD_HAVE_CLOCKWAIT)
+    const auto ts = _private::monotonicTimespec(deadline);
+    return checkTimedResult(pthread_rwlock_clockwrlock(_handle, CLOCK_MONOTONIC, &ts),
+                            "pthread_rwlock_clockwrlock");
+#elif defined(__linux)
+    const auto ts = _private::realtimeTimespec(deadline);
+    return checkTimedResult(pthread_rwlock_timedwrlock(_handle, &ts), "pthread_rwlock_timedwrlock");
+#else
+    return _private::pollUntil(deadline, [this] { return try_lock(); });
+#endif
+}
+
+
 bool ReadWriteLock::WriteLock::try_lock() {
     contract::preconditions({
         KSS_EXPR(_handle != nullptr)
@@ -113,3 +182,109 @@ ReadWriteLock::~ReadWriteLock() noexcept {
         log("pthread_rwlock_destroy", err);
     }
 }
+
+
+// MARK: DistributedReadWriteLock
+
+using kss::thread::_private::atomicNotifyAll;
+using kss::thread::_private::atomicWait;
+using kss::thread::_private::cpuRelax;
+using kss::thread::_private::spinIterations;
+
+namespace {
+    atomic<unsigned> nextSlotIndex { 0 };
+
+    unsigned defaultNumberOfSlots() noexcept {
+        const auto n = max(std::thread::hardware_concurrency(), 1U);
+        unsigned slots = 1;
+        while (slots < n) {
+            slots <<= 1;
+        }
+        return slots;
+    }
+}
+
+unsigned kss::thread::_private::currentThreadSlotIndex() noexcept {
+    static thread_local const unsigned index = nextSlotIndex.fetch_add(1, memory_order_relaxed);
+    return index;
+}
+
+DistributedReadWriteLock::DistributedReadWriteLock()
+: DistributedReadWriteLock(defaultNumberOfSlots())
+{
+}
+
+DistributedReadWriteLock::DistributedReadWriteLock(unsigned numberOfSlots)
+: slots(numberOfSlots), slotMask(numberOfSlots - 1), _readLock(*this), _writeLock(*this)
+{
+    contract::parameters({
+        KSS_EXPR(numberOfSlots > 0),
+        KSS_EXPR((numberOfSlots & (numberOfSlots - 1)) == 0)
+    });
+}
+
+// A reader that finds a writer active waits for the write lock to be released, and
+// then tries again. The sequentially consistent operations on the slot and on
+// writerActive ensure that a reader and a writer can never both succeed.
+void DistributedReadWriteLock::lockSlow() {
+    while (!_readLock.try_lock()) {
+        for (unsigned i = 0, n = spinIterations(); i < n && writerActive.load() != 0; ++i) {
+            cpuRelax();
+        }
+        while (writerActive.load() != 0) {
+            atomicWait(writerActive, 1);
+        }
+    }
+}
+
+bool DistributedReadWriteLock::readersHaveDrained() noexcept {
+    for (auto& slot : slots) {
+        if (slot.readers.load() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Since writes are rare we do not make the readers notify the writer. Instead the
+// writer spins, then yields, and finally backs off with short sleeps.
+void DistributedReadWriteLock::awaitReaders() noexcept {
+    unsigned attempt = 0;
+    while (!readersHaveDrained()) {
+        if (attempt < spinIterations()) {
+            cpuRelax();
+        }
+        else if (attempt < spinIterations() + 100) {
+            this_thread::yield();
+        }
+        else {
+            this_thread::sleep_for(50us);
+        }
+        ++attempt;
+    }
+}
+
+void DistributedReadWriteLock::WriteLock::lock() {
+    owner.writers.lock();
+    owner.writerActive.store(1);
+    owner.awaitReaders();
+}
+
+bool DistributedReadWriteLock::WriteLock::try_lock() {
+    if (!owner.writers.try_lock()) {
+        return false;
+    }
+    owner.writerActive.store(1);
+    if (!owner.readersHaveDrained()) {
+        unlock();
+        return false;
+    }
+    return true;
+}
+
+// Writes are rare enough that we don't bother tracking if any readers are parked.
+void DistributedReadWriteLock::WriteLock::unlock() noexcept {
+    owner.writerActive.store(0);
+    atomicNotifyAll(owner.writerActive);
+    owner.writers.unlock();
+}
@@ -10,9 +10,16 @@
 #ifndef kssthread_read_write_lock_hpp
 #define kssthread_read_write_lock_hpp
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <pthread.h>
 
+#include "atomic_wait.hpp"
+
 namespace kss { namespace thread {
 
     namespace _private {
@@ -22,9 +29,13 @@ namespace kss { namespace thread {
             explicit RWLockCommon(pthread_rwlock_t* handle) : _handle(handle) {}
             void unlock();
         protected:
-            pthread_rwlock_t* _handle;
+            pthread_rwlock_t*       _handle;
+            std::atomic<unsigned>   _spinAverage { 0 };
         };
 
+        // Each thread is given an index (assigned round-robin as threads first ask for
+        // one) that is used to spread threads across per-thread slots.
+        unsigned currentThreadSlotIndex() noexcept;
     }
 
     /*!
@@ -35,7 +46,13 @@ namespace kss { namespace thread {
 
      Note that this lock itself does not constitute a locking interface. Instead it is
      just a container allowing you to obtain the read lock or the write lock and make
-     lock requests on them.
+     lock requests on them. Both of these are TimedLockable, i.e. in addition to lock(),
+     try_lock(), and unlock(), they provide try_lock_for() and try_lock_until(), hence
+     they may be used with std::unique_lock and its timed constructors.
+
+     When contended, lock() and the timed variants first spin for a short time,
+     adapting the length of the spin to how long recent ones needed, before blocking in
+     the kernel. (On a single processor they do not spin.)
 
      @throws std::system_error if the underlying pthread methods return an error code
      */
@@ -46,6 +63,20 @@ namespace kss { namespace thread {
             explicit ReadLock(pthread_rwlock_t* handle) : _private::RWLockCommon(handle) {}
             void lock();
             bool try_lock();
+
+            template <class Rep, class Period>
+            bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+                using namespace std::chrono;
+                return timedLock(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+            }
+
+            template <class Clock, class Duration>
+            bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+                return timedLock(_private::toSteadyDeadline(tp));
+            }
+
+        private:
+            bool timedLock(const std::chrono::steady_clock::time_point& deadline);
         };
 
         class WriteLock : public _private::RWLockCommon {
@@ -53,6 +84,20 @@ namespace kss { namespace thread {
             explicit WriteLock(pthread_rwlock_t* handle) : _private::RWLockCommon(handle) {}
             void lock();
             bool try_lock();
+
+            template <class Rep, class Period>
+            bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+                using namespace std::chrono;
+                return timedLock(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+            }
+
+            template <class Clock, class Duration>
+            bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+                return timedLock(_private::toSteadyDeadline(tp));
+            }
+
+        private:
+            bool timedLock(const std::chrono::steady_clock::time_point& deadline);
         };
 
 
@@ -96,6 +141,119 @@ namespace kss { namespace thread {
         WriteLock           _writeLock;
     };
 
+
+    /*!
+     A distributed read/write lock is a replacement for ReadWriteLock intended for data
+     that is read very often and written rarely. Instead of a single shared reader count,
+     it has a number of reader counts (slots), each in its own cache line, and each thread
+     uses the slot assigned to it. Hence obtaining and releasing a read lock only writes
+     to a cache line that is (usually) used by the current thread alone, and readers on
+     different processors no longer contend with one another.
+
+     The price is paid by the writers. A write lock request first blocks any new readers,
+     then must wait for the readers in every slot to finish. Writers are favoured in that
+     once a writer is waiting, new read lock requests will block until it is done.
+
+     It has the same interface as ReadWriteLock, i.e. it is a container holding the read
+     lock and the write lock, each of which is a lockable object. Hence they may be used
+     with std::lock_guard, locked(), TryLockGuard, and so on.
+
+     Note that a read lock must be released by the thread that obtained it, and that like
+     most read/write locks, it is not recursive.
+     */
+    class DistributedReadWriteLock {
+    public:
+        class ReadLock {
+        public:
+            void lock() {
+                if (!try_lock()) {
+                    owner.lockSlow();
+                }
+            }
+
+            bool try_lock() noexcept {
+                auto& readers = owner.currentSlot().readers;
+                readers.fetch_add(1);
+                if (owner.writerActive.load() == 0) {
+                    return true;
+                }
+                readers.fetch_sub(1);
+                return false;
+            }
+
+            void unlock() noexcept {
+                owner.currentSlot().readers.fetch_sub(1, std::memory_order_release);
+            }
+
+        private:
+            friend class DistributedReadWriteLock;
+            explicit ReadLock(DistributedReadWriteLock& owner) noexcept : owner(owner) {}
+            DistributedReadWriteLock& owner;
+        };
+
+        class WriteLock {
+        public:
+            void lock();
+            bool try_lock();
+            void unlock() noexcept;
+
+        private:
+            friend class DistributedReadWriteLock;
+            explicit WriteLock(DistributedReadWriteLock& owner) noexcept : owner(owner) {}
+            DistributedReadWriteLock& owner;
+        };
+
+        /*!
+         Construct a lock. The number of reader slots defaults to the number of hardware
+         threads, rounded up to a power of two.
+         @throws std::invalid_argument if numberOfSlots is not a power of two
+         */
+        DistributedReadWriteLock();
+        explicit DistributedReadWriteLock(unsigned numberOfSlots);
+
+        DistributedReadWriteLock(const DistributedReadWriteLock&) = delete;
+        DistributedReadWriteLock& operator=(const DistributedReadWriteLock&) = delete;
+
+        DistributedReadWriteLock(DistributedReadWriteLock&&) = delete;
+        DistributedReadWriteLock& operator=(DistributedReadWriteLock&&) = delete;
+
+        /*!
+         Returns a reference to the read lock.
+         */
+        ReadLock& readLock() noexcept {
+            return _readLock;
+        }
+
+        /*!
+         Returns a reference to the write lock.
+         */
+        WriteLock& writeLock() noexcept {
+            return _writeLock;
+        }
+
+    private:
+        // Padded to keep each reader count in its own cache line.
+        struct Slot {
+            std::atomic<uint32_t>   readers { 0 };
+            char                    padding[64 - sizeof(std::atomic<uint32_t>)];
+        };
+
+        std::vector<Slot>       slots;
+        const unsigned          slotMask;
+        std::mutex              writers;
+        std::atomic<uint32_t>   writerActive { 0 };
+        ReadLock                _readLock;
+        WriteLock               _writeLock;
+
+        Slot& currentSlot() noexcept {
+            return slots[_private::currentThreadSlotIndex() & slotMask];
+        }
+
+        void lockSlow();
+        bool readersHaveDrained() noexcept;
+        void awaitReaders() noexcept;
+    };
+
 }}
 
 #endif
@@ -10,6 +10,7 @@
 #include <cerrno>
 #include <cstring>
 #include <system_error>
+#include <utility>
 
 #include <fcntl.h>
 #include <semaphore.h>
@@ -20,6 +21,7 @@
 #include "semaphore.hpp"
 
 using namespace std;
+using namespace std::chrono;
 using namespace kss::thread;
 
 namespace contract = kss::contract;
@@ -36,7 +38,9 @@ namespace {
 }
 
 
-Semaphore::Semaphore(const string& name, unsigned int value) : _name(name) {
+Semaphore::Semaphore(const string& name, unsigned int value)
+: _name(name), _ownership(Ownership::named)
+{
     sem_t* sem = sem_open(name.c_str(), O_CREAT, (S_IRWXU | S_IRWXG | S_IRWXO), value);
     if (sem == SEM_FAILED) {
         throw system_error(errno, system_category(), "sem_open");
@@ -48,15 +52,63 @@ Semaphore::Semaphore(const string& name, unsigned int value) : _name(name) {
     });
 }
 
+Semaphore::Semaphore(sem_t* storage, unsigned int value) : _ownership(Ownership::unnamed) {
+    contract::parameters({
+        KSS_EXPR(storage != nullptr)
+    });
+
+    if (sem_init(storage, 1, value) == -1) {
+        throw system_error(errno, system_category(), "sem_init");
+    }
+    _handle = storage;
+}
+
+Semaphore::Semaphore(sem_t* storage) : _handle(storage), _ownership(Ownership::attached) {
+    contract::parameters({
+        KSS_EXPR(storage != nullptr)
+    });
+}
+
 Semaphore::~Semaphore() noexcept {
+    close();
+}
+
+// The moved-from object is left without a handle, so that only one of the two
+// objects will close the semaphore.
+Semaphore::Semaphore(Semaphore&& other) noexcept
+: _handle(other._handle), _name(move(other._name)), _ownership(other._ownership)
+{
+    other._handle = SEM_FAILED;
+}
+
+Semaphore& Semaphore::operator=(Semaphore&& other) noexcept {
+    if (this != &other) {
+        close();
+        _handle = other._handle;
+        _name = move(other._name);
+        _ownership = other._ownership;
+        other._handle = SEM_FAILED;
+    }
+    return *this;
+}
+
+void Semaphore::close() noexcept {
     if (_handle != SEM_FAILED) {
         // Don't want to throw an exception. The best we can do is log the problem.
-        if (sem_close(_handle) == -1) {
-            log("sem_close", errno);
+        if (_ownership == Ownership::named) {
+            if (sem_close(_handle) == -1) {
+                log("sem_close", errno);
+            }
+            if (sem_unlink(_name.c_str()) == -1) {
+                log("sem_unlink", errno);
+            }
         }
-        if (sem_unlink(_name.c_str()) == -1) {
-            log("sem_unlink", errno);
+        else if (_ownership == Ownership::unnamed) {
+            if (sem_destroy(_handle) == -1) {
+                log("sem_destroy", errno);
+            }
         }
+        _handle = SEM_FAILED;
     }
 }
 
@@ -65,11 +117,51 @@ void Semaphore::lock() {
         KSS_EXPR(_handle != nullptr && _handle != SEM_FAILED)
     });
 
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return;
+    }
+
     if (sem_wait(_handle) == -1) {
         throw system_error(errno, system_category(), "sem_wait");
     }
 }
 
+bool Semaphore::timedLock(const steady_clock::time_point& deadline) {
+    contract::preconditions({
+        KSS_EXPR(_handle != nullptr && _handle != SEM_FAILED)
+    });
+
+    if (_private::adaptiveSpin(_spinAverage, [this] { return try_lock(); })) {
+        return true;
+    }
+
+#if defined(KSS_THREAD_HAVE_CLOCKWAIT) || defined(__linux)
+    for (;;) {
+#   if defined(KSS_THREAD_HAVE_CLOCKWAIT)
+        const auto ts = _private::monotonicTimespec(deadline);
+        const int ret = sem_clockwait(_handle, CLOCK_MONOTONIC, &ts);
+#   else
+        // The real time deadline is recomputed on each pass so that a change to the
+        // system clock affects at most one pass.
+        const auto ts = _private::realtimeTimespec(deadline);
+        const int ret = sem_timedwait(_handle, &ts);
+#   endif
+        if (ret == 0) {
+            return true;
+        }
+        if (errno == ETIMEDOUT) {
+            return false;
+        }
+        if (errno != EINTR) {
+            throw system_error(errno, system_category(), "sem_timedwait");
+        }
+    }
+#else
+    // sem_timedwait is not available (e.g. on macOS), hence we poll.
+    return _private::pollUntil(deadline, [this] { return try_lock(); });
+#endif
+}
+
 bool Semaphore::try_lock() {
     contract::preconditions({
         KSS_EXPR(_handle != nullptr && _handle != SEM_FAILED)
@@ -97,3 +189,50 @@ void Semaphore::unlock() {
         throw system_error(errno, system_category(), "sem_post");
     }
 }
+
+
+void CountingSemaphore::acquireSlow(uint32_t n) {
+    if (_private::adaptiveSpin(spinAverage, [&] { return tryAcquire(n); })) {
+        return;
+    }
+
+    // Registering as a waiter before re-examining the count ensures that either we
+    // see a concurrent release, or it sees us and wakes us.
+    numberWaiting.fetch_add(1);
+    for (;;) {
+        auto c = count.load();
+        if (c >= n) {
+            if (count.compare_exchange_weak(c, c - n)) {
+                break;
+            }
+            continue;
+        }
+        _private::atomicWait(count, c);
+    }
+    numberWaiting.fetch_sub(1, memory_order_relaxed);
+}
+
+bool CountingSemaphore::acquireSlowUntil(uint32_t n, const steady_clock::time_point& deadline) {
+    if (_private::adaptiveSpin(spinAverage, [&] { return tryAcquire(n); })) {
+        return true;
+    }
+
+    bool acquired = false;
+    numberWaiting.fetch_add(1);
+    for (;;) {
+        auto c = count.load();
+        if (c >= n) {
+            if (count.compare_exchange_weak(c, c - n)) {
+                acquired = true;
+                break;
+            }
+            continue;
+        }
+        if (!_private::atomicWaitUntil(count, c, deadline)) {
+            acquired = tryAcquire(n);
+            break;
+        }
+    }
+    numberWaiting.fetch_sub(1, memory_order_relaxed);
+    return acquired;
+}
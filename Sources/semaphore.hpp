@@ -10,22 +10,39 @@
 #ifndef kssthread_semaphore_hpp
 #define kssthread_semaphore_hpp
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <semaphore.h>
 
+#include "atomic_wait.hpp"
+
 namespace kss { namespace thread {
 
     /*!
      The Semaphore class provides an STL-style wrapper around BSd/POSIX names
      semaphores.
 
+     It may also wrap an unnamed POSIX semaphore placed in memory provided by the
+     caller, typically memory shared between processes (e.g. by mmap with MAP_SHARED).
+     This avoids the name lookup of sem_open and the need to unlink the name. One
+     process initializes the semaphore, the others attach to it. (Note that macOS does
+     not support unnamed semaphores.) For a semaphore that is only used within the
+     current process, CountingSemaphore is considerably cheaper still.
+
      We don't go into a great discussion here on just what a semaphore is, other
      than to note that value is counted down and lock and try_lock will fail
      if more than value threads/processes have obtained this lock.
 
-     This class conforms to the lockable C++11 concept, i.e. it provides lock,
-     try_lock, and unlock methods. Note that try_lock() differs from our coding
-     naming standards in order to conform to the STL style API.
+     This class conforms to the TimedLockable C++11 concept, i.e. it provides lock,
+     try_lock, try_lock_for, try_lock_until, and unlock methods. Note that these differ
+     from our coding naming standards in order to conform to the STL style API.
+
+     When the semaphore is not immediately available, lock() and the timed variants
+     first spin for a short time, adapting the length of the spin to how long recent
+     ones needed, before blocking in the kernel. (On a single processor they do not
+     spin.) The blocking in lock() remains a thread interruption point.
 
      @throws system_error representing any failures of the underlying UNIX errno
         codes from the sem methods.
@@ -38,21 +55,51 @@ namespace kss { namespace thread {
          * obtain a lock.
          */
         Semaphore(const std::string& name, unsigned int value);
+
+        /*!
+         Initialize an unnamed semaphore, with the given initial value, in the memory
+         pointed to by storage. This memory must remain valid for the lifetime of this
+         object, which destroys the semaphore in its destructor. Other processes that
+         share the memory may then use the semaphore via the attaching constructor.
+         @throws std::invalid_argument if storage is nullptr
+         @throws std::system_error if the semaphore could not be initialized
+         */
+        Semaphore(sem_t* storage, unsigned int value);
+
+        /*!
+         Attach to an unnamed semaphore that has already been initialized in the
+         given memory, either by the above constructor in another process or by
+         sem_init. The destructor of this object does not destroy the semaphore.
+         @throws std::invalid_argument if storage is nullptr
+         */
+        explicit Semaphore(sem_t* storage);
+
         ~Semaphore() noexcept;
 
         Semaphore(const Semaphore&) = delete;
         Semaphore& operator=(const Semaphore&) = delete;
 
-        Semaphore(Semaphore&&) = default;
-        Semaphore& operator=(Semaphore&&) = default;
+        Semaphore(Semaphore&& other) noexcept;
+        Semaphore& operator=(Semaphore&& other) noexcept;
 
-        // The locking methods match the STL style API found in std::mutex.
+        // The locking methods match the STL style API found in std::timed_mutex.
         void lock();
         bool try_lock();
         void unlock();
 
+        template <class Rep, class Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+            using namespace std::chrono;
+            return timedLock(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+            return timedLock(_private::toSteadyDeadline(tp));
+        }
+
         /*!
-         Obtain the name of the semaphore.
+         Obtain the name of the semaphore. This is empty for an unnamed semaphore.
          */
         std::string name() const noexcept {
             return _name;
@@ -67,10 +114,139 @@ namespace kss { namespace thread {
         }
 
     private:
-        sem_t*      _handle;
-        std::string _name;
+        enum class Ownership { named, unnamed, attached };
+
+        sem_t*                  _handle;
+        std::string             _name;
+        Ownership               _ownership;
+        std::atomic<unsigned>   _spinAverage { 0 };
+
+        bool timedLock(const std::chrono::steady_clock::time_point& deadline);
+        void close() noexcept;
     };
 
+
+    /*!
+     A CountingSemaphore is a lightweight semaphore that may only be used by the
+     threads of the current process. Unlike Semaphore it involves no kernel object:
+     it is simply a counter in memory, and construction and destruction are as cheap
+     as for any other small object. When it is available, acquire() and release()
+     are a single atomic operation. Threads that must wait block on a futex (on
+     Linux), and release() only makes a system call if a thread is actually waiting.
+
+     A thread may acquire, and release, more than one unit of the count at a time.
+     Note that a request for n units is only satisfied once all n are available at
+     once, hence a stream of small requests may delay a large one.
+
+     It also conforms to the TimedLockable concept, each lock taking one unit, so it
+     may be used with std::unique_lock. Unlike Semaphore, blocking in acquire() is
+     not a thread interruption point.
+
+     @code
+     CountingSemaphore admission(maxConcurrentRequests);
+     ...
+     if (!admission.tryAcquireFor(1, 100ms)) {
+        return busy();
+     }
+     handleRequest();
+     admission.release();
+     @endcode
+     */
+    class CountingSemaphore {
+    public:
+
+        /*!
+         Construct the semaphore with the given initial count.
+         */
+        explicit CountingSemaphore(uint32_t value) noexcept : count(value) {}
+
+        CountingSemaphore(const CountingSemaphore&) = delete;
+        CountingSemaphore& operator=(const CountingSemaphore&) = delete;
+
+        /*!
+         Block until n units are available, then take them.
+         */
+        void acquire(uint32_t n = 1) {
+            if (!tryAcquire(n)) {
+                acquireSlow(n);
+            }
+        }
+
+        /*!
+         Take n units if they are available now. Returns true if they were taken.
+         */
+        bool tryAcquire(uint32_t n = 1) noexcept {
+            auto c = count.load(std::memory_order_relaxed);
+            while (c >= n) {
+                if (count.compare_exchange_weak(c, c - n, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*!
+         Take n units, blocking for at most the given duration for them to become
+         available. Returns true if they were taken.
+         */
+        template <class Rep, class Period>
+        bool tryAcquireFor(uint32_t n, const std::chrono::duration<Rep, Period>& dur) {
+            using namespace std::chrono;
+            return (tryAcquire(n)
+                    || acquireSlowUntil(n, steady_clock::now() + duration_cast<steady_clock::duration>(dur)));
+        }
+
+        /*!
+         Take n units, blocking until at most the given time for them to become
+         available. Returns true if they were taken.
+         */
+        template <class Clock, class Duration>
+        bool tryAcquireUntil(uint32_t n, const std::chrono::time_point<Clock, Duration>& tp) {
+            return (tryAcquire(n) || acquireSlowUntil(n, _private::toSteadyDeadline(tp)));
+        }
+
+        /*!
+         Return n units, waking any threads whose requests can now be satisfied. The
+         count must not exceed UINT32_MAX.
+         */
+        void release(uint32_t n = 1) noexcept {
+            count.fetch_add(n);
+            if (numberWaiting.load() > 0) {
+                _private::atomicNotifyAll(count);
+            }
+        }
+
+        /*!
+         Returns the number of units currently available. Note that this may have
+         changed by the time the caller examines it.
+         */
+        uint32_t value() const noexcept {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        // The locking methods match the STL style API found in std::timed_mutex.
+        void lock() { acquire(); }
+        bool try_lock() noexcept { return tryAcquire(); }
+        void unlock() noexcept { release(); }
+
+        template <class Rep, class Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) {
+            return tryAcquireFor(1, dur);
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) {
+            return tryAcquireUntil(1, tp);
+        }
+
+    private:
+        std::atomic<uint32_t>   count;
+        std::atomic<uint32_t>   numberWaiting { 0 };
+        std::atomic<unsigned>   spinAverage { 0 };
+
+        void acquireSlow(uint32_t n);
+        bool acquireSlowUntil(uint32_t n, const std::chrono::steady_clock::time_point& deadline);
+    };
 }}
 
 #endif
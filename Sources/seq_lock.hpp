@@ -0,0 +1,140 @@
+//
+//  seq_lock.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_seq_lock_hpp
+#define kssthread_seq_lock_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#include "atomic_wait.hpp"
+
+namespace kss { namespace thread {
+
+    /*!
+     A sequence lock protects a small, frequently read value. Readers never write to
+     shared memory at all: they read a sequence number, copy the value, and read the
+     sequence number again, retrying if a write took place in between. Writers are
+     serialized by a mutex and make the sequence number odd while they are writing.
+
+     This makes reads very cheap and means that readers can never delay a writer, but
+     a reader may have to retry (or, with many writes, be delayed). It is best suited
+     to values that are at most a few cache lines in size, read very often, and written
+     occasionally. For larger values consider Versioned.
+
+     T must be trivially copyable and default constructible. Internally the value is
+     held as an array of atomic words, so the concurrent copies made by readers are
+     well defined.
+
+     @code
+     SeqLock<Route> route;
+     route.store(newRoute);               // writer
+     const auto r = route.load();         // readers
+     route.update([](Route& r) { ++r.hops; });
+     @endcode
+     */
+    template <class T>
+    class SeqLock {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+        /*!
+         Construct the lock holding the given value.
+         */
+        explicit SeqLock(const T& value = T()) noexcept {
+            writeWords(value);
+        }
+
+        SeqLock(const SeqLock&) = delete;
+        SeqLock& operator=(const SeqLock&) = delete;
+
+        /*!
+         Return a copy of the current value. This never blocks a writer, but will
+         retry if a write takes place while the value is being copied.
+         */
+        T load() const noexcept {
+            T value;
+            for (;;) {
+                const auto before = sequence.load(std::memory_order_acquire);
+                if ((before & 1) == 0) {
+                    readWords(value);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == before) {
+                        return value;
+                    }
+                }
+                _private::cpuRelax();
+            }
+        }
+
+        /*!
+         Replace the value.
+         @throws any exception that std::mutex::lock may throw
+         */
+        void store(const T& value) {
+            std::lock_guard<std::mutex> l(writerLock);
+            write(value);
+        }
+
+        /*!
+         Modify the value. fn is called as fn(T&) with a copy of the current value, and
+         the result is then stored. Concurrent updates are serialized, hence this may be
+         used for read-modify-write operations.
+         @throws any exception that fn or std::mutex::lock may throw. If fn throws, the
+            value is not changed.
+         */
+        template <class Fn>
+        void update(Fn&& fn) {
+            std::lock_guard<std::mutex> l(writerLock);
+            T value;
+            readWords(value);
+            fn(value);
+            write(value);
+        }
+
+    private:
+        static constexpr std::size_t numberOfWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint64_t>   sequence { 0 };
+        std::atomic<uint64_t>   words[numberOfWords];
+        std::mutex              writerLock;
+
+        void write(const T& value) noexcept {
+            const auto s = sequence.load(std::memory_order_relaxed);
+            sequence.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            writeWords(value);
+            sequence.store(s + 2, std::memory_order_release);
+        }
+
+        void readWords(T& value) const noexcept {
+            uint64_t buffer[numberOfWords];
+            for (std::size_t i = 0; i < numberOfWords; ++i) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::memcpy(&value, buffer, sizeof(T));
+        }
+
+        void writeWords(const T& value) noexcept {
+            uint64_t buffer[numberOfWords] = {};
+            std::memcpy(buffer, &value, sizeof(T));
+            for (std::size_t i = 0; i < numberOfWords; ++i) {
+                words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+        }
+    };
+
+    template <class T>
+    constexpr std::size_t SeqLock<T>::numberOfWords;
+}}
+
+#endif
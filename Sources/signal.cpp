@@ -7,14 +7,33 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <csignal>
+#include <exception>
+#include <memory>
 #include <system_error>
+#include <thread>
+
 #include <pthread.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <kss/contract/all.h>
+
+#if defined(__linux)
+#   include <sys/signalfd.h>
+#endif
+
+#include "action_queue.hpp"
+#include "poller.hpp"
 #include "signal.hpp"
 
 using namespace std;
 using namespace kss::thread;
 
+namespace contract = kss::contract;
+
 
 void kss::thread::signal::send(std::thread& th, int sig) {
     const auto err = pthread_kill(th.native_handle(), sig);
@@ -41,3 +60,146 @@ void kss::thread::signal::ignore(initializer_list<int> signals) {
         throw system_error(err, system_category(), "pthread_sigmask");
     }
 }
+
+
+// MARK: Dispatcher
+
+// On Linux the thread waits in a poller on the signalfd, and is stopped by waking the
+// poller. Elsewhere it waits in sigwait(), and is stopped by sending it one of its
+// own signals after setting stopping.
+struct signal::Dispatcher::Impl {
+    ActionQueue&                    queue;
+    shared_ptr<const handler_t>     handler;
+    sigset_t                        mask;
+    int                             firstSignal = 0;
+    atomic<bool>                    stopping { false };
+    std::thread                     th;
+#if defined(__linux)
+    int                             sigFd = -1;
+    _private::Poller                poller;
+#endif
+
+    Impl(ActionQueue& q, handler_t&& h)
+    : queue(q), handler(make_shared<const handler_t>(move(h)))
+    {}
+
+    ~Impl() noexcept {
+#if defined(__linux)
+        if (sigFd != -1) {
+            close(sigFd);
+        }
+#endif
+    }
+
+    // Signals cannot be lost to a full queue without also being merged by the
+    // kernel, hence dropping one here is no worse than what may already happen.
+    void dispatch(int sig) noexcept {
+        try {
+            auto h = handler;
+            queue.addAction([h, sig] { (*h)(sig); });
+        }
+        catch (const exception& e) {
+            syslog(LOG_ERR, "[%s] Dropped signal %d: %s", __PRETTY_FUNCTION__, sig, e.what());
+        }
+    }
+
+#if defined(__linux)
+    void run() noexcept {
+        _private::Poller::ready_t ready;
+        signalfd_siginfo info[16];
+        while (!stopping) {
+            poller.wait(ready, chrono::steady_clock::time_point::max());
+            ready.clear();
+
+            ssize_t n = 0;
+            while (!stopping && (n = read(sigFd, info, sizeof(info))) > 0) {
+                for (size_t i = 0, count = size_t(n) / sizeof(signalfd_siginfo); i < count; ++i) {
+                    dispatch(int(info[i].ssi_signo));
+                }
+            }
+        }
+    }
+#else
+    void run() noexcept {
+        while (true) {
+            int sig = 0;
+            if (sigwait(&mask, &sig) != 0) {
+                continue;
+            }
+            if (stopping) {
+                break;
+            }
+            dispatch(sig);
+        }
+    }
+#endif
+};
+
+
+signal::Dispatcher::Dispatcher(ActionQueue& queue, initializer_list<int> signals, handler_t handler) {
+    contract::parameters({
+        KSS_EXPR(signals.size() > 0),
+        KSS_EXPR(bool(handler))
+    });
+    for (int sig : signals) {
+        contract::parameters({
+            KSS_EXPR(sig != SIGKILL && sig != SIGSTOP)
+        });
+    }
+
+    impl.reset(new Impl(queue, move(handler)));
+    impl->firstSignal = *signals.begin();
+    if (sigemptyset(&impl->mask) == -1) {
+        throw system_error(errno, system_category(), "sigemptyset");
+    }
+    for (int sig : signals) {
+        if (sigaddset(&impl->mask, sig) == -1) {
+            throw system_error(errno, system_category(), "sigaddset");
+        }
+    }
+
+    // The mask must be in place before the thread is created, so that it inherits it.
+    // If we fail after this, the previous mask is restored.
+    sigset_t oldMask;
+    const auto err = pthread_sigmask(SIG_BLOCK, &impl->mask, &oldMask);
+    if (err != 0) {
+        throw system_error(err, system_category(), "pthread_sigmask");
+    }
+
+    try {
+#if defined(__linux)
+        impl->sigFd = signalfd(-1, &impl->mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (impl->sigFd == -1) {
+            throw system_error(errno, system_category(), "signalfd");
+        }
+        impl->poller.add(impl->sigFd, _private::Poller::readable);
+#endif
+
+        auto self = impl.get();
+        impl->th = std::thread([self] { self->run(); });
+    }
+    catch (...) {
+        pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+        throw;
+    }
+}
+
+signal::Dispatcher::~Dispatcher() noexcept {
+    try {
+        impl->stopping = true;
+#if defined(__linux)
+        impl->poller.wake();
+#else
+        send(impl->firstSignal);
+#endif
+        impl->th.join();
+    }
+    catch (const exception& e) {
+        // Best we can do is log the error and continue.
+        syslog(LOG_ERR, "[%s] Exception shutting down: %s", __PRETTY_FUNCTION__, e.what());
+    }
+}
+
+void signal::Dispatcher::send(int sig) {
+    signal::send(impl->th, sig);
+}
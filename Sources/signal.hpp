@@ -10,11 +10,15 @@
 #ifndef kssthread_signal_hpp
 #define kssthread_signal_hpp
 
+#include <functional>
 #include <initializer_list>
+#include <memory>
 #include <thread>
 
 namespace kss { namespace thread {
 
+    class ActionQueue;
+
     /*!
      Threads and signals. We provide a simple mechanism to send and ignore POSIX
      signals within POSIX threads.
@@ -41,6 +45,57 @@ namespace kss { namespace thread {
         void ignore(std::initializer_list<int> signals);
         inline void ignore(int sig) { ignore({ sig }); }
 
+        /*!
+         A dispatcher receives a set of signals on a dedicated thread and runs a handler
+         for each one as an action on an ActionQueue. Since the handler is an ordinary
+         action, rather than an asynchronous signal handler, it may safely do real work,
+         and since the signals are blocked the other threads are never interrupted by
+         them (and hence never see EINTR on their behalf). The signals are received
+         using a signalfd on Linux, and sigwait() elsewhere.
+
+         The constructor blocks the signals in the calling thread, and the blocked mask
+         is inherited by any threads it subsequently creates. Hence for the signals to
+         be blocked process-wide the dispatcher should be created early in main(),
+         before any other threads. (signal::ignore() may be used in any threads that
+         already exist.) The signals remain blocked after the dispatcher is destroyed.
+
+         Note that, as with any blocked signal, multiple occurrences of a signal that
+         arrive before it is received may be merged into one. If the queue is full when
+         a signal is received, the signal is logged and dropped. The queue must remain
+         in scope for at least as long as the dispatcher.
+         */
+        class Dispatcher {
+        public:
+            using handler_t = std::function<void(int sig)>;
+
+            /*!
+             Start receiving the signals.
+             @param queue the queue on which the handler will be run.
+             @param signals the signals to receive.
+             @param handler the handler, which is given the signal that was received.
+             @throws std::invalid_argument if signals is empty or contains SIGKILL or
+                SIGSTOP (which cannot be blocked), or if the handler is empty
+             @throws std::system_error if the underlying C calls return an error
+             */
+            Dispatcher(ActionQueue& queue, std::initializer_list<int> signals, handler_t handler);
+            ~Dispatcher() noexcept;
+
+            Dispatcher(const Dispatcher&) = delete;
+            Dispatcher(Dispatcher&&) = delete;
+            Dispatcher& operator=(const Dispatcher&) = delete;
+            Dispatcher& operator=(Dispatcher&&) = delete;
+
+            /*!
+             Send a signal directly to the dispatcher thread. This may be used to forward
+             a signal that was received elsewhere.
+             @throws std::system_error if the underlying C calls return an error
+             */
+            void send(int sig);
+
+        private:
+            struct Impl;
+            std::unique_ptr<Impl> impl;
+        };
     }
 }}
 
@@ -0,0 +1,190 @@
+//
+//  spin_lock.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "atomic_wait.hpp"
+#include "spin_lock.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+
+using kss::thread::_private::McsNode;
+using kss::thread::_private::adaptiveSpin;
+using kss::thread::_private::atomicNotifyAll;
+using kss::thread::_private::atomicNotifyOne;
+using kss::thread::_private::atomicWait;
+using kss::thread::_private::atomicWaitUntil;
+using kss::thread::_private::cpuRelax;
+using kss::thread::_private::spinIterations;
+
+
+// MARK: AdaptiveMutex
+
+// Once a thread has had to wait it marks the lock as having waiters, and keeps that
+// mark when it obtains the lock, since it cannot tell if it was the only one. At worst
+// this costs an unnecessary wake.
+void AdaptiveMutex::lockSlow() noexcept {
+    if (adaptiveSpin(spinAverage, [this] { return (state.load(memory_order_relaxed) == unlocked && try_lock()); })) {
+        return;
+    }
+    while (state.exchange(lockedWithWaiters, memory_order_acquire) != unlocked) {
+        atomicWait(state, lockedWithWaiters);
+    }
+}
+
+bool AdaptiveMutex::lockSlowUntil(const steady_clock::time_point& deadline) noexcept {
+    if (adaptiveSpin(spinAverage, [this] { return (state.load(memory_order_relaxed) == unlocked && try_lock()); })) {
+        return true;
+    }
+    while (state.exchange(lockedWithWaiters, memory_order_acquire) != unlocked) {
+        if (!atomicWaitUntil(state, lockedWithWaiters, deadline)) {
+            return (state.exchange(lockedWithWaiters, memory_order_acquire) == unlocked);
+        }
+    }
+    return true;
+}
+
+
+// MARK: TicketLock
+
+void TicketLock::waitForTurn(uint32_t ticket) noexcept {
+    for (unsigned i = 0, n = spinIterations(); i < n; ++i) {
+        if (nowServing.load(memory_order_acquire) == ticket) {
+            return;
+        }
+        cpuRelax();
+    }
+
+    // As in the synchronizers, the parked count and the sequentially consistent
+    // operations ensure that either unlock() sees our count or we see its change.
+    for (;;) {
+        const auto serving = nowServing.load();
+        if (serving == ticket) {
+            return;
+        }
+        ++numberParked;
+        if (nowServing.load() == serving) {
+            atomicWait(nowServing, serving);
+        }
+        --numberParked;
+    }
+}
+
+
+// MARK: McsLock
+
+namespace {
+    constexpr uint32_t waiting = 0;
+    constexpr uint32_t granted = 1;
+    constexpr uint32_t parked = 2;
+
+    // The free queue nodes of this thread. A thread only needs as many nodes as the
+    // number of McsLocks it holds (or is waiting for) at once.
+    class NodeCache {
+    public:
+        ~NodeCache() noexcept {
+            while (freeList) {
+                auto node = freeList;
+                freeList = node->nextFree;
+                delete node;
+            }
+        }
+
+        McsNode* acquire() {
+            McsNode* node = freeList;
+            if (node) {
+                freeList = node->nextFree;
+            }
+            else {
+                node = new McsNode();
+            }
+            node->next.store(nullptr, memory_order_relaxed);
+            node->state.store(waiting, memory_order_relaxed);
+            return node;
+        }
+
+        void release(McsNode* node) noexcept {
+            node->nextFree = freeList;
+            freeList = node;
+        }
+
+    private:
+        McsNode* freeList = nullptr;
+    };
+
+    NodeCache& nodeCache() {
+        static thread_local NodeCache cache;
+        return cache;
+    }
+
+    void waitUntilGranted(McsNode* node) noexcept {
+        for (unsigned i = 0, n = spinIterations(); i < n; ++i) {
+            if (node->state.load(memory_order_acquire) == granted) {
+                return;
+            }
+            cpuRelax();
+        }
+
+        uint32_t expected = waiting;
+        if (node->state.compare_exchange_strong(expected, parked, memory_order_acq_rel, memory_order_acquire)) {
+            while (node->state.load(memory_order_acquire) != granted) {
+                atomicWait(node->state, parked);
+            }
+        }
+    }
+}
+
+void McsLock::lock() {
+    McsNode* node = nodeCache().acquire();
+    McsNode* pred = tail.exchange(node, memory_order_acq_rel);
+    if (pred) {
+        pred->next.store(node, memory_order_release);
+        waitUntilGranted(node);
+    }
+    owner = node;
+}
+
+bool McsLock::try_lock() {
+    McsNode* node = nodeCache().acquire();
+    McsNode* expected = nullptr;
+    if (tail.compare_exchange_strong(expected, node, memory_order_acq_rel, memory_order_relaxed)) {
+        owner = node;
+        return true;
+    }
+    nodeCache().release(node);
+    return false;
+}
+
+void McsLock::unlock() noexcept {
+    McsNode* node = owner;
+    McsNode* succ = node->next.load(memory_order_acquire);
+    if (!succ) {
+        McsNode* expected = node;
+        if (tail.compare_exchange_strong(expected, nullptr, memory_order_acq_rel, memory_order_relaxed)) {
+            nodeCache().release(node);
+            return;
+        }
+
+        // A thread has joined the queue but not yet linked itself to our node.
+        while (!(succ = node->next.load(memory_order_acquire))) {
+            cpuRelax();
+        }
+    }
+
+    // Once granted the successor may release its node, hence the notify only uses
+    // the address.
+    if (succ->state.exchange(granted, memory_order_acq_rel) == parked) {
+        atomicNotifyOne(succ->state);
+    }
+    nodeCache().release(node);
+}
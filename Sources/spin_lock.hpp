@@ -0,0 +1,175 @@
+//
+//  spin_lock.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_spin_lock_hpp
+#define kssthread_spin_lock_hpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "atomic_wait.hpp"
+
+namespace kss { namespace thread {
+
+    /*!
+     An AdaptiveMutex is a mutex built on a single atomic word. An uncontended lock or
+     unlock is a single atomic operation, with no system call. When contended, lock()
+     first spins for a while, adapting the length of the spin to how long recent ones
+     needed (as the glibc adaptive mutexes do), and only then parks the thread. Hence it
+     is well suited to very short critical sections.
+
+     This is a TimedLockable, so it may be used wherever a std::timed_mutex may be,
+     including with locked(), TryLockGuard, std::lock_guard and std::unique_lock. Like
+     std::mutex it is neither recursive nor fair.
+     */
+    class AdaptiveMutex {
+    public:
+        AdaptiveMutex() noexcept = default;
+        AdaptiveMutex(const AdaptiveMutex&) = delete;
+        AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+        void lock() noexcept {
+            if (!try_lock()) {
+                lockSlow();
+            }
+        }
+
+        bool try_lock() noexcept {
+            uint32_t expected = unlocked;
+            return state.compare_exchange_strong(expected, locked,
+                                                 std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void unlock() noexcept {
+            if (state.exchange(unlocked, std::memory_order_release) == lockedWithWaiters) {
+                _private::atomicNotifyOne(state);
+            }
+        }
+
+        template <class Rep, class Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& dur) noexcept {
+            using namespace std::chrono;
+            return try_lock() || lockSlowUntil(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp) noexcept {
+            return try_lock() || lockSlowUntil(_private::toSteadyDeadline(tp));
+        }
+
+    private:
+        static constexpr uint32_t unlocked = 0;
+        static constexpr uint32_t locked = 1;
+        static constexpr uint32_t lockedWithWaiters = 2;
+
+        std::atomic<uint32_t>   state { unlocked };
+        std::atomic<unsigned>   spinAverage { 0 };
+
+        void lockSlow() noexcept;
+        bool lockSlowUntil(const std::chrono::steady_clock::time_point& deadline) noexcept;
+    };
+
+
+    /*!
+     A TicketLock is a fair spin-then-park lock. Each lock() takes the next ticket and
+     waits for it to be served, hence threads obtain the lock in the order they asked
+     for it, and none can be starved. The price is that a waiting thread cannot barge
+     ahead when the lock is released, so under heavy contention it hands off more
+     slowly than AdaptiveMutex, and a waiter that has parked delays all those behind it.
+
+     This is a Lockable (but not a TimedLockable, since a ticket cannot be returned).
+     */
+    class TicketLock {
+    public:
+        TicketLock() noexcept = default;
+        TicketLock(const TicketLock&) = delete;
+        TicketLock& operator=(const TicketLock&) = delete;
+
+        void lock() noexcept {
+            const auto ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+            if (nowServing.load(std::memory_order_acquire) != ticket) {
+                waitForTurn(ticket);
+            }
+        }
+
+        bool try_lock() noexcept {
+            auto ticket = nowServing.load(std::memory_order_acquire);
+            return nextTicket.compare_exchange_strong(ticket, ticket + 1,
+                                                      std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void unlock() noexcept {
+            nowServing.fetch_add(1);
+            if (numberParked.load() > 0) {
+                _private::atomicNotifyAll(nowServing);
+            }
+        }
+
+    private:
+        // Padded so that taking a ticket does not disturb the threads watching nowServing.
+        std::atomic<uint32_t>   nextTicket { 0 };
+        char                    padding[64 - sizeof(std::atomic<uint32_t>)];
+        std::atomic<uint32_t>   nowServing { 0 };
+        std::atomic<uint32_t>   numberParked { 0 };
+
+        void waitForTurn(uint32_t ticket) noexcept;
+    };
+
+
+    namespace _private {
+        // Each waiting thread spins on its own node, padded to keep it in its own cache
+        // line (or two).
+        struct McsNode {
+            std::atomic<McsNode*>   next { nullptr };
+            std::atomic<uint32_t>   state { 0 };
+            McsNode*                nextFree = nullptr;
+            char                    padding[64];
+        };
+    }
+
+    /*!
+     An McsLock is a fair queue lock (Mellor-Crummey and Scott). The waiting threads
+     form a queue and each spins on a flag in its own queue node, rather than on the
+     lock itself, so releasing the lock touches only the next thread's cache line. Under
+     heavy contention on many cores this avoids the cache line ping-pong of locks in
+     which every waiter watches the same word. Like TicketLock, it is fair, and a
+     waiter that has spun for a while parks until its turn comes.
+
+     The queue nodes are taken from a small per-thread cache, hence neither lock() nor
+     unlock() normally allocates. Note that the lock must be released by the thread
+     that obtained it.
+
+     This is a Lockable (but not a TimedLockable, since a queued thread cannot leave).
+     */
+    class McsLock {
+    public:
+        McsLock() noexcept = default;
+        McsLock(const McsLock&) = delete;
+        McsLock& operator=(const McsLock&) = delete;
+
+        /*!
+         @throws std::bad_alloc if a queue node could not be allocated
+         */
+        void lock();
+
+        /*!
+         @throws std::bad_alloc if a queue node could not be allocated
+         */
+        bool try_lock();
+
+        void unlock() noexcept;
+
+    private:
+        std::atomic<_private::McsNode*> tail { nullptr };
+        _private::McsNode*              owner = nullptr;
+    };
+}}
+
+#endif
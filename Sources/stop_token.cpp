@@ -0,0 +1,85 @@
+//
+//  stop_token.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "stop_token.hpp"
+
+using namespace std;
+using namespace kss::thread;
+using kss::thread::_private::StopState;
+
+
+StopToken& kss::thread::_private::currentStopToken() noexcept {
+    static thread_local StopToken token;
+    return token;
+}
+
+
+bool StopState::requestStop() noexcept {
+    if (stopped.exchange(true, memory_order_acq_rel)) {
+        return false;
+    }
+
+    // Each callback is run without the lock so that it may take other locks, and so
+    // that its StopCallback may be destroyed, by the callback itself, while it runs.
+    unique_lock<mutex> l(lock);
+    runningThread = this_thread::get_id();
+    while (head) {
+        StopCallback* cb = head;
+        head = cb->next;
+        if (head) {
+            head->prev = nullptr;
+        }
+        cb->linked = false;
+        running = cb;
+        l.unlock();
+        cb->fn();
+        l.lock();
+        running = nullptr;
+        callbackDone.notify_all();
+    }
+    return true;
+}
+
+bool StopState::add(StopCallback* cb) noexcept {
+    lock_guard<mutex> l(lock);
+    if (stopped.load(memory_order_relaxed)) {
+        return false;
+    }
+    cb->next = head;
+    cb->prev = nullptr;
+    if (head) {
+        head->prev = cb;
+    }
+    head = cb;
+    cb->linked = true;
+    return true;
+}
+
+void StopState::remove(StopCallback* cb) noexcept {
+    unique_lock<mutex> l(lock);
+    if (cb->linked) {
+        if (cb->prev) {
+            cb->prev->next = cb->next;
+        }
+        else {
+            head = cb->next;
+        }
+        if (cb->next) {
+            cb->next->prev = cb->prev;
+        }
+        cb->linked = false;
+    }
+    else if (running == cb && runningThread != this_thread::get_id()) {
+        callbackDone.wait(l, [this, cb] { return running != cb; });
+    }
+}
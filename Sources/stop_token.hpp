@@ -0,0 +1,254 @@
+//
+//  stop_token.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_stop_token_hpp
+#define kssthread_stop_token_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "inline_function.hpp"
+
+namespace kss { namespace thread {
+
+    class StopCallback;
+
+    namespace _private {
+
+        // The state shared by a StopSource and its tokens. The callbacks form an
+        // intrusive list, hence registering one never allocates.
+        class StopState {
+        public:
+            bool stopRequested() const noexcept { return stopped.load(std::memory_order_acquire); }
+            bool requestStop() noexcept;
+
+            // Returns false, without adding it, if a stop has already been requested.
+            bool add(StopCallback* cb) noexcept;
+
+            // If the callback is running on another thread this waits for it to finish.
+            void remove(StopCallback* cb) noexcept;
+
+        private:
+            std::atomic<bool>       stopped { false };
+            std::mutex              lock;
+            std::condition_variable callbackDone;
+            StopCallback*           head = nullptr;
+            StopCallback*           running = nullptr;
+            std::thread::id         runningThread;
+        };
+    }
+
+    /*!
+     A StopToken is used to determine if a stop has been requested of the StopSource
+     that created it. It provides cooperative cancellation: the code being cancelled
+     is expected to call stopRequested() at convenient points and to return early
+     when it is true. Unlike interrupt(), this involves no thread cancellation and
+     hence works with any code, including code that performs a catch (...).
+
+     A default constructed StopToken is not associated with any source, and a stop
+     will never be requested of it. Tokens are cheap to copy and may be shared
+     between threads.
+     */
+    class StopToken {
+    public:
+        StopToken() noexcept = default;
+
+        /*!
+         Returns true if a stop has been requested of the associated source.
+         */
+        bool stopRequested() const noexcept {
+            return (state && state->stopRequested());
+        }
+
+        /*!
+         Returns true if the token is associated with a source, i.e. if a stop
+         may ever be requested of it.
+         */
+        bool stopPossible() const noexcept { return bool(state); }
+
+    private:
+        friend class StopSource;
+        friend class StopCallback;
+        explicit StopToken(const std::shared_ptr<_private::StopState>& s) noexcept : state(s) {}
+
+        std::shared_ptr<_private::StopState> state;
+    };
+
+    /*!
+     A StopSource is used to request that one or more operations, each given a token
+     obtained from token(), stop what they are doing. Copies of a StopSource share
+     the same state.
+     @throws std::bad_alloc if the shared state could not be allocated
+     */
+    class StopSource {
+    public:
+        StopSource() : state(std::make_shared<_private::StopState>()) {}
+
+        /*!
+         Returns a token associated with this source.
+         */
+        StopToken token() const noexcept { return StopToken(state); }
+
+        /*!
+         Request that the operations associated with this source stop. Returns true
+         if this was the first request, false if a stop had already been requested.
+         The first request also runs, on this thread, each StopCallback registered
+         with the source's tokens, which is how threads blocked in a stoppable section
+         are woken.
+         */
+        bool requestStop() noexcept {
+            return state->requestStop();
+        }
+
+        /*!
+         Returns true if a stop has been requested.
+         */
+        bool stopRequested() const noexcept {
+            return state->stopRequested();
+        }
+
+    private:
+        std::shared_ptr<_private::StopState> state;
+    };
+
+    /*!
+     A StopCallback runs a function when a stop is requested of its token's source.
+     If a stop has already been requested the function is run immediately by the
+     constructor, otherwise it is run by the requestStop() call. Destroying the
+     StopCallback deregisters the function, waiting for it to finish if it is
+     currently running on another thread. Hence the function may safely refer to
+     anything that outlives the StopCallback.
+
+     The function should be short and must not throw. Registration does not allocate
+     (provided the function fits within an InlineFunction).
+     */
+    class StopCallback {
+    public:
+        template <class Fn>
+        StopCallback(const StopToken& token, Fn&& fn) : fn(std::forward<Fn>(fn)), state(token.state) {
+            if (state && !state->add(this)) {
+                state.reset();
+                this->fn();
+            }
+        }
+
+        ~StopCallback() noexcept {
+            if (state) {
+                state->remove(this);
+            }
+        }
+
+        StopCallback(const StopCallback&) = delete;
+        StopCallback& operator=(const StopCallback&) = delete;
+
+    private:
+        friend class _private::StopState;
+
+        InlineFunction<void()>                  fn;
+        std::shared_ptr<_private::StopState>    state;
+        StopCallback*                           prev = nullptr;
+        StopCallback*                           next = nullptr;
+        bool                                    linked = false;
+    };
+
+
+    /*!
+     The exception thrown out of a blocking call in a stoppable section when a stop is
+     requested. The stoppable section catches it.
+     */
+    class Stopped : public std::exception {
+    public:
+        const char* what() const noexcept override { return "stop requested"; }
+    };
+
+    namespace _private {
+        // The token of the innermost stoppable section of this thread.
+        StopToken& currentStopToken() noexcept;
+
+        // Wake the given condition variable, while holding its mutex, if a stop is
+        // requested of the current thread's token. This must be constructed before the
+        // mutex is locked, and hence is destroyed after it has been released, since
+        // destroying the callback waits for it if it is running.
+        class WakeOnStop {
+        public:
+            template <class Lockable, class ConditionVariable>
+            WakeOnStop(Lockable& m, ConditionVariable& cv)
+            : callback(currentStopToken(), [&m, &cv] {
+                std::lock_guard<Lockable> l(m);
+                cv.notify_all();
+            })
+            {}
+
+        private:
+            StopCallback callback;
+        };
+    }
+
+    /*!
+     The stoppable class is the cooperative alternative to interruptible. It runs the
+     given code with the token installed as the token of the current thread. While
+     it runs, a call to interruptionPoint(), or a wait in a Condition, Latch, Barrier,
+     ActionQueue::wait() or Channel, throws Stopped once a stop has been requested.
+     Since requestStop() directly wakes the thread blocked in one of those waits, the
+     latency of the stop is bounded rather than depending on the next wakeup.
+
+     Entering the section involves no system calls, and no thread cancellation, so it
+     is cheap and works with any code. The Stopped exception is caught by the
+     stoppable section, which then returns normally. Use StopToken::stopRequested() to
+     determine if the code was stopped.
+
+     Like interruptible, this is named to look like a keyword.
+
+     @code
+     StopSource src;
+     thread th { [&] {
+        stoppable { src.token(), [&] {
+            while (channel.pop(item)) { ... }
+        }};
+     }};
+     ...
+     src.requestStop();
+     th.join();
+     @endcode
+
+     @throws any exception other than Stopped that the code throws
+     */
+    class stoppable {
+    public:
+        template <class Fn, class... Args>
+        stoppable(const StopToken& token, Fn&& fn, Args&&... args) {
+            Scope scope(token);
+            try {
+                fn(std::forward<Args>(args)...);
+            }
+            catch (const Stopped&) {
+            }
+        }
+
+    private:
+        class Scope {
+        public:
+            explicit Scope(const StopToken& token) : previous(std::move(_private::currentStopToken())) {
+                _private::currentStopToken() = token;
+            }
+            ~Scope() noexcept {
+                _private::currentStopToken() = std::move(previous);
+            }
+        private:
+            StopToken previous;
+        };
+    };
+}}
+
+#endif
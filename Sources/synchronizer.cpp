@@ -7,17 +7,83 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <kss/contract/all.h>
+
+#include "atomic_wait.hpp"
 #include "interruptible.hpp"
+#include "stop_token.hpp"
 #include "synchronizer.hpp"
 
 using namespace std;
+using namespace std::chrono;
 using namespace kss::thread;
 
+namespace contract = kss::contract;
+
+using kss::thread::_private::atomicNotifyAll;
+using kss::thread::_private::atomicWait;
+using kss::thread::_private::atomicWaitUntil;
+using kss::thread::_private::cpuRelax;
+using kss::thread::_private::spinIterations;
+
+
+namespace {
+    // Spin for a short time waiting for word to stop being equal to value. Returns
+    // true if it did.
+    bool spinWhileEqual(const atomic<uint32_t>& word, uint32_t value) noexcept {
+        for (unsigned i = 0, n = spinIterations(); i < n; ++i) {
+            if (word.load(memory_order_acquire) != value) {
+                return true;
+            }
+            cpuRelax();
+        }
+        return false;
+    }
+
+    // Park until word is no longer equal to value. The parked count, along with the
+    // sequentially consistent operations on both sides, ensures that either the
+    // notifier sees our count (and hence wakes us), or we see the changed word.
+    void parkWhileEqual(const atomic<uint32_t>& word, uint32_t value, atomic<uint32_t>& numberParked) noexcept {
+        while (word.load() == value) {
+            ++numberParked;
+            if (word.load() == value) {
+                atomicWait(word, value);
+            }
+            --numberParked;
+        }
+    }
+
+    bool parkWhileEqualUntil(const atomic<uint32_t>& word,
+                             uint32_t value,
+                             atomic<uint32_t>& numberParked,
+                             const steady_clock::time_point& deadline) noexcept
+    {
+        while (word.load() == value) {
+            ++numberParked;
+            bool timedOut = false;
+            if (word.load() == value) {
+                timedOut = !atomicWaitUntil(word, value, deadline);
+            }
+            --numberParked;
+            if (timedOut) {
+                return (word.load() != value);
+            }
+        }
+        return true;
+    }
+}
+
 
 // MARK: Condition
 
 void Condition::wait() {
     if (!checkPredicate()) {
+        _private::WakeOnStop waker(lock, cv);
         unique_lock<mutex> l(lock);
         if (!pred()) {
             cv.wait(l, [this] {
@@ -65,12 +131,22 @@ void Latch::reset() {
 
 void Barrier::wait() {
     if (!incrementCounterAndCheck()) {
+        _private::WakeOnStop waker(lock, cv);
         unique_lock<mutex> l(lock);
         if (counter < n) {
-            cv.wait(l, [this] {
-                interruptionPoint();
-                return (counter >= n);
-            });
+            try {
+                cv.wait(l, [this] {
+                    interruptionPoint();
+                    return (counter >= n);
+                });
+            }
+            catch (const Stopped&) {
+                // As with a timed out wait, the stopped thread withdraws from the barrier.
+                if (counter < n && counter >= 1) {
+                    --counter;
+                }
+                throw;
+            }
         }
     }
 }
@@ -89,3 +165,119 @@ bool Barrier::incrementCounterAndCheck() {
     }
     return false;
 }
+
+
+// MARK: SpinLatch
+
+void SpinLatch::wait() noexcept {
+    if (!spinWhileEqual(released, 0)) {
+        parkWhileEqual(released, 0, numberParked);
+    }
+}
+
+bool SpinLatch::waitUntilDeadline(const steady_clock::time_point& deadline) noexcept {
+    if (spinWhileEqual(released, 0)) {
+        return true;
+    }
+    return parkWhileEqualUntil(released, 0, numberParked, deadline);
+}
+
+void SpinLatch::release() noexcept {
+    released.store(1);
+    if (numberParked.load() > 0) {
+        atomicNotifyAll(released);
+    }
+}
+
+void SpinLatch::reset() noexcept {
+    released.store(0);
+}
+
+
+// MARK: SpinBarrier
+
+namespace {
+    constexpr uint64_t countMask = 0xffffffffU;
+    inline uint32_t generationOf(uint64_t s) noexcept { return uint32_t(s >> 32); }
+    inline uint32_t countOf(uint64_t s) noexcept { return uint32_t(s & countMask); }
+}
+
+SpinBarrier::SpinBarrier(unsigned n) : SpinBarrier(n, completion_t()) {
+}
+
+SpinBarrier::SpinBarrier(unsigned n, completion_t&& completion)
+: n(n), completion(move(completion))
+{
+    contract::parameters({
+        KSS_EXPR(n > 0)
+    });
+}
+
+// Returns true if this thread completed the phase. Once the n-th thread has arrived
+// no other thread will modify the state until it starts the next generation, hence
+// the completion function has the phase to itself.
+bool SpinBarrier::arrive(uint32_t& gen) {
+    const auto s = state.fetch_add(1, memory_order_acq_rel);
+    gen = generationOf(s);
+    if (countOf(s) + 1 < n) {
+        return false;
+    }
+
+    if (completion) {
+        try {
+            completion();
+        }
+        catch (...) {
+            startNextGeneration(gen);
+            throw;
+        }
+    }
+    startNextGeneration(gen);
+    return true;
+}
+
+void SpinBarrier::startNextGeneration(uint32_t gen) noexcept {
+    const uint32_t next = gen + 1;
+    state.store(uint64_t(next) << 32, memory_order_release);
+    generation.store(next);
+    if (numberParked.load() > 0) {
+        atomicNotifyAll(generation);
+    }
+}
+
+void SpinBarrier::awaitGeneration(uint32_t gen) noexcept {
+    if (!spinWhileEqual(generation, gen)) {
+        parkWhileEqual(generation, gen, numberParked);
+    }
+}
+
+void SpinBarrier::wait() noexcept {
+    uint32_t gen = 0;
+    if (!arrive(gen)) {
+        awaitGeneration(gen);
+    }
+}
+
+bool SpinBarrier::waitUntilDeadline(const steady_clock::time_point& deadline) {
+    uint32_t gen = 0;
+    if (arrive(gen)
+        || spinWhileEqual(generation, gen)
+        || parkWhileEqualUntil(generation, gen, numberParked, deadline))
+    {
+        return true;
+    }
+
+    // Timed out, withdraw from the phase unless it has already been completed.
+    auto s = state.load();
+    while (generationOf(s) == gen && countOf(s) < n) {
+        if (state.compare_exchange_weak(s, s - 1)) {
+            return false;
+        }
+    }
+
+    // The last thread has arrived but may not yet have published the new generation.
+    while (generation.load(memory_order_acquire) == gen) {
+        std::this_thread::yield();
+    }
+    return true;
+}
@@ -10,11 +10,15 @@
 #ifndef kssthread_synchronizer_hpp
 #define kssthread_synchronizer_hpp
 
+#include <atomic>
 #include <condition_variable>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 
+#include "atomic_wait.hpp"
+
 namespace kss { namespace thread {
 
     /*!
@@ -66,6 +70,7 @@ namespace kss { namespace thread {
          the condition is true momentarily. It could become false again shortly.
          This is also a thread interruption point.
          @throws kss::thread::Interrupted if interrupted in an interruptible section
+         @throws kss::thread::Stopped if a stop is requested in a stoppable section
          @throws any exception that may be thrown by the underlying mutex or
             condition variable, or by the predicate.
          */
@@ -160,7 +165,10 @@ namespace kss { namespace thread {
         Barrier(unsigned n) : n(n) {}
 
         /*!
-         Wait until n threads have called the wait() method.
+         Wait until n threads have called the wait() method. This is also a thread
+         interruption point. If a stop is requested in a stoppable section, the thread
+         withdraws from the barrier (as it does when a timed wait fails).
+         @throws kss::thread::Stopped if a stop is requested in a stoppable section
          */
         void wait();
 
@@ -219,6 +227,210 @@ namespace kss { namespace thread {
         bool incrementCounterAndCheck();
     };
 
+
+    /*!
+     A lightweight latch. This has the same API as Latch, but is built on a single
+     atomic word instead of a mutex and condition variable. Waiting threads spin for
+     a short time (on multi-processor machines) and then park on the word itself (a
+     futex on Linux), and release() only enters the kernel if some thread is actually
+     parked.
+
+     Unlike Latch, SpinLatch::wait() is not a thread interruption point.
+     */
+    class SpinLatch {
+    public:
+        SpinLatch() = default;
+
+        SpinLatch(const SpinLatch&) = delete;
+        SpinLatch& operator=(const SpinLatch&) = delete;
+
+        /*!
+         Wait until the latch has been released.
+         */
+        void wait() noexcept;
+
+        /*!
+         Wait up to a given duration. Returns true if the latch was released.
+         */
+        template <class Duration>
+        bool waitFor(const Duration& dur) noexcept {
+            using namespace std::chrono;
+            return waitUntilDeadline(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        /*!
+         Wait up to a given time point. Returns true if the latch was released.
+         */
+        template <class TimePoint>
+        bool waitUntil(const TimePoint& tp) noexcept {
+            return waitUntilDeadline(_private::toSteadyDeadline(tp));
+        }
+
+        /*!
+         Release the latch. This will release all the waiting threads.
+         */
+        void release() noexcept;
+
+        /*!
+         Reset the latch. This will cause wait calls to wait once again.
+         */
+        void reset() noexcept;
+
+    private:
+        std::atomic<uint32_t> released { 0 };
+        std::atomic<uint32_t> numberParked { 0 };
+
+        bool waitUntilDeadline(const std::chrono::steady_clock::time_point& deadline) noexcept;
+    };
+
+
+    /*!
+     A lightweight, reusable barrier. Like Barrier, wait() returns once n threads have
+     called it. Unlike Barrier, it does not need to be reset: each time the n-th thread
+     arrives a new phase (or generation) is started, and the following n calls to wait()
+     form the next phase. Since each waiting thread is waiting for the end of its own
+     generation, a fast thread that moves on to the next phase can never be confused
+     with a slow thread that has not yet left the previous one.
+
+     The state is held in atomic words. Waiting threads spin for a short time (on
+     multi-processor machines) and then park on the generation word (a futex on Linux),
+     and the last thread to arrive only enters the kernel if some thread is actually
+     parked. This makes the barrier suitable for phase based algorithms that pass
+     through it many thousands of times per second.
+
+     If a timed wait fails, the thread withdraws from the current phase, i.e. the phase
+     will then require another call to wait().
+
+     Unlike Barrier, SpinBarrier::wait() is not a thread interruption point.
+     */
+    class SpinBarrier {
+    public:
+        /*!
+         Construct a barrier for n threads.
+         @throws std::invalid_argument if n is 0
+         */
+        explicit SpinBarrier(unsigned n);
+
+        SpinBarrier(const SpinBarrier&) = delete;
+        SpinBarrier& operator=(const SpinBarrier&) = delete;
+
+        /*!
+         Wait until n threads (including this one) have called wait() in the current
+         phase.
+         */
+        void wait() noexcept;
+
+        /*!
+         Wait up to a given duration. Returns true if the phase completed, and false
+         (after withdrawing from the phase) if it did not.
+         */
+        template <class Duration>
+        bool waitFor(const Duration& dur) noexcept {
+            using namespace std::chrono;
+            return waitUntilDeadline(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        /*!
+         Wait up to a given time point. See waitFor() for details.
+         */
+        template <class TimePoint>
+        bool waitUntil(const TimePoint& tp) noexcept {
+            return waitUntilDeadline(_private::toSteadyDeadline(tp));
+        }
+
+    protected:
+        using completion_t = std::function<void()>;
+
+        SpinBarrier(unsigned n, completion_t&& completion);
+
+        // These only throw if the completion function throws.
+        bool arrive(uint32_t& gen);
+        void awaitGeneration(uint32_t gen) noexcept;
+        bool waitUntilDeadline(const std::chrono::steady_clock::time_point& deadline);
+
+        uint32_t currentGeneration() const noexcept { return generation.load(std::memory_order_acquire); }
+
+    private:
+        // The generation is in the upper 32 bits and the number of threads that have
+        // arrived in the lower 32 bits. A copy of the generation is kept on its own,
+        // since that is the word that the threads park on.
+        std::atomic<uint64_t>   state { 0 };
+        std::atomic<uint32_t>   generation { 0 };
+        std::atomic<uint32_t>   numberParked { 0 };
+        const unsigned          n;
+        const completion_t      completion;
+
+        void startNextGeneration(uint32_t gen) noexcept;
+    };
+
+
+    /*!
+     A cyclic barrier is a SpinBarrier that runs a completion function once per phase.
+     The function is run by the last thread to arrive, before any of the threads in
+     the phase are released, hence it may safely read the results of the phase and
+     prepare the next one. (For example, swap the input and output buffers of an
+     iterative algorithm or check for convergence.) This avoids a separate serial
+     step and a second barrier in each iteration.
+
+     @code
+     CyclicBarrier b(tg.size() + 1, [&] { std::swap(in, out); ++iteration; });
+     parallel(tg, [&] { while (iteration < n) { step(0, in, out); b.wait(); } }, ...);
+     @endcode
+
+     Like SpinBarrier, the phases advance automatically, and a thread whose timed wait
+     fails withdraws from the phase. Note that if the completion function may throw,
+     the barrier should not be waited on through a SpinBarrier reference, since the
+     SpinBarrier wait methods are noexcept.
+     */
+    class CyclicBarrier : public SpinBarrier {
+    public:
+        /*!
+         Construct a barrier for n threads. The completion function, if there is one,
+         is called with no arguments at the end of each phase.
+         @throws std::invalid_argument if n is 0
+         */
+        explicit CyclicBarrier(unsigned n, completion_t completion = completion_t())
+        : SpinBarrier(n, std::move(completion)) {}
+
+        /*!
+         Wait until n threads (including this one) have called wait() in the current
+         phase, and the completion function has returned.
+         @throws any exception thrown by the completion function. This is thrown only
+            in the thread that ran it, and only after the phase has been completed and
+            the other threads released.
+         */
+        void wait() {
+            uint32_t gen = 0;
+            if (!arrive(gen)) {
+                awaitGeneration(gen);
+            }
+        }
+
+        /*!
+         Wait up to a given duration. Returns true if the phase completed, and false
+         (after withdrawing from the phase) if it did not.
+         @throws any exception thrown by the completion function (see wait())
+         */
+        template <class Duration>
+        bool waitFor(const Duration& dur) {
+            using namespace std::chrono;
+            return waitUntilDeadline(steady_clock::now() + duration_cast<steady_clock::duration>(dur));
+        }
+
+        /*!
+         Wait up to a given time point. See waitFor() for details.
+         */
+        template <class TimePoint>
+        bool waitUntil(const TimePoint& tp) {
+            return waitUntilDeadline(_private::toSteadyDeadline(tp));
+        }
+
+        /*!
+         Returns the number of phases that have been completed. (This wraps at 2^32.)
+         */
+        uint32_t phase() const noexcept { return currentGeneration(); }
+    };
+
 }}
 
 #endif
@@ -0,0 +1,133 @@
+//
+//  thread_attributes.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <kss/contract/all.h>
+
+#include "thread_attributes.hpp"
+
+using namespace std;
+using namespace kss::thread;
+
+namespace contract = kss::contract;
+
+using SchedulingPolicy = ThreadAttributes::SchedulingPolicy;
+
+
+namespace {
+
+    void throwIfError(int err, const char* methodname) {
+        if (err != 0) {
+            throw system_error(err, system_category(), methodname);
+        }
+    }
+
+#if defined(__linux)
+    // Parse a list such as "0-3,8,10-11" as found in the sysfs cpulist files.
+    vector<unsigned> parseCpuList(const string& list) {
+        vector<unsigned> cpus;
+        istringstream strm(list);
+        string item;
+        while (getline(strm, item, ',')) {
+            if (item.empty() || item == "\n") {
+                continue;
+            }
+            const auto dash = item.find('-');
+            const auto first = unsigned(stoul(item.substr(0, dash)));
+            const auto last = (dash == string::npos ? first : unsigned(stoul(item.substr(dash+1))));
+            for (auto cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    vector<unsigned> cpusOfNode(int node) {
+        ifstream strm("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+        string list;
+        const bool found = bool(getline(strm, list));
+        contract::parameters({
+            KSS_EXPR(found)
+        });
+        return parseCpuList(list);
+    }
+
+    void setAffinity(pthread_t h, const vector<unsigned>& cpus, int numaNode) {
+        auto all = cpus;
+        if (numaNode >= 0) {
+            const auto nodeCpus = cpusOfNode(numaNode);
+            all.insert(all.end(), nodeCpus.begin(), nodeCpus.end());
+        }
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (auto cpu : all) {
+            contract::parameters({
+                KSS_EXPR(cpu < CPU_SETSIZE)
+            });
+            CPU_SET(cpu, &cpuset);
+        }
+        throwIfError(pthread_setaffinity_np(h, sizeof(cpuset), &cpuset), "pthread_setaffinity_np");
+    }
+
+    void setName(pthread_t h, const string& name) {
+        // Linux limits the name to 16 bytes including the terminating null.
+        throwIfError(pthread_setname_np(h, name.substr(0, 15).c_str()), "pthread_setname_np");
+    }
+#else
+    void setAffinity(pthread_t, const vector<unsigned>&, int) {
+        throw system_error(ENOTSUP, system_category(), "thread affinity");
+    }
+
+    void setName(pthread_t, const string&) {
+        // Other platforms only allow a thread to set its own name.
+        throw system_error(ENOTSUP, system_category(), "pthread_setname_np");
+    }
+#endif
+
+    void setScheduling(pthread_t h, SchedulingPolicy policy, int priority) {
+        int p = SCHED_OTHER;
+        switch (policy) {
+            case SchedulingPolicy::fifo:        p = SCHED_FIFO; break;
+            case SchedulingPolicy::roundRobin:  p = SCHED_RR; break;
+            default:                            p = SCHED_OTHER; break;
+        }
+
+        sched_param param {};
+        param.sched_priority = priority;
+        throwIfError(pthread_setschedparam(h, p, &param), "pthread_setschedparam");
+    }
+}
+
+
+void ThreadAttributes::apply(std::thread& th) const {
+    contract::parameters({
+        KSS_EXPR(th.joinable())
+    });
+
+    const auto h = th.native_handle();
+    if (!cpus.empty() || numaNode >= 0) {
+        setAffinity(h, cpus, numaNode);
+    }
+    if (policy != SchedulingPolicy::inherit) {
+        setScheduling(h, policy, priority);
+    }
+    if (!name.empty()) {
+        setName(h, name);
+    }
+}
@@ -0,0 +1,91 @@
+//
+//  thread_attributes.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_thread_attributes_hpp
+#define kssthread_thread_attributes_hpp
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kss { namespace thread {
+
+    /*!
+     ThreadAttributes describes where and how a thread should run. It may be given to
+     the ParallelThreadGroup, ActionThread, ActionQueue, and ActionQueuePool
+     constructors, in which case it is applied to each of their threads as soon as
+     they are created and before they run any actions. It may also be applied to
+     any std::thread by calling apply().
+
+     The default constructed object leaves every attribute as it would be for a
+     newly created std::thread.
+
+     A note on stack size: std::thread provides no way to specify the stack size of
+     the thread it creates, and the stack cannot be changed once the thread exists,
+     hence there is no stack size attribute. The default stack size for all threads
+     may be changed using `ulimit -s` (or `setrlimit(RLIMIT_STACK, ...)` before the
+     process starts).
+
+     A note on NUMA: numaNode restricts the thread to the processors of that node.
+     Memory is not explicitly bound, but with the default (first touch) policy on
+     Linux the memory the thread allocates and first writes will also be placed on
+     that node.
+     */
+    struct ThreadAttributes {
+        enum class SchedulingPolicy {
+            inherit,        ///< do not change the policy or priority
+            other,          ///< SCHED_OTHER, the normal time-sharing policy
+            fifo,           ///< SCHED_FIFO, real-time first in, first out
+            roundRobin      ///< SCHED_RR, real-time round robin
+        };
+
+        /*!
+         The processors the thread may run on. If this and numaNode are both empty,
+         the thread may run on any processor.
+         */
+        std::vector<unsigned> cpus;
+
+        /*!
+         If non-negative, the thread may also run on any processor of this NUMA node.
+         */
+        int numaNode = -1;
+
+        /*!
+         The scheduling policy and priority. Note that the real-time policies
+         typically require elevated privileges.
+         */
+        SchedulingPolicy policy = SchedulingPolicy::inherit;
+        int priority = 0;
+
+        /*!
+         The thread name, as shown by debuggers and tools such as top. On Linux
+         names are limited to 15 characters and longer ones are truncated.
+         */
+        std::string name;
+
+        /*!
+         Returns true if this would not change any attributes.
+         */
+        bool empty() const noexcept {
+            return (cpus.empty() && numaNode < 0 && policy == SchedulingPolicy::inherit && name.empty());
+        }
+
+        /*!
+         Apply the attributes to a thread. This may be called from any thread.
+         @throws std::invalid_argument if th is not joinable, if a cpu is out of range,
+            or if numaNode does not exist
+         @throws std::system_error if one of the underlying pthread calls fails, or
+            if an attribute is not supported on this platform. (Currently cpus,
+            numaNode, and name are only supported on Linux.)
+         */
+        void apply(std::thread& th) const;
+    };
+}}
+
+#endif
@@ -0,0 +1,78 @@
+//
+//  versioned.cpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+
+#include "versioned.hpp"
+
+using namespace std;
+using namespace kss::thread;
+
+using kss::thread::_private::ReaderRecord;
+using kss::thread::_private::ReaderRegistration;
+
+
+// Epoch 0 is reserved to mean "not reading".
+atomic<uint64_t> kss::thread::_private::globalEpoch { 1 };
+
+namespace {
+    // The records are never deallocated, but are reused as threads come and go. A
+    // deque is used since it never moves its elements.
+    struct Registry {
+        mutex               lock;
+        deque<ReaderRecord> records;
+
+        static Registry& instance() {
+            static Registry registry;
+            return registry;
+        }
+    };
+}
+
+ReaderRegistration::ReaderRegistration() : record([] {
+    auto& reg = Registry::instance();
+    lock_guard<mutex> l(reg.lock);
+    for (auto& rec : reg.records) {
+        if (!rec.inUse) {
+            rec.inUse = true;
+            return &rec;
+        }
+    }
+    reg.records.emplace_back();
+    reg.records.back().inUse = true;
+    return &reg.records.back();
+}())
+{
+}
+
+ReaderRegistration::~ReaderRegistration() noexcept {
+    auto& reg = Registry::instance();
+    lock_guard<mutex> l(reg.lock);
+    record->epoch.store(0);
+    record->depth = 0;
+    record->inUse = false;
+}
+
+uint64_t kss::thread::_private::oldestActiveEpoch() noexcept {
+    auto oldest = numeric_limits<uint64_t>::max();
+    auto& reg = Registry::instance();
+    lock_guard<mutex> l(reg.lock);
+    for (auto& rec : reg.records) {
+        const auto e = rec.epoch.load();
+        if (e != 0) {
+            oldest = min(oldest, e);
+        }
+    }
+    return oldest;
+}
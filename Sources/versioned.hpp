@@ -0,0 +1,248 @@
+//
+//  versioned.hpp
+//  kssthread
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#ifndef kssthread_versioned_hpp
+#define kssthread_versioned_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace kss { namespace thread {
+
+    namespace _private {
+
+        // The epoch based reclamation shared by all Versioned objects. Each thread that
+        // reads has a record holding the epoch in which its outermost read section
+        // started, or 0 if it is not reading. The records are padded to keep each in
+        // its own cache line.
+        struct ReaderRecord {
+            std::atomic<uint64_t>   epoch { 0 };
+            unsigned                depth = 0;
+            bool                    inUse = false;
+            char                    padding[64 - sizeof(std::atomic<uint64_t>) - sizeof(unsigned) - sizeof(bool)];
+        };
+
+        extern std::atomic<uint64_t> globalEpoch;
+
+        // A thread's record is obtained the first time it reads, and is released (for
+        // reuse by another thread) when the thread exits.
+        class ReaderRegistration {
+        public:
+            ReaderRegistration();
+            ~ReaderRegistration() noexcept;
+            ReaderRecord* const record;
+        };
+
+        inline ReaderRecord& currentReaderRecord() {
+            static thread_local ReaderRegistration registration;
+            return *registration.record;
+        }
+
+        inline void enterReadSection(ReaderRecord& rec) noexcept {
+            if (rec.depth++ == 0) {
+                rec.epoch.store(globalEpoch.load(std::memory_order_acquire));
+            }
+        }
+
+        inline void leaveReadSection(ReaderRecord& rec) noexcept {
+            if (--rec.depth == 0) {
+                rec.epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        // Start a new epoch, returning the one that just ended.
+        inline uint64_t advanceEpoch() noexcept {
+            return globalEpoch.fetch_add(1);
+        }
+
+        // Returns the oldest epoch in which a read section that is still in progress
+        // was started, or UINT64_MAX if no thread is reading.
+        uint64_t oldestActiveEpoch() noexcept;
+    }
+
+
+    /*!
+     A versioned value provides read-copy-update (RCU) style access to a value that is
+     read very often and modified rarely. Readers obtain a Snapshot, which is a pointer
+     to the current version of the value, and may keep using it for as long as the
+     snapshot exists, even if the value is replaced in the meantime. Writers never
+     modify a version in place. Instead they publish a new copy, and the old version
+     is deleted once no snapshot can still refer to it (the "grace period").
+
+     Obtaining a snapshot performs no atomic read-modify-write operations. It records
+     the current epoch in a per-thread record (a cache line used only by the current
+     thread), and then loads the current version pointer. Writers are serialized by a
+     mutex and are comparatively expensive: each one allocates a new version and scans
+     the reader records to determine which of the old versions may be reclaimed.
+
+     Unlike SeqLock, T may be any copyable type and a read never needs to be retried.
+
+     @code
+     Versioned<RoutingTable> table;
+     {
+        auto snap = table.snapshot();       // readers
+        auto route = snap->lookup(address);
+     }
+     table.update([&](RoutingTable& t) { t.add(address, route); });
+     @endcode
+
+     Note that old versions are only reclaimed by store(), update(), and reclaim(),
+     hence after the last write some old versions may remain allocated until the next
+     write, a call to reclaim(), or the destruction of the Versioned object. Snapshots
+     must not outlive the Versioned object they were obtained from.
+     */
+    template <class T>
+    class Versioned {
+    public:
+        /*!
+         A snapshot is a read-only reference to the version that was current when it
+         was obtained. A snapshot must be destroyed by the thread that obtained it.
+         */
+        class Snapshot {
+        public:
+            Snapshot(Snapshot&& other) noexcept : value(other.value), record(other.record) {
+                other.record = nullptr;
+            }
+
+            ~Snapshot() noexcept {
+                if (record) {
+                    _private::leaveReadSection(*record);
+                }
+            }
+
+            Snapshot(const Snapshot&) = delete;
+            Snapshot& operator=(const Snapshot&) = delete;
+            Snapshot& operator=(Snapshot&&) = delete;
+
+            const T& operator*() const noexcept { return *value; }
+            const T* operator->() const noexcept { return value; }
+            const T* get() const noexcept { return value; }
+
+        private:
+            friend class Versioned;
+            Snapshot(const T* value, _private::ReaderRecord* record) noexcept
+            : value(value), record(record) {}
+
+            const T*                    value;
+            _private::ReaderRecord*     record;
+        };
+
+        /*!
+         Construct the object with the given initial value.
+         @throws any exception that allocating or moving a T may throw
+         */
+        explicit Versioned(T value = T()) : current(new T(std::move(value))) {}
+
+        /*!
+         Destroy the object and all its versions. There must not be any remaining
+         snapshots of it.
+         */
+        ~Versioned() noexcept {
+            delete current.load();
+            for (auto& r : retired) {
+                delete r.first;
+            }
+        }
+
+        Versioned(const Versioned&) = delete;
+        Versioned& operator=(const Versioned&) = delete;
+
+        /*!
+         Obtain a snapshot of the current version.
+         @throws std::bad_alloc if this is the first read of the current thread and its
+            reader record could not be allocated
+         */
+        Snapshot snapshot() const {
+            auto& rec = _private::currentReaderRecord();
+            _private::enterReadSection(rec);
+            return Snapshot(current.load(), &rec);
+        }
+
+        /*!
+         Return a copy of the current value.
+         @throws any exception that snapshot() or copying a T may throw
+         */
+        T load() const {
+            return *snapshot();
+        }
+
+        /*!
+         Publish a new version.
+         @throws any exception that allocating or moving a T may throw
+         */
+        void store(T value) {
+            std::unique_ptr<T> next(new T(std::move(value)));
+            std::lock_guard<std::mutex> l(writerLock);
+            publish(std::move(next));
+        }
+
+        /*!
+         Publish a new version that is a modified copy of the current one. fn is called
+         as fn(T&) with the copy. Concurrent updates are serialized, hence this may be
+         used for read-modify-write operations.
+         @throws any exception that fn, or copying a T, may throw. If fn throws the
+            current version remains unchanged.
+         */
+        template <class Fn>
+        void update(Fn&& fn) {
+            std::lock_guard<std::mutex> l(writerLock);
+            std::unique_ptr<T> next(new T(*current.load()));
+            fn(*next);
+            publish(std::move(next));
+        }
+
+        /*!
+         Delete the old versions that can no longer be referred to by any snapshot.
+         @throws any exception that std::mutex::lock may throw
+         */
+        void reclaim() {
+            std::lock_guard<std::mutex> l(writerLock);
+            reclaimRetired();
+        }
+
+    private:
+        std::atomic<const T*>                       current;
+        std::mutex                                  writerLock;
+        std::vector<std::pair<const T*, uint64_t>>  retired;
+
+        // A version retired in epoch e may be seen by a reader whose read section
+        // started in epoch e or earlier, but not by one that started later, since
+        // such a reader loaded the pointer after it had been replaced.
+        void publish(std::unique_ptr<T>&& next) {
+            retired.reserve(retired.size() + 1);
+            const auto old = current.exchange(next.release());
+            retired.emplace_back(old, _private::advanceEpoch());
+            reclaimRetired();
+        }
+
+        void reclaimRetired() noexcept {
+            if (retired.empty()) {
+                return;
+            }
+
+            const auto oldest = _private::oldestActiveEpoch();
+            auto keep = retired.begin();
+            for (auto& r : retired) {
+                if (r.second < oldest) {
+                    delete r.first;
+                }
+                else {
+                    *keep++ = r;
+                }
+            }
+            retired.erase(keep, retired.end());
+        }
+    };
+}}
+
+#endif
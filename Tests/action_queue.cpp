@@ -7,12 +7,17 @@
 //
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
 #include <thread>
+#include <vector>
 
+#include <unistd.h>
 #include <kss/test/all.h>
 #include <kss/util/all.h>
 #include <kss/thread/action_queue.hpp>
@@ -153,6 +158,440 @@ static ActionQueueTestSuite ts({
         // Cannot use exact matches for timing results, but this should easily pass.
         KSS_ASSERT(t < 900ms);
     }),
+    make_pair("ActionQueue move", [] {
+        atomic<int> count { 0 };
+        ActionQueue a(10);
+        a.addAction([&] { ++count; });
+        a.addAction(20ms, [&] { ++count; });
+
+        // The actions follow the implementation into the new queue.
+        ActionQueue b(move(a));
+        a.addAction([&] { ++count; });
+        a.wait();
+        KSS_ASSERT(a.cancel() == 0);
+        KSS_ASSERT(a.statistics().pending == 0);
+        b.wait();
+        KSS_ASSERT(count == 2);
+
+        // Assignment shuts down the target, discarding its pending actions.
+        ActionQueue c;
+        c.addAction(1s, [] { KSS_ASSERT(false); });
+        c = move(b);
+        c.addAction([&] { ++count; });
+        c.wait();
+        KSS_ASSERT(count == 3);
+
+        // A moved-from queue may be assigned to.
+        a = move(c);
+        a.addAction([&] { ++count; });
+        a.wait();
+        KSS_ASSERT(count == 4);
+    }),
+    make_pair("ActionQueue timing wheel", [] {
+        ActionQueue queue(ActionQueue::noLimit, ActionQueue::Storage::timingWheel);
+
+        KSS_ASSERT(isEqualTo<int>(5, [&] {
+            int counter = 0;
+            for (int i = 0; i < 5; ++i) {
+                queue.addAction([&]{ ++counter; });
+            }
+            queue.wait();
+            return counter;
+        }));
+
+        // Delays of more than 256ms will be placed in the second level of the wheel
+        // and must be cascaded down before they are run.
+        KSS_ASSERT(isTrue([&] {
+            vector<int> order;
+            bool ranOnTime = true;
+            const auto start = now<time_point_t>();
+            for (int i = 9; i >= 0; --i) {
+                const auto pause = chrono::milliseconds(i*40);
+                queue.addAction(pause, [&order, &ranOnTime, start, pause, i] {
+                    order.push_back(i);
+                    if (now<time_point_t>() < (start + pause)) {
+                        ranOnTime = false;
+                    }
+                });
+            }
+            queue.wait();
+            return ranOnTime && order == vector<int>({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+        }));
+
+        KSS_ASSERT(isEqualTo<size_t>(3, [&] {
+            queue.addAction(10s, "cancelme", []{ KSS_ASSERT(false); });
+            queue.addAction(30min, "cancelme", []{ KSS_ASSERT(false); });
+            queue.addAction(1000h, "cancelme", []{ KSS_ASSERT(false); });
+            queue.addAction(10s, "other", []{ KSS_ASSERT(false); });
+            return queue.cancel("cancelme");
+        }));
+        KSS_ASSERT(queue.cancel() == 1);
+
+        ActionQueue queue2(2, ActionQueue::Storage::timingWheel);
+        queue2.addAction(100s, []{ KSS_ASSERT(false); });
+        queue2.addAction(100s, []{ KSS_ASSERT(false); });
+        KSS_ASSERT(throwsException<system_error>([&] { queue2.addAction([]{}); }));
+    }),
+    make_pair("ActionQueue cancel by handle", [] {
+        for (auto storage : { ActionQueue::Storage::ordered, ActionQueue::Storage::timingWheel }) {
+            ActionQueue queue(ActionQueue::noLimit, storage);
+            KSS_ASSERT(isFalse([] { return bool(ActionQueue::Handle()); }));
+            KSS_ASSERT(queue.cancel(ActionQueue::Handle()) == 0);
+
+            int counter = 0;
+            auto h1 = queue.addAction(50ms, "group", [&]{ ++counter; });
+            auto h2 = queue.addAction(50ms, "group", [&]{ counter += 10; });
+            auto h3 = queue.addAction(50ms, [&]{ counter += 100; });
+            queue.addAction(50ms, "group", [&]{ counter += 1000; });
+            KSS_ASSERT(isTrue([&] { return bool(h1) && bool(h2) && bool(h3); }));
+
+            KSS_ASSERT(queue.cancel(h2) == 1);
+            KSS_ASSERT(queue.cancel(h2) == 0);
+            KSS_ASSERT(queue.cancel(h3) == 1);
+            KSS_ASSERT(queue.cancel("group") == 2);
+            KSS_ASSERT(queue.cancel(h1) == 0);
+            KSS_ASSERT(queue.cancel("group") == 0);
+
+            auto h4 = queue.addAction([&]{ ++counter; });
+            queue.wait();
+            KSS_ASSERT(queue.cancel(h4) == 0);
+            KSS_ASSERT(counter == 1);
+
+            // A handle from another queue must not affect this one.
+            ActionQueue other;
+            auto h5 = other.addAction(1h, []{});
+            KSS_ASSERT(queue.cancel(h5) == 0);
+            KSS_ASSERT(other.cancel(h5) == 1);
+        }
+    }),
+    make_pair("ActionQueuePool", [] {
+        // A slow action must not delay the others.
+        {
+            ActionQueuePool pool(4);
+            atomic<int> counter { 0 };
+            KSS_ASSERT(completesWithin(150ms, [&] {
+                for (int i = 0; i < 4; ++i) {
+                    pool.addAction([&] {
+                        this_thread::sleep_for(50ms);
+                        ++counter;
+                    });
+                }
+                pool.wait();
+            }));
+            KSS_ASSERT(counter == 4);
+
+            pool.addAction(1h, "late", []{ KSS_ASSERT(false); });
+            pool.addAction(1h, "late", []{ KSS_ASSERT(false); });
+            KSS_ASSERT(pool.cancel("late") == 2);
+        }
+
+        // Actions sharing an identifier may be serialized while others still run
+        // concurrently.
+        {
+            ActionQueuePool pool(4, ActionQueue::noLimit, ActionQueue::Storage::timingWheel,
+                                 ActionQueuePool::IdentifierPolicy::serialized);
+            atomic<int> inProgress { 0 };
+            atomic<int> maxInProgress { 0 };
+            atomic<int> others { 0 };
+            vector<int> order;
+            for (int i = 0; i < 5; ++i) {
+                pool.addAction(0ms, "serial", [&, i] {
+                    const int n = ++inProgress;
+                    if (n > maxInProgress) { maxInProgress = n; }
+                    order.push_back(i);
+                    this_thread::sleep_for(5ms);
+                    --inProgress;
+                });
+                pool.addAction([&] { ++others; });
+            }
+            pool.wait();
+            KSS_ASSERT(maxInProgress == 1);
+            KSS_ASSERT(others == 5);
+            KSS_ASSERT(order == vector<int>({ 0, 1, 2, 3, 4 }));
+        }
+    }),
+    make_pair("ActionQueue batched dispatch and addActions", [] {
+        for (auto storage : { ActionQueue::Storage::ordered, ActionQueue::Storage::timingWheel }) {
+            ActionQueue queue(ActionQueue::noLimit, storage, ActionQueue::Dispatch::batched);
+            int counter = 0;
+            vector<ActionQueue::action_t> actions(1000, [&]{ ++counter; });
+            queue.addActions(10ms, actions.begin(), actions.end());
+            queue.addActions(actions.begin(), actions.end());
+            queue.wait();
+            KSS_ASSERT(counter == 2000);
+
+            vector<ActionQueue::action_t> never(3, []{ KSS_ASSERT(false); });
+            queue.addActions(1h, "never", never.begin(), never.end());
+            KSS_ASSERT(queue.cancel("never") == 3);
+        }
+
+        // Either all of the actions are added or none of them.
+        ActionQueue queue(5);
+        vector<ActionQueue::action_t> actions(3, []{ KSS_ASSERT(false); });
+        queue.addActions(1h, actions.begin(), actions.end());
+        KSS_ASSERT(throwsException<system_error>([&] {
+            queue.addActions(1h, actions.begin(), actions.end());
+        }));
+        KSS_ASSERT(queue.cancel() == 3);
+    }),
+    make_pair("ActionQueue sub-millisecond delays and addActionAt", [] {
+        using chrono::steady_clock;
+        auto& queue = getQueue();
+
+        // This delay would have been rounded down to asap at millisecond resolution.
+        const auto start = steady_clock::now();
+        steady_clock::duration elapsed { 0 };
+        queue.addAction(chrono::microseconds(700), [&] { elapsed = steady_clock::now() - start; });
+        queue.wait();
+        KSS_ASSERT(elapsed >= chrono::microseconds(700));
+
+        vector<int> order;
+        const auto base = steady_clock::now();
+        queue.addActionAt(base + 3ms, [&] { order.push_back(3); });
+        queue.addActionAt(base + chrono::microseconds(1500), [&] { order.push_back(2); });
+        queue.addActionAt(chrono::time_point_cast<chrono::milliseconds>(base) - 1ms, [&] {
+            order.push_back(1);
+        });
+        queue.addActionAt(base + 1h, "later", []{ KSS_ASSERT(false); });
+        KSS_ASSERT(queue.cancel("later") == 1);
+        queue.wait();
+        KSS_ASSERT(order == vector<int>({ 1, 2, 3 }));
+        KSS_ASSERT(steady_clock::now() >= base + 3ms);
+    }),
+    make_pair("ActionQueue move-only actions", [] {
+        auto& queue = getQueue();
+        int result = 0;
+        auto p = make_unique<int>(42);
+        queue.addAction([&result, p = move(p)] { result = *p; });
+
+        ActionQueue::action_t fn = [&result] { ++result; };
+        queue.addAction(1ms, fn);
+        queue.wait();
+        KSS_ASSERT(result == 43);
+    }),
+    make_pair("ActionQueue many producers", [] {
+        auto& queue = getQueue();
+        const int numberOfProducers = 32;
+        const int actionsPerProducer = 2000;
+        int counter = 0;    // Only modified by the queue's thread.
+        vector<std::thread> producers;
+        for (int i = 0; i < numberOfProducers; ++i) {
+            producers.emplace_back([&] {
+                for (int j = 0; j < actionsPerProducer; ++j) {
+                    queue.addAction([&counter] { ++counter; });
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+        queue.wait();
+        KSS_ASSERT(counter == numberOfProducers * actionsPerProducer);
+
+        // Handles of asap actions may still be used.
+        atomic<bool> release { false };
+        queue.addAction([&] { while (!release) { this_thread::yield(); } });
+        auto h = queue.addAction([]{ KSS_ASSERT(false); });
+        KSS_ASSERT(queue.cancel(h) == 1);
+        KSS_ASSERT(queue.cancel(h) == 0);
+        release = true;
+        queue.wait();
+    }),
+    make_pair("ActionQueue addActionWait and addActionFor", [] {
+        resetQueue();
+        ActionQueue queue1(2);
+        atomic<bool> started { false };
+        atomic<bool> release { false };
+        atomic<int> counter { 0 };
+
+        // Keep the worker busy, then fill the queue.
+        queue1.addAction([&] {
+            started = true;
+            while (!release) { this_thread::sleep_for(1ms); }
+        });
+        while (!started) { this_thread::yield(); }
+        while (queue1.addActionFor(0ms, 100s, []{ KSS_ASSERT(false); })) {}
+        KSS_ASSERT(throwsException<system_error>([&] { queue1.addAction([]{}); }));
+
+        const auto start = now<time_point_t>();
+        const auto h = queue1.addActionFor(50ms, [&] { ++counter; });
+        KSS_ASSERT(!h);
+        KSS_ASSERT(now<time_point_t>() - start >= 50ms);
+
+        // Cancelling makes room for a waiting producer.
+        thread producer { [&] {
+            KSS_ASSERT(bool(queue1.addActionWait([&] { ++counter; })));
+        }};
+        this_thread::sleep_for(20ms);
+        KSS_ASSERT(queue1.cancel() >= 1);
+        producer.join();
+
+        // The worker taking an action also makes room.
+        queue1.addActionWait([&] { ++counter; });
+        thread producer2 { [&] {
+            KSS_ASSERT(bool(queue1.addActionFor(5s, 1ms, [&] { ++counter; })));
+        }};
+        this_thread::sleep_for(20ms);
+        release = true;
+        producer2.join();
+        queue1.wait();
+        KSS_ASSERT(counter == 3);
+    }),
+    make_pair("ActionQueue statistics", [] {
+        resetQueue();
+        ActionQueue queue1(3);
+        auto st = queue1.statistics();
+        KSS_ASSERT(st.pending == 0 && st.added == 0 && st.completed == 0);
+
+        atomic<int> observed { 0 };
+        atomic<bool> sawLate { false };
+        queue1.setActionObserver([&](const ActionQueue::ActionTiming& t) {
+            ++observed;
+            if (t.startTime - t.targetTime >= 20ms) { sawLate = true; }
+        });
+
+        // The first action blocks the worker, making those behind it late.
+        atomic<bool> started { false };
+        queue1.addAction([&] { started = true; this_thread::sleep_for(30ms); });
+        while (!started) { this_thread::yield(); }
+        queue1.addAction([]{});
+        queue1.addAction(1ms, []{});
+        const auto h = queue1.addAction(100s, []{ KSS_ASSERT(false); });
+        KSS_ASSERT(throwsException<system_error>([&] { queue1.addAction([]{}); }));
+        KSS_ASSERT(queue1.statistics().running == 1);
+        KSS_ASSERT(queue1.cancel(h) == 1);
+        queue1.wait();
+
+        st = queue1.statistics();
+        KSS_ASSERT(st.pending == 0 && st.running == 0);
+        KSS_ASSERT(st.peakPending == 3);
+        KSS_ASSERT(st.added == 4);
+        KSS_ASSERT(st.completed == 3);
+        KSS_ASSERT(st.cancelled == 1);
+        KSS_ASSERT(st.rejected == 1);
+        KSS_ASSERT(st.runTime.count() == 3);
+        KSS_ASSERT(st.runTime.max() >= 30ms);
+        KSS_ASSERT(st.lateness.count() == 3);
+        KSS_ASSERT(st.lateness.max() >= 20ms);
+        KSS_ASSERT(observed == 3);
+        KSS_ASSERT(sawLate);
+
+        // Asap actions on an unlimited queue are counted, but have no target time.
+        ActionQueue queue2;
+        queue2.setActionObserver([&](const ActionQueue::ActionTiming& t) {
+            KSS_ASSERT(t.targetTime == chrono::steady_clock::time_point::min());
+            KSS_ASSERT(t.finishTime >= t.startTime);
+        });
+        queue2.addAction([]{});
+        queue2.wait();
+        st = queue2.statistics();
+        KSS_ASSERT(st.added == 1 && st.completed == 1);
+        KSS_ASSERT(st.runTime.count() == 1 && st.lateness.count() == 0);
+
+        queue1.setActionObserver(nullptr);
+        queue1.resetStatistics();
+        st = queue1.statistics();
+        KSS_ASSERT(st.added == 0 && st.completed == 0 && st.cancelled == 0 && st.rejected == 0);
+        KSS_ASSERT(st.peakPending == 0 && st.runTime.count() == 0);
+        queue1.addAction([]{});
+        queue1.wait();
+        KSS_ASSERT(queue1.statistics().added == 1);
+        KSS_ASSERT(observed == 3);
+    }),
+    make_pair("ActionQueue priorities", [] {
+        resetQueue();
+        using Priority = ActionQueue::Priority;
+        ActionQueue queue1;
+        vector<int> order;
+        atomic<bool> release { false };
+        atomic<bool> started { false };
+        queue1.addAction([&] { started = true; while (!release) { this_thread::yield(); } });
+        while (!started) { this_thread::yield(); }
+
+        queue1.addAction({Priority::low}, 0ms, [&] { order.push_back(3); });
+        queue1.addAction([&] { order.push_back(2); });
+        queue1.addAction({Priority::normal}, 0ms, "id", [&] { order.push_back(2); });
+        queue1.addAction({Priority::high}, 0ms, [&] { order.push_back(1); });
+        release = true;
+        queue1.wait();
+        KSS_ASSERT(order == vector<int>({ 1, 2, 2, 3 }));
+
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            queue1.addAction({Priority::normal, -1ms}, 0ms, []{});
+        }));
+    }),
+    make_pair("ActionQueue slack", [] {
+        resetQueue();
+        for (auto storage : { ActionQueue::Storage::ordered, ActionQueue::Storage::timingWheel }) {
+            ActionQueue queue1(ActionQueue::noLimit, storage);
+            const auto start = chrono::steady_clock::now();
+            chrono::steady_clock::time_point sloppyTime, preciseTime;
+
+            // The sloppy action may wait for the precise one, but no longer than its slack.
+            queue1.addAction({ActionQueue::Priority::normal, 50ms}, 20ms, [&] {
+                sloppyTime = chrono::steady_clock::now();
+            });
+            queue1.addAction(40ms, [&] { preciseTime = chrono::steady_clock::now(); });
+            queue1.wait();
+            KSS_ASSERT(preciseTime >= start + 40ms);
+            KSS_ASSERT(sloppyTime >= start + 20ms);
+            KSS_ASSERT(sloppyTime < start + 150ms);
+            if (storage == ActionQueue::Storage::ordered) {
+                KSS_ASSERT(sloppyTime >= preciseTime);
+            }
+        }
+    }),
+    make_pair("IOActionQueue", [] {
+        resetQueue();
+        IOActionQueue queue1;
+        int fds[2];
+        KSS_ASSERT(pipe(fds) == 0);
+
+        atomic<int> bytesRead { 0 };
+        atomic<unsigned> lastEvents { 0 };
+        queue1.addFdAction(fds[0], IOActionQueue::readable, [&](int fd, unsigned events) {
+            char buf[16];
+            const auto n = read(fd, buf, sizeof(buf));
+            if (n > 0) { bytesRead += int(n); }
+            lastEvents = events;
+        });
+        KSS_ASSERT(throwsException<system_error>([&] {
+            queue1.addFdAction(fds[0], IOActionQueue::readable, [](int, unsigned) {});
+        }));
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            queue1.addFdAction(fds[1], 0, [](int, unsigned) {});
+        }));
+
+        // Timed actions and readiness actions share the one thread.
+        atomic<int> ticks { 0 };
+        queue1.addAction(100s, []{ KSS_ASSERT(false); });
+        queue1.addAction(5ms, [&] { ++ticks; });
+        KSS_ASSERT(write(fds[1], "hello", 5) == 5);
+        KSS_ASSERT(isEqualTo<int>(5, [&] {
+            while (bytesRead < 5) { this_thread::sleep_for(1ms); }
+            return int(bytesRead);
+        }));
+        KSS_ASSERT((lastEvents & IOActionQueue::readable) != 0);
+
+        // Cross-thread additions must wake the thread out of the poller.
+        KSS_ASSERT(completesWithin(500ms, [&] {
+            queue1.addAction([&] { ++ticks; });
+            queue1.addAction(1ms, [&] { ++ticks; });
+            while (ticks < 3) { this_thread::sleep_for(1ms); }
+        }));
+
+        KSS_ASSERT(queue1.removeFdAction(fds[0]));
+        KSS_ASSERT(!queue1.removeFdAction(fds[0]));
+        KSS_ASSERT(write(fds[1], "x", 1) == 1);
+        this_thread::sleep_for(20ms);
+        KSS_ASSERT(bytesRead == 5);
+        KSS_ASSERT(queue1.cancel() == 1);
+        queue1.wait();
+        KSS_ASSERT(queue1.statistics().completed == 4);
+
+        close(fds[0]);
+        close(fds[1]);
+    }),
     make_pair("RepeatingAction", [] {
         int immediateTick = 0;
         int slowTick = 0;
@@ -193,6 +632,114 @@ static ActionQueueTestSuite ts({
         KSS_ASSERT(fastTick >= 5 && fastTick <= 18);
         KSS_ASSERT(immediateTick == 1);
     }),
+    make_pair("RepeatingAction in a full queue", [] {
+        resetQueue();
+        ActionQueue queue1(2);
+        atomic<int> ticks { 0 };
+        {
+            RepeatingAction ra(5ms, queue1, [&] { ++ticks; });
+            queue1.addAction(100s, []{ KSS_ASSERT(false); });
+
+            // The producer takes the place vacated by the repeating action, which
+            // must nevertheless be able to requeue itself.
+            thread producer { [&] {
+                KSS_ASSERT(bool(queue1.addActionWait(100s, []{ KSS_ASSERT(false); })));
+            }};
+            producer.join();
+            const int ticksBefore = ticks;
+            this_thread::sleep_for(100ms);
+            KSS_ASSERT(ticks >= ticksBefore + 3);
+        }
+        queue1.cancel();
+    }),
+    make_pair("RepeatingAction fixed rate", [] {
+        resetQueue();
+        ActionQueue queue1;
+        const auto start = chrono::steady_clock::now();
+        vector<chrono::steady_clock::time_point> times;
+        mutex timesLock;
+        {
+            RepeatingAction ra(10ms, queue1, [&] {
+                lock_guard<mutex> l(timesLock);
+                times.push_back(chrono::steady_clock::now());
+                this_thread::sleep_for(3ms);
+            }, RepeatingAction::Schedule::fixedRate);
+            this_thread::sleep_for(105ms);
+        }
+        queue1.wait();
+
+        // The nth run is due at start + n * 10ms, regardless of the 3ms taken by
+        // each run. With a fixed delay there could be no more than 8 runs.
+        lock_guard<mutex> l(timesLock);
+        KSS_ASSERT(times.size() >= 9 && times.size() <= 10);
+        for (size_t i = 0; i < times.size(); ++i) {
+            KSS_ASSERT(times[i] >= start + 10ms * (i+1));
+        }
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            RepeatingAction ra(0ms, queue1, []{}, RepeatingAction::Schedule::fixedRate);
+        }));
+    }),
+    make_pair("RepeatingAction overruns", [] {
+        resetQueue();
+        ActionQueue queue1;
+        atomic<int> skipTicks { 0 };
+        atomic<int> catchUpTicks { 0 };
+        {
+            // The first run of each takes as long as five intervals.
+            RepeatingAction skipper(10ms, queue1, [&] {
+                if (skipTicks++ == 0) { this_thread::sleep_for(50ms); }
+            }, RepeatingAction::Schedule::fixedRate, RepeatingAction::Overrun::skip);
+            RepeatingAction catcher(10ms, queue1, [&] {
+                if (catchUpTicks++ == 0) { this_thread::sleep_for(50ms); }
+            }, RepeatingAction::Schedule::fixedRate, RepeatingAction::Overrun::catchUp);
+            this_thread::sleep_for(205ms);
+        }
+        queue1.wait();
+        KSS_ASSERT(skipTicks >= 8 && skipTicks <= 17);
+        KSS_ASSERT(catchUpTicks >= 17);
+        KSS_ASSERT(catchUpTicks > skipTicks);
+    }),
+    make_pair("RepeatingAction coalesced", [] {
+        resetQueue();
+        ActionQueue queue1;
+        constexpr size_t numberOfActions = 100;
+        array<atomic<int>, numberOfActions> ticks;
+        for (auto& t : ticks) { t = 0; }
+        {
+            vector<unique_ptr<RepeatingAction>> actions;
+            for (size_t i = 0; i < numberOfActions; ++i) {
+                actions.emplace_back(new RepeatingAction(10ms, queue1, [&ticks, i] { ++ticks[i]; },
+                                                         RepeatingAction::Schedule::coalesced));
+            }
+
+            // A member may be destroyed by an action of its own group.
+            unique_ptr<RepeatingAction> victim(new RepeatingAction(10ms, queue1, []{},
+                                                                   RepeatingAction::Schedule::coalesced));
+            RepeatingAction killer(10ms, queue1, [&] { victim.reset(); },
+                                   RepeatingAction::Schedule::coalesced);
+
+            this_thread::sleep_for(55ms);
+            KSS_ASSERT(queue1.statistics().pending == 1);
+            KSS_ASSERT(!victim);
+        }
+        queue1.wait();
+
+        // Each pass of the group is a single action.
+        const auto st = queue1.statistics();
+        KSS_ASSERT(st.completed >= 4 && st.completed <= 6);
+        for (const auto& t : ticks) {
+            KSS_ASSERT(t >= 4 && size_t(t) == st.completed);
+        }
+
+        // A new group may be formed once the old one has been retired.
+        atomic<int> more { 0 };
+        {
+            RepeatingAction ra(10ms, queue1, [&] { ++more; }, RepeatingAction::Schedule::coalesced);
+            this_thread::sleep_for(35ms);
+        }
+        queue1.wait();
+        KSS_ASSERT(more >= 2);
+    }),
     make_pair("RepeatingAction destructor does not wait for pending actions", [] {
         // Cannot use exact matches for timing results, but this should easily pass.
         KSS_ASSERT(completesWithin(100ms, [] {
@@ -204,5 +751,42 @@ static ActionQueueTestSuite ts({
             }
             resetQueue();
         }));
+    }),
+    make_pair("RepeatingAction destroyed while running", [] {
+        for (auto sched : { RepeatingAction::Schedule::fixedDelay, RepeatingAction::Schedule::fixedRate }) {
+            ActionQueue queue;
+            atomic<bool> started { false };
+            atomic<bool> finished { false };
+            auto ra = make_unique<RepeatingAction>(1ms, queue, [&] {
+                started = true;
+                this_thread::sleep_for(20ms);
+                finished = true;
+            }, sched);
+            while (!started) { this_thread::yield(); }
+
+            // The destructor must wait for the run in progress.
+            ra.reset();
+            KSS_ASSERT(finished);
+            queue.wait();
+        }
+
+        // A repeating action may destroy itself.
+        ActionQueue queue;
+        atomic<int> runs { 0 };
+        mutex raLock;
+        unique_ptr<RepeatingAction> ra;
+        {
+            lock_guard<mutex> l(raLock);
+            ra = make_unique<RepeatingAction>(1ms, queue, [&] {
+                ++runs;
+                lock_guard<mutex> l(raLock);
+                ra.reset();
+            });
+        }
+        this_thread::sleep_for(20ms);
+        queue.wait();
+        KSS_ASSERT(runs == 1);
+        lock_guard<mutex> l(raLock);
+        KSS_ASSERT(!ra);
     })
 });
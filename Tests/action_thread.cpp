@@ -7,8 +7,13 @@
 //  Licensing follows the MIT License.
 //
 
+#include <memory>
+#include <stdexcept>
+#include <string>
+
 #include <kss/test/all.h>
 #include <kss/thread/action_thread.hpp>
+#include <kss/thread/future.hpp>
 
 using namespace std;
 using namespace kss::test;
@@ -39,5 +44,61 @@ static TestSuite ts("action_thread", {
             }
             return counter;
         }));
+    }),
+    make_pair("ActionThread run and get", [] {
+        ActionThread<int> th;
+        int total = 0;
+        for (int i = 0; i < 10000; ++i) {
+            th.run([i] { return i; });
+            total += th.get();
+        }
+        KSS_ASSERT(total == (9999 * 10000) / 2);
+
+        th.run([]() -> int { throw runtime_error("oops"); });
+        th.wait();
+        KSS_ASSERT(throwsException<runtime_error>([&] { th.get(); }));
+
+        // The thread must still be usable after an exception.
+        th.run([] { return 3; });
+        KSS_ASSERT(th.get() == 3);
+
+        ActionThread<string> sth;
+        auto p = make_unique<string>("hello");
+        sth.run([p = move(p)] { return *p + " world"; });
+        KSS_ASSERT(sth.get() == "hello world");
+
+        ActionThread<void> vth;
+        int counter = 0;
+        for (int i = 0; i < 100; ++i) {
+            vth.run([&counter] { ++counter; });
+            vth.wait();
+        }
+        KSS_ASSERT(counter == 100);
+
+        // Mixing the two modes is permitted.
+        auto fut = vth.async([&counter] { ++counter; });
+        fut.wait();
+        vth.run([&counter] { ++counter; });
+        vth.get();
+        KSS_ASSERT(counter == 102);
+    }),
+    make_pair("ActionThread next action started by the result", [] {
+        // The thread is no longer busy by the time the result is available, even
+        // though its task has not yet returned, hence whoever receives the result
+        // may immediately start the next action. (In debug mode, starting an action
+        // while one is still running fails a precondition.)
+        ActionThread<int> th;
+        int total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            total += th.async([i] { return i; }).get();
+            total += th.submit([i] { return i; }).get();
+        }
+        KSS_ASSERT(total == 999 * 1000);
+
+        // Including a continuation run by the thread itself.
+        auto fut = th.submit([] { return 1; }).then([&th](int i) {
+            return th.submit([i] { return i + 1; });
+        });
+        KSS_ASSERT(fut.get() == 2);
     })
 });
@@ -0,0 +1,124 @@
+//
+//  bounded_queue.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kss/test/all.h>
+#include <kss/thread/bounded_queue.hpp>
+
+using namespace std;
+using namespace kss::thread;
+using namespace kss::test;
+
+
+static TestSuite ts("bounded_queue", {
+    make_pair("basic usage", [] {
+        KSS_ASSERT(throwsException<invalid_argument>([] { BoundedQueue<int> q(0); }));
+
+        BoundedQueue<string> q(3);
+        KSS_ASSERT(q.capacity() == 3);
+        KSS_ASSERT(q.empty());
+        KSS_ASSERT(q.tryPush(string("one")));
+        const string two("two");
+        KSS_ASSERT(q.tryPush(two));
+        KSS_ASSERT(q.tryPush(string("three")));
+        KSS_ASSERT(q.size() == 3);
+
+        string s("four");
+        KSS_ASSERT(!q.tryPush(move(s)));
+        KSS_ASSERT(s == "four");
+
+        string val;
+        KSS_ASSERT(q.tryPop(val) && val == "one");
+        KSS_ASSERT(q.tryPush(move(s)));
+        KSS_ASSERT(q.tryPop(val) && val == "two");
+        KSS_ASSERT(q.tryPop(val) && val == "three");
+        KSS_ASSERT(q.tryPop(val) && val == "four");
+        KSS_ASSERT(!q.tryPop(val) && val == "four");
+        KSS_ASSERT(q.empty());
+    }),
+    make_pair("capacity of one", [] {
+        BoundedQueue<int> q(1);
+        int v = 0;
+        for (int i = 0; i < 3; ++i) {
+            KSS_ASSERT(q.tryPush(i));
+            KSS_ASSERT(!q.tryPush(10));
+            KSS_ASSERT(q.tryPop(v) && v == i);
+            KSS_ASSERT(!q.tryPop(v));
+        }
+    }),
+    make_pair("destroys remaining items", [] {
+        auto p = make_shared<int>(1);
+        {
+            BoundedQueue<shared_ptr<int>> q(4);
+            for (int i = 0; i < 3; ++i) {
+                KSS_ASSERT(q.tryPush(p));
+            }
+            shared_ptr<int> out;
+            KSS_ASSERT(q.tryPop(out));
+            KSS_ASSERT(p.use_count() == 4);
+        }
+        KSS_ASSERT(p.use_count() == 1);
+    }),
+    make_pair("multiple producers and consumers", [] {
+        BoundedQueue<uint64_t> q(16);
+        constexpr unsigned numberOfProducers = 3;
+        constexpr uint64_t itemsPerProducer = 5000;
+        atomic<uint64_t> sum { 0 };
+        atomic<uint64_t> count { 0 };
+        atomic<bool> producersDone { false };
+
+        vector<thread> consumers;
+        for (unsigned i = 0; i < 3; ++i) {
+            consumers.emplace_back([&] {
+                uint64_t v = 0;
+                for (;;) {
+                    if (q.tryPop(v)) {
+                        sum += v;
+                        ++count;
+                    }
+                    else if (producersDone.load() && q.empty()) {
+                        break;
+                    }
+                    else {
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        vector<thread> producers;
+        for (unsigned i = 0; i < numberOfProducers; ++i) {
+            producers.emplace_back([&] {
+                for (uint64_t v = 1; v <= itemsPerProducer; ++v) {
+                    uint64_t item = v;
+                    while (!q.tryPush(move(item))) {
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+        producersDone = true;
+        for (auto& t : consumers) {
+            t.join();
+        }
+
+        KSS_ASSERT(count.load() == numberOfProducers * itemsPerProducer);
+        KSS_ASSERT(sum.load() == numberOfProducers * (itemsPerProducer * (itemsPerProducer + 1) / 2));
+    })
+});
@@ -0,0 +1,162 @@
+//
+//  channel.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kss/test/all.h>
+#include <kss/thread/channel.hpp>
+#include <kss/thread/interruptible.hpp>
+
+using namespace std;
+using namespace kss::thread;
+using namespace kss::test;
+
+
+static TestSuite ts("channel", {
+    make_pair("basic usage", [] {
+        Channel<int> ch(2);
+        KSS_ASSERT(ch.capacity() == 2);
+        KSS_ASSERT(ch.push(1));
+        KSS_ASSERT(ch.tryPush(2));
+        KSS_ASSERT(!ch.tryPush(3));
+        KSS_ASSERT(ch.size() == 2);
+
+        int v = 0;
+        KSS_ASSERT(ch.pop(v) && v == 1);
+        KSS_ASSERT(ch.tryPop(v) && v == 2);
+        KSS_ASSERT(!ch.tryPop(v));
+
+        // Lvalues are copied.
+        Channel<string> strs(3);
+        const string a("a");
+        string b("b");
+        KSS_ASSERT(strs.tryPush(a));
+        KSS_ASSERT(strs.pushFor(b, chrono::milliseconds(10)));
+        KSS_ASSERT(strs.pushUntil(a, chrono::steady_clock::now() + chrono::milliseconds(10)));
+        KSS_ASSERT(a == "a" && b == "b");
+        string s;
+        KSS_ASSERT(strs.pop(s) && s == "a");
+        KSS_ASSERT(strs.pop(s) && s == "b");
+        KSS_ASSERT(strs.pop(s) && s == "a");
+    }),
+    make_pair("timeouts", [] {
+        Channel<unique_ptr<int>> ch(1);
+        KSS_ASSERT(ch.pushFor(unique_ptr<int>(new int(1)), chrono::milliseconds(10)));
+
+        unique_ptr<int> p(new int(2));
+        auto start = chrono::steady_clock::now();
+        KSS_ASSERT(!ch.pushFor(move(p), chrono::milliseconds(50)));
+        KSS_ASSERT(!ch.pushUntil(move(p), chrono::system_clock::now() + chrono::milliseconds(50)));
+        KSS_ASSERT(chrono::steady_clock::now() - start >= chrono::milliseconds(100));
+        KSS_ASSERT(p && *p == 2);
+
+        unique_ptr<int> out;
+        KSS_ASSERT(ch.popFor(out, chrono::milliseconds(10)) && *out == 1);
+        start = chrono::steady_clock::now();
+        KSS_ASSERT(!ch.popFor(out, chrono::milliseconds(50)));
+        KSS_ASSERT(!ch.popUntil(out, chrono::steady_clock::now() + chrono::milliseconds(50)));
+        KSS_ASSERT(chrono::steady_clock::now() - start >= chrono::milliseconds(100));
+    }),
+    make_pair("blocking and close", [] {
+        Channel<int> ch(1);
+        ch.push(1);
+        bool pushed = false;
+        thread producer { [&] {
+            pushed = ch.push(2);        // blocks until the consumer makes room
+        }};
+        int v = 0;
+        KSS_ASSERT(ch.pop(v) && v == 1);
+        KSS_ASSERT(ch.popFor(v, chrono::seconds(5)) && v == 2);
+        producer.join();
+        KSS_ASSERT(pushed);
+
+        bool popped = true;
+        thread consumer { [&] {
+            int value = 0;
+            popped = ch.pop(value);     // blocks until the channel is closed
+        }};
+        this_thread::sleep_for(chrono::milliseconds(20));
+        ch.close();
+        consumer.join();
+        KSS_ASSERT(!popped);
+        KSS_ASSERT(ch.isClosed());
+        KSS_ASSERT(!ch.push(3));
+    }),
+    make_pair("remaining items are popped after close", [] {
+        Channel<int> ch(4);
+        ch.push(1);
+        ch.push(2);
+        ch.close();
+        int v = 0;
+        KSS_ASSERT(ch.pop(v) && v == 1);
+        KSS_ASSERT(ch.pop(v) && v == 2);
+        KSS_ASSERT(!ch.pop(v));
+    }),
+    make_pair("pipeline", [] {
+        Channel<uint64_t> stage1(8);
+        Channel<uint64_t> stage2(8);
+        constexpr uint64_t numberOfItems = 10000;
+
+        thread producer { [&] {
+            for (uint64_t i = 1; i <= numberOfItems; ++i) {
+                stage1.push(i);
+            }
+            stage1.close();
+        }};
+
+        atomic<unsigned> workersRemaining { 2 };
+        vector<thread> workers;
+        for (int i = 0; i < 2; ++i) {
+            workers.emplace_back([&] {
+                uint64_t v = 0;
+                while (stage1.pop(v)) {
+                    stage2.push(v * 2);
+                }
+                if (--workersRemaining == 0) {
+                    stage2.close();
+                }
+            });
+        }
+
+        uint64_t sum = 0;
+        uint64_t count = 0;
+        uint64_t v = 0;
+        while (stage2.pop(v)) {
+            sum += v;
+            ++count;
+        }
+        producer.join();
+        for (auto& t : workers) {
+            t.join();
+        }
+        KSS_ASSERT(count == numberOfItems);
+        KSS_ASSERT(sum == numberOfItems * (numberOfItems + 1));
+    }),
+    make_pair("is interruptible", [] {
+        Channel<int> ch(1);
+        bool wasInterrupted = false;
+        thread th { [&] {
+            interruptible { [&] {
+                onInterrupted([&] { wasInterrupted = true; });
+                int v = 0;
+                ch.pop(v);
+            }};
+        }};
+        this_thread::sleep_for(chrono::milliseconds(20));
+        interrupt(th);
+        th.join();
+        KSS_ASSERT(wasInterrupted);
+    })
+});
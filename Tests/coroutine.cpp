@@ -0,0 +1,127 @@
+//
+//  coroutine.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <kss/thread/coroutine.hpp>
+
+#if defined(KSS_THREAD_HAVE_COROUTINES)
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <kss/test/all.h>
+#include <kss/thread/action_queue.hpp>
+#include <kss/thread/action_thread.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    DetachedTask tick(ActionQueue& q, int steps, atomic<int>& ticks, atomic<int>& finished) {
+        for (int i = 0; i < steps; ++i) {
+            co_await q.after(1ms);
+            ++ticks;
+        }
+        ++finished;
+    }
+
+    DetachedTask hop(ActionQueue& q, std::thread::id& where, atomic<bool>& done) {
+        co_await q.schedule();
+        where = this_thread::get_id();
+        done = true;
+    }
+
+    DetachedTask compute(ActionThread<int>& th, ActionQueue& q, int& value, string& error, atomic<bool>& done) {
+        value = co_await th.awaitable([] { return 42; });
+        try {
+            co_await th.awaitable([]() -> int { throw runtime_error("oops"); });
+        }
+        catch (const runtime_error& e) {
+            error = e.what();
+        }
+        co_await q.schedule();
+        done = true;
+    }
+
+    DetachedTask rejected(ActionQueue& q, atomic<int>& failures, atomic<bool>& done) {
+        try {
+            co_await q.after(1ms);
+        }
+        catch (const system_error& e) {
+            if (e.code().value() == EAGAIN) { ++failures; }
+        }
+        done = true;
+    }
+
+    template <class Pred>
+    void waitUntil(Pred pred) {
+        const auto deadline = steady_clock::now() + 5s;
+        while (!pred() && steady_clock::now() < deadline) {
+            this_thread::sleep_for(1ms);
+        }
+    }
+}
+
+static TestSuite ts("coroutine", {
+    make_pair("ActionQueue after and schedule", [] {
+        ActionQueue q(ActionQueue::noLimit, ActionQueue::Storage::timingWheel);
+        atomic<int> ticks { 0 };
+        atomic<int> finished { 0 };
+        for (int i = 0; i < 1000; ++i) {
+            tick(q, 5, ticks, finished);
+        }
+        waitUntil([&] { return finished == 1000; });
+        KSS_ASSERT(finished == 1000);
+        KSS_ASSERT(ticks == 5000);
+
+        std::thread::id queueThread;
+        q.addAction([&] { queueThread = this_thread::get_id(); });
+        q.wait();
+
+        std::thread::id where;
+        atomic<bool> done { false };
+        hop(q, where, done);
+        waitUntil([&] { return bool(done); });
+        KSS_ASSERT(done && where == queueThread);
+    }),
+    make_pair("ActionThread awaitable", [] {
+        ActionThread<int> th;
+        ActionQueue q;
+        int value = 0;
+        string error;
+        atomic<bool> done { false };
+        compute(th, q, value, error, done);
+        waitUntil([&] { return bool(done); });
+        KSS_ASSERT(done);
+        KSS_ASSERT(value == 42);
+        KSS_ASSERT(error == "oops");
+    }),
+    make_pair("exceptions from adding the action", [] {
+        ActionQueue q(1);
+        atomic<bool> release { false };
+        atomic<bool> started { false };
+        q.addAction([&] { started = true; while (!release) { this_thread::sleep_for(1ms); } });
+        waitUntil([&] { return bool(started); });
+        q.addAction(100s, []{});
+
+        atomic<int> failures { 0 };
+        atomic<bool> done { false };
+        rejected(q, failures, done);
+        KSS_ASSERT(done && failures == 1);
+        release = true;
+        q.cancel();
+    })
+});
+
+#endif
@@ -0,0 +1,197 @@
+//
+//  future.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <kss/test/all.h>
+#include <kss/thread/action_queue.hpp>
+#include <kss/thread/action_thread.hpp>
+#include <kss/thread/future.hpp>
+#include <kss/thread/parallel.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    bool hasErrorCode(const function<void()>& fn, future_errc code) {
+        try {
+            fn();
+        }
+        catch (const future_error& e) {
+            return (e.code() == code);
+        }
+        return false;
+    }
+}
+
+static TestSuite ts("future", {
+    make_pair("Promise and Future", [] {
+        Promise<string> p;
+        auto f = p.getFuture();
+        KSS_ASSERT(f.valid() && !f.isReady());
+        KSS_ASSERT(hasErrorCode([&] { p.getFuture(); }, future_errc::future_already_retrieved));
+
+        thread th { [&] { this_thread::sleep_for(10ms); p.setValue("hello"); } };
+        KSS_ASSERT(f.get() == "hello");
+        KSS_ASSERT(!f.valid());
+        KSS_ASSERT(hasErrorCode([&] { f.get(); }, future_errc::no_state));
+        KSS_ASSERT(hasErrorCode([&] { p.setValue("again"); }, future_errc::promise_already_satisfied));
+        th.join();
+
+        Future<int> broken;
+        {
+            Promise<int> p2;
+            broken = p2.getFuture();
+        }
+        KSS_ASSERT(hasErrorCode([&] { broken.get(); }, future_errc::broken_promise));
+
+        Promise<void> pv;
+        auto fv = pv.getFuture();
+        pv.setException(make_exception_ptr(runtime_error("failed")));
+        KSS_ASSERT(throwsException<runtime_error>([&] { fv.get(); }));
+
+        KSS_ASSERT(makeReadyFuture(3).get() == 3);
+        makeReadyFuture().get();
+        KSS_ASSERT(throwsException<runtime_error>([] {
+            makeExceptionalFuture<int>(make_exception_ptr(runtime_error("x"))).get();
+        }));
+    }),
+    make_pair("then and recover", [] {
+        // Continuations added before and after the result is set.
+        Promise<int> p;
+        auto f = p.getFuture().then([](int i) { return i * 2; }).then([](int i) { return to_string(i); });
+        p.setValue(21);
+        KSS_ASSERT(f.isReady());
+        KSS_ASSERT(f.get() == "42");
+        KSS_ASSERT(makeReadyFuture(1).then([](int i) { return i + 1; }).get() == 2);
+
+        // Exceptions skip the continuations until they are recovered.
+        atomic<bool> called { false };
+        auto g = makeExceptionalFuture<int>(make_exception_ptr(runtime_error("bad")))
+            .then([&](int i) { called = true; return i; })
+            .recover([](exception_ptr ep) {
+                try { rethrow_exception(ep); }
+                catch (const runtime_error& e) { return int(string(e.what()).size()); }
+            });
+        KSS_ASSERT(g.get() == 3);
+        KSS_ASSERT(!called);
+        KSS_ASSERT(makeReadyFuture(5).recover([](exception_ptr) { return 0; }).get() == 5);
+        KSS_ASSERT(throwsException<logic_error>([] {
+            makeReadyFuture(5).then([](int) -> int { throw logic_error("oops"); }).get();
+        }));
+
+        // Continuations returning futures are unwrapped.
+        Promise<int> inner;
+        auto innerFuture = make_shared<Future<int>>(inner.getFuture());
+        auto h = makeReadyFuture().then([innerFuture] { return move(*innerFuture); });
+        KSS_ASSERT(!h.isReady());
+        inner.setValue(7);
+        KSS_ASSERT(h.get() == 7);
+    }),
+    make_pair("continuations on threads and queues", [] {
+        ActionThread<int> th;
+        ActionQueue q;
+        std::thread::id computeThread;
+        std::thread::id continuationThread;
+        std::thread::id queueThread;
+        q.addAction([&] { queueThread = this_thread::get_id(); });
+        q.wait();
+
+        // The gate ensures the continuations are attached before the result is set.
+        Promise<void> gate;
+        auto gateFuture = make_shared<Future<void>>(gate.getFuture());
+        auto f = th.submit([&, gateFuture] {
+                computeThread = this_thread::get_id();
+                gateFuture->wait();
+                return 10;
+            })
+            .then([&](int i) { continuationThread = this_thread::get_id(); return i + 1; })
+            .then(q, [&](int i) { KSS_ASSERT(this_thread::get_id() == queueThread); return i * 2; });
+        gate.setValue();
+        KSS_ASSERT(f.get() == 22);
+        KSS_ASSERT(computeThread == continuationThread);
+        KSS_ASSERT(computeThread != this_thread::get_id());
+
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            th.submit([]() -> int { throw runtime_error("in thread"); }).get();
+        }));
+
+        // An action that cannot be added to the queue becomes the exception.
+        ActionQueue full(1);
+        atomic<bool> release { false };
+        atomic<bool> started { false };
+        full.addAction([&] { started = true; while (!release) { this_thread::sleep_for(1ms); } });
+        while (!started) { this_thread::yield(); }
+        full.addAction(100s, []{});
+        auto r = makeReadyFuture(1).then(full, [](int i) { return i; });
+        KSS_ASSERT(throwsException<system_error>([&] { r.get(); }));
+        release = true;
+        full.cancel();
+
+        // The queue may be destroyed before the result is provided.
+        Promise<int> late;
+        Future<int> orphan;
+        {
+            ActionQueue gone;
+            orphan = late.getFuture().then(gone, [](int i) { return i; });
+        }
+        late.setValue(1);
+        KSS_ASSERT(throwsException<future_error>([&] { orphan.get(); }));
+    }),
+    make_pair("whenAll and whenAny", [] {
+        ParallelThreadGroup tg(4);
+        vector<Future<int>> futures;
+        for (int i = 0; i < 4; ++i) {
+            futures.push_back(tg.submit([i] { this_thread::sleep_for(milliseconds(5 * (4 - i))); return i; }));
+        }
+        auto all = whenAll(move(futures));
+        const auto values = all.get();
+        KSS_ASSERT(values == vector<int>({ 0, 1, 2, 3 }));
+        tg.waitForAll();
+
+        KSS_ASSERT(whenAll(vector<Future<int>>()).get().empty());
+
+        vector<Future<void>> voids;
+        Promise<void> p1, p2;
+        voids.push_back(p1.getFuture());
+        voids.push_back(p2.getFuture());
+        auto v = whenAll(move(voids));
+        p2.setException(make_exception_ptr(runtime_error("second")));
+        KSS_ASSERT(!v.isReady());
+        p1.setValue();
+        KSS_ASSERT(throwsException<runtime_error>([&] { v.get(); }));
+
+        vector<Promise<string>> promises(3);
+        vector<Future<string>> strings;
+        for (auto& p : promises) {
+            strings.push_back(p.getFuture());
+        }
+        auto any = whenAny(move(strings));
+        promises[2].setValue("two");
+        promises[0].setValue("zero");
+        const auto first = any.get();
+        KSS_ASSERT(first.first == 2 && first.second == "two");
+
+        vector<Future<void>> voids2;
+        voids2.push_back(makeReadyFuture());
+        KSS_ASSERT(whenAny(move(voids2)).get() == 0);
+        KSS_ASSERT(throwsException<invalid_argument>([] { whenAny(vector<Future<int>>()); }));
+    })
+});
@@ -0,0 +1,100 @@
+//
+//  inline_function.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <kss/test/all.h>
+#include <kss/thread/inline_function.hpp>
+
+using namespace std;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    int addOne(int i) { return i + 1; }
+
+    struct Counted {
+        static int instances;
+        Counted() { ++instances; }
+        Counted(const Counted&) { ++instances; }
+        Counted(Counted&&) noexcept { ++instances; }
+        ~Counted() { --instances; }
+        void operator()() {}
+    };
+    int Counted::instances = 0;
+}
+
+
+static TestSuite ts("inline_function", {
+    make_pair("construction and calls", [] {
+        InlineFunction<int(int)> empty;
+        KSS_ASSERT(isFalse([&] { return bool(empty); }));
+        KSS_ASSERT(throwsException<bad_function_call>([&] { empty(1); }));
+
+        InlineFunction<int(int)> fnptr = addOne;
+        KSS_ASSERT(fnptr(1) == 2);
+        int (*nullFn)(int) = nullptr;
+        InlineFunction<int(int)> fromNull = nullFn;
+        KSS_ASSERT(isFalse([&] { return bool(fromNull); }));
+        InlineFunction<int(int)> fromEmpty = function<int(int)>();
+        KSS_ASSERT(isFalse([&] { return bool(fromEmpty); }));
+
+        int offset = 10;
+        InlineFunction<int(int)> lambda = [offset](int i) { return i + offset; };
+        KSS_ASSERT(lambda(1) == 11);
+        KSS_ASSERT(isTrue([&] { return lambda.isInline(); }));
+
+        int counter = 0;
+        InlineFunction<void()> mutableLambda = [&counter, n = 0]() mutable { counter = ++n; };
+        mutableLambda();
+        mutableLambda();
+        KSS_ASSERT(counter == 2);
+
+        lambda = nullptr;
+        KSS_ASSERT(isFalse([&] { return bool(lambda); }));
+    }),
+    make_pair("move-only and large callables", [] {
+        auto p = make_unique<int>(5);
+        InlineFunction<int()> fn = [p = move(p)] { return *p; };
+        KSS_ASSERT(fn() == 5);
+
+        InlineFunction<int()> moved = move(fn);
+        KSS_ASSERT(isFalse([&] { return bool(fn); }));
+        KSS_ASSERT(moved() == 5);
+
+        array<int, 64> big {};
+        big[63] = 7;
+        InlineFunction<int()> large = [big] { return big[63]; };
+        KSS_ASSERT(isFalse([&] { return large.isInline(); }));
+        KSS_ASSERT(large() == 7);
+        InlineFunction<int()> movedLarge = move(large);
+        KSS_ASSERT(movedLarge() == 7);
+
+        InlineFunction<int(), 512> roomy = [big] { return big[63]; };
+        KSS_ASSERT(isTrue([&] { return roomy.isInline(); }));
+        KSS_ASSERT(roomy() == 7);
+    }),
+    make_pair("destruction", [] {
+        {
+            InlineFunction<void()> fn = Counted();
+            KSS_ASSERT(Counted::instances == 1);
+            InlineFunction<void()> other = move(fn);
+            KSS_ASSERT(Counted::instances == 1);
+            other = [] {};
+            KSS_ASSERT(Counted::instances == 0);
+            other = Counted();
+            KSS_ASSERT(Counted::instances == 1);
+        }
+        KSS_ASSERT(Counted::instances == 0);
+    })
+});
@@ -0,0 +1,168 @@
+//
+//  instrumented_lock.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#define KSS_THREAD_LOCK_PROFILING 1
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <kss/test/all.h>
+#include <kss/thread/instrumented_lock.hpp>
+#include <kss/thread/lock.hpp>
+#include <kss/thread/read_write_lock.hpp>
+#include <kss/thread/semaphore.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+static TestSuite ts("instrumented_lock", {
+    make_pair("InstrumentedLock<mutex>", [] {
+        InstrumentedLock<mutex> m("test.mutex");
+        m.profile().reset();
+
+        locked(m, []{});
+        {
+            lock_guard<InstrumentedLock<mutex>> l(m);
+            this_thread::sleep_for(2ms);
+        }
+        auto st = m.profile().statistics();
+        KSS_ASSERT(st.name == "test.mutex");
+        KSS_ASSERT(st.acquisitions == 2 && st.contended == 0);
+        KSS_ASSERT(st.holdTime.count() == 2 && st.holdTime.max() >= 2ms);
+
+        // Contention and failed try_lock calls.
+        atomic<bool> holding { false };
+        thread th { [&] {
+            lock_guard<InstrumentedLock<mutex>> l(m);
+            holding = true;
+            this_thread::sleep_for(20ms);
+        }};
+        while (!holding) { this_thread::yield(); }
+        bool ran = false;
+        ifLocked(m, [&] { ran = true; });
+        KSS_ASSERT(!ran);
+        locked(m, []{});
+        th.join();
+
+        st = m.profile().statistics();
+        KSS_ASSERT(st.acquisitions == 4);
+        KSS_ASSERT(st.contended == 1);
+        KSS_ASSERT(st.tryAttempts == 1 && st.tryFailures == 1);
+        KSS_ASSERT(st.tryFailureRate() == 1.0);
+        KSS_ASSERT(st.waitTime.max() >= 5ms);
+        KSS_ASSERT(st.holdTime.count() == 4);
+
+        // Locks with the same name share a profile.
+        InstrumentedLock<mutex> m2("test.mutex");
+        KSS_ASSERT(&m2.profile() == &m.profile());
+        KSS_ASSERT(throwsException<invalid_argument>([] { InstrumentedLock<mutex> bad(""); }));
+    }),
+    make_pair("wrapping other lockables", [] {
+        ReadWriteLock rw;
+        InstrumentedLock<ReadWriteLock::ReadLock&> r("test.rw.read", rw.readLock());
+        InstrumentedLock<ReadWriteLock::WriteLock&> w("test.rw.write", rw.writeLock());
+        r.profile().reset();
+        w.profile().reset();
+        KSS_ASSERT(&r.underlying() == &rw.readLock());
+
+        // Two readers at once, each with its own hold time.
+        r.lock();
+        thread th { [&] { locked(r, []{}); } };
+        th.join();
+        KSS_ASSERT(!w.try_lock_for(1ms));
+        r.unlock();
+        KSS_ASSERT(w.try_lock_for(1ms));
+        w.unlock();
+
+        auto rs = r.profile().statistics();
+        KSS_ASSERT(rs.acquisitions == 2 && rs.holdTime.count() == 2);
+        auto ws = w.profile().statistics();
+        KSS_ASSERT(ws.acquisitions == 1 && ws.tryAttempts == 2 && ws.tryFailures == 1);
+
+        // A semaphore released by another thread records no hold time.
+        InstrumentedLock<CountingSemaphore> sem("test.semaphore", 1u);
+        sem.profile().reset();
+        sem.lock();
+        thread releaser { [&] { sem.unlock(); } };
+        releaser.join();
+        KSS_ASSERT(sem.try_lock());
+        sem.unlock();
+        auto ss = sem.profile().statistics();
+        KSS_ASSERT(ss.acquisitions == 2 && ss.holdTime.count() == 1);
+    }),
+    make_pair("shared profiles", [] {
+        // Many locks sharing a profile record into it concurrently, and none of the
+        // counts may be lost.
+        constexpr int numberOfThreads = 4;
+        constexpr int iterations = 10000;
+        vector<unique_ptr<InstrumentedLock<mutex>>> locks;
+        for (int i = 0; i < numberOfThreads; ++i) {
+            locks.emplace_back(new InstrumentedLock<mutex>("test.shared"));
+        }
+        locks[0]->profile().reset();
+
+        vector<thread> threads;
+        for (int i = 0; i < numberOfThreads; ++i) {
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < iterations; ++j) {
+                    locked(*locks[size_t(i)], []{});
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+
+        const auto st = locks[0]->profile().statistics();
+        KSS_ASSERT(st.acquisitions == numberOfThreads * iterations);
+        KSS_ASSERT(st.contended == 0);
+        KSS_ASSERT(st.waitTime.count() == numberOfThreads * iterations);
+        KSS_ASSERT(st.holdTime.count() == numberOfThreads * iterations);
+    }),
+    make_pair("reports", [] {
+        LockProfile::resetAll();
+        InstrumentedLock<mutex> hot("test.report.hot");
+        InstrumentedLock<mutex> cold("test.report.cold");
+        for (int i = 0; i < 10; ++i) {
+            locked(cold, []{});
+        }
+        atomic<bool> holding { false };
+        thread th { [&] {
+            lock_guard<InstrumentedLock<mutex>> l(hot);
+            holding = true;
+            this_thread::sleep_for(5ms);
+        }};
+        while (!holding) { this_thread::yield(); }
+        locked(hot, []{});
+        th.join();
+
+        const auto top = LockProfile::mostContended(1);
+        KSS_ASSERT(top.size() == 1 && top[0].name == "test.report.hot");
+        KSS_ASSERT(LockProfile::all().size() >= 2);
+
+        ostringstream strm;
+        LockProfile::dump(strm, 100);
+        const auto report = strm.str();
+        KSS_ASSERT(report.find("test.report.hot: acquisitions=2 contended=1 (50.0%)") == 0);
+        KSS_ASSERT(report.find("test.report.cold: acquisitions=10 contended=0") != string::npos);
+
+        LockProfile::resetAll();
+        KSS_ASSERT(hot.profile().statistics().acquisitions == 0);
+        KSS_ASSERT(hot.profile().name() == "test.report.hot");
+    })
+});
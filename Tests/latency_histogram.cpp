@@ -0,0 +1,85 @@
+//
+//  latency_histogram.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+
+#include <kss/test/all.h>
+#include <kss/thread/latency_histogram.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+
+static TestSuite ts("latency_histogram", {
+    make_pair("buckets", [] {
+        KSS_ASSERT(LatencyHistogram::bucketLowerBound(0) == 0ns);
+        KSS_ASSERT(LatencyHistogram::bucketUpperBound(LatencyHistogram::numberOfBuckets - 1)
+                   == nanoseconds::max());
+        for (size_t i = 1; i < LatencyHistogram::numberOfBuckets; ++i) {
+            const auto lower = LatencyHistogram::bucketLowerBound(i);
+            KSS_ASSERT(lower == LatencyHistogram::bucketUpperBound(i - 1) + 1ns);
+            KSS_ASSERT(LatencyHistogram::bucketFor(lower) == i);
+        }
+
+        // No bucket above the first few is wider than a quarter of its lower bound.
+        for (size_t i = 4; i < LatencyHistogram::numberOfBuckets - 1; ++i) {
+            const auto width = LatencyHistogram::bucketUpperBound(i) - LatencyHistogram::bucketLowerBound(i);
+            KSS_ASSERT(width.count() * 4 < LatencyHistogram::bucketLowerBound(i).count());
+        }
+
+        KSS_ASSERT(LatencyHistogram::bucketFor(-5ns) == 0);
+        KSS_ASSERT(throwsException<invalid_argument>([] {
+            LatencyHistogram::bucketLowerBound(LatencyHistogram::numberOfBuckets);
+        }));
+        KSS_ASSERT(throwsException<out_of_range>([] {
+            LatencyHistogram().bucketCount(LatencyHistogram::numberOfBuckets);
+        }));
+    }),
+    make_pair("recording and percentiles", [] {
+        LatencyHistogram h;
+        KSS_ASSERT(h.count() == 0);
+        KSS_ASSERT(h.percentile(50) == 0ns && h.min() == 0ns && h.max() == 0ns && h.mean() == 0ns);
+
+        for (int i = 1; i <= 100; ++i) {
+            h.record(microseconds(i));
+        }
+        KSS_ASSERT(h.count() == 100);
+        KSS_ASSERT(h.min() == 1us);
+        KSS_ASSERT(h.max() == 100us);
+        KSS_ASSERT(h.mean() == nanoseconds(50500));
+        KSS_ASSERT(h.percentile(100) == 100us);
+        KSS_ASSERT(h.percentile(50) >= 50us && h.percentile(50) <= 63us);
+        KSS_ASSERT(h.percentile(99) >= 99us && h.percentile(99) <= 100us);
+        KSS_ASSERT(h.percentile(0) >= 1us && h.percentile(0) < 2us);
+        KSS_ASSERT(throwsException<invalid_argument>([&] { h.percentile(101); }));
+        KSS_ASSERT(throwsException<invalid_argument>([&] { h.percentile(-1); }));
+
+        size_t total = 0;
+        for (size_t i = 0; i < LatencyHistogram::numberOfBuckets; ++i) {
+            total += h.bucketCount(i);
+        }
+        KSS_ASSERT(total == 100);
+
+        LatencyHistogram other;
+        other.record(1s);
+        other.record(-1s);
+        h.merge(other);
+        KSS_ASSERT(h.count() == 102);
+        KSS_ASSERT(h.min() == 0ns);
+        KSS_ASSERT(h.max() == 1s);
+        KSS_ASSERT(h.bucketCount(0) == 1);
+
+        h.clear();
+        KSS_ASSERT(h.count() == 0 && h.max() == 0ns);
+    })
+});
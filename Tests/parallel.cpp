@@ -7,10 +7,15 @@
 //  Licensing follows the MIT License.
 //
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <kss/test/all.h>
 #include <kss/thread/parallel.hpp>
@@ -84,6 +89,176 @@ static TestSuite ts("parallel", {
             }
         });
         KSS_ASSERT(numRan == numIterations*3);
-        KSS_ASSERT((tpg < t) && (tpg < tSerial));
+        // Both versions reuse their threads, hence we can only require that the
+        // group is not slower than running the actions serially.
+        KSS_ASSERT(tpg < tSerial);
+    }),
+    make_pair("shared pool", [] {
+        KSS_ASSERT(parallelPoolSize() == max(std::thread::hardware_concurrency(), 1U));
+        KSS_ASSERT(throwsException<invalid_argument>([] { setParallelPoolSize(0); }));
+
+        // Threads are reused from one call to the next.
+        std::thread::id first, second;
+        parallel([]{}, [&]{ first = this_thread::get_id(); });
+        parallel([]{}, [&]{ second = this_thread::get_id(); });
+        KSS_ASSERT(first == second);
+        KSS_ASSERT(first != this_thread::get_id());
+
+        // Nested calls, and more actions than the pool size, still run all the
+        // actions at the same time.
+        const auto oldSize = parallelPoolSize();
+        setParallelPoolSize(1);
+        KSS_ASSERT(parallelPoolSize() == 1);
+        atomic<int> numArrived { 0 };
+        const auto arriveAndWait = [&] {
+            ++numArrived;
+            const auto start = steady_clock::now();
+            while (numArrived < 6 && (steady_clock::now() - start) < 5s) {
+                this_thread::sleep_for(1ms);
+            }
+        };
+        const auto t = timeOfExecution([&] {
+            parallel(arriveAndWait,
+                     [&]{ parallel(arriveAndWait, arriveAndWait); },
+                     [&]{ parallel(arriveAndWait, arriveAndWait, arriveAndWait); });
+        });
+        KSS_ASSERT(numArrived == 6);
+        KSS_ASSERT(isLessThan<long>(5000, [&] { return t.count(); }));
+        setParallelPoolSize(oldSize);
+    }),
+    make_pair("parallelFor", [] {
+        ParallelThreadGroup tg(3);
+        constexpr size_t n = 1000000;
+        vector<int> visits(n, 0);
+        parallelFor(tg, size_t(0), n, size_t(1000), [&](size_t i) { ++visits[i]; });
+        KSS_ASSERT(all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+
+        // Very uneven work, which requires stealing to balance.
+        atomic<int> numRan { 0 };
+        const auto t = timeOfExecution([&] {
+            parallelFor(tg, 0, 64, 1, [&](int i) {
+                if (i < 16) {
+                    this_thread::sleep_for(5ms);
+                }
+                ++numRan;
+            });
+        });
+        KSS_ASSERT(numRan == 64);
+        KSS_ASSERT(isLessThan<long>(60, [&] { return t.count(); }));
+
+        parallelFor(tg, 10, 10, 1, [](int) { KSS_ASSERT(false); });
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            parallelFor(tg, 0, 10, 0, [](int) {});
+        }));
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            parallelFor(tg, 0, 0, 0, [](int) {});
+        }));
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            parallelFor(tg, 0, 1000, 1, [](int i) {
+                if (i == 500) {
+                    throw runtime_error("oops");
+                }
+            });
+        }));
+
+        // The group must still be usable after an exception.
+        numRan = 0;
+        parallelFor(tg, 0, 100, 7, [&](int) { ++numRan; });
+        KSS_ASSERT(numRan == 100);
+    }),
+    make_pair("parallelReduce", [] {
+        ParallelThreadGroup tg(3);
+        constexpr int64_t n = 1000000;
+        const auto sum = parallelReduce(tg, int64_t(1), n+1, int64_t(500), int64_t(0),
+                                        [](int64_t i) { return i; },
+                                        [](int64_t a, int64_t b) { return a + b; });
+        KSS_ASSERT(sum == (n * (n+1)) / 2);
+
+        const auto maxValue = parallelReduce(tg, 0, 1000, 10, -1,
+                                             [](int i) { return (i * 7919) % 1000; },
+                                             [](int a, int b) { return max(a, b); });
+        KSS_ASSERT(maxValue == 999);
+
+        KSS_ASSERT(parallelReduce(tg, 5, 5, 1, 42, [](int i) { return i; },
+                                  [](int a, int b) { return a + b; }) == 42);
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            parallelReduce(tg, 5, 5, 0, 42, [](int i) { return i; }, [](int a, int b) { return a + b; });
+        }));
+
+        // Concatenation is associative but not commutative, so the chunks must be
+        // combined in order.
+        const auto str = parallelReduce(tg, 0, 2000, 1, string(),
+                                        [](int i) { return string(1, char('a' + i % 26)); },
+                                        [](const string& a, const string& b) { return a + b; });
+        string expected;
+        for (int i = 0; i < 2000; ++i) {
+            expected += char('a' + i % 26);
+        }
+        KSS_ASSERT(str == expected);
+    }),
+    make_pair("exceptions", [] {
+        atomic<int> numRan { 0 };
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            parallel([&]{ run(numRan); },
+                     [&]{ run(numRan); throw runtime_error("oops"); });
+        }));
+        KSS_ASSERT(numRan == 2);
+
+        ParallelThreadGroup tg(2);
+        numRan = 0;
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            parallel(tg,
+                     [&]{ run(numRan); throw runtime_error("oops"); },
+                     [&]{ run(numRan); },
+                     [&]{ run(numRan); throw logic_error("second"); });
+        }));
+        KSS_ASSERT(numRan == 3);
+        KSS_ASSERT(throwsException<logic_error>([&] {
+            parallel(tg, [&]{ run(numRan); }, [&]{ throw logic_error("oops"); });
+        }));
+
+        // The group must still be usable after an exception.
+        numRan = 0;
+        parallel(tg, [&]{ run(numRan); }, [&]{ run(numRan); });
+        KSS_ASSERT(numRan == 2);
+    }),
+    make_pair("parallelCancellable", [] {
+        // Without a failure, all the actions run to completion.
+        atomic<int> numRan { 0 };
+        parallelCancellable([&](const StopToken& st) { if (!st.stopRequested()) { run(numRan); } },
+                            [&](const StopToken& st) { if (!st.stopRequested()) { run(numRan); } });
+        KSS_ASSERT(numRan == 2);
+
+        // A failure stops the long running actions early.
+        const auto untilStopped = [&](const StopToken& st) {
+            const auto start = steady_clock::now();
+            while (!st.stopRequested() && (steady_clock::now() - start) < 10s) {
+                this_thread::sleep_for(1ms);
+            }
+            ++numRan;
+        };
+        numRan = 0;
+        auto t = timeOfExecution([&] {
+            KSS_ASSERT(throwsException<runtime_error>([&] {
+                parallelCancellable(untilStopped, untilStopped, [](const StopToken&) {
+                    this_thread::sleep_for(10ms);
+                    throw runtime_error("oops");
+                });
+            }));
+        });
+        KSS_ASSERT(numRan == 2);
+        KSS_ASSERT(isLessThan<long>(5000, [&] { return t.count(); }));
+
+        ParallelThreadGroup tg(2);
+        numRan = 0;
+        t = timeOfExecution([&] {
+            KSS_ASSERT(throwsException<runtime_error>([&] {
+                parallelCancellable(tg, [](const StopToken&) {
+                    throw runtime_error("oops");
+                }, untilStopped, untilStopped);
+            }));
+        });
+        KSS_ASSERT(numRan == 2);
+        KSS_ASSERT(isLessThan<long>(5000, [&] { return t.count(); }));
     })
 });
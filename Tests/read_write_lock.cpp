@@ -7,11 +7,14 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <new>
+#include <stdexcept>
 #include <system_error>
 #include <thread>
 
@@ -109,5 +112,106 @@ static TestSuite ts("read_write_lock", {
         t1.join();
         t2.join();
         KSS_ASSERT(hadLock1 && hadLock2);
+    }),
+    make_pair("DistributedReadWriteLock", [] {
+        KSS_ASSERT(throwsException<invalid_argument>([] { DistributedReadWriteLock l(3); }));
+
+        DistributedReadWriteLock l;
+        auto& wl = l.writeLock();
+        auto& rl = l.readLock();
+
+        // Read locks do not block each other, but do block writers.
+        rl.lock();
+        KSS_ASSERT(isFalse([&] { return wl.try_lock(); }));
+        thread t1 { [&]{
+            KSS_ASSERT(rl.try_lock());
+            rl.unlock();
+        }};
+        t1.join();
+        rl.unlock();
+
+        // A write lock blocks everyone.
+        bool hadLock1 = false;
+        bool hadLock2 = false;
+        wl.lock();
+        KSS_ASSERT(isFalse([&] { return rl.try_lock(); }));
+        thread t2 { [&]{
+            lock_guard<DistributedReadWriteLock::ReadLock> lock(rl);
+            hadLock1 = true;
+        }};
+        thread t3 { [&]{
+            lock_guard<DistributedReadWriteLock::WriteLock> lock(wl);
+            hadLock2 = true;
+        }};
+        this_thread::sleep_for(10ms);
+        KSS_ASSERT(!hadLock1 && !hadLock2);
+        wl.unlock();
+        t2.join();
+        t3.join();
+        KSS_ASSERT(hadLock1 && hadLock2);
+
+        // Readers never see a partial write.
+        int a = 0, b = 0;
+        atomic<bool> consistent { true };
+        atomic<bool> done { false };
+        const auto reader = [&] {
+            while (!done) {
+                lock_guard<DistributedReadWriteLock::ReadLock> lock(rl);
+                if (a != b) { consistent = false; }
+            }
+        };
+        thread r1 { reader };
+        thread r2 { reader };
+        for (int i = 0; i < 200; ++i) {
+            lock_guard<DistributedReadWriteLock::WriteLock> lock(wl);
+            ++a;
+            this_thread::yield();
+            ++b;
+        }
+        done = true;
+        r1.join();
+        r2.join();
+        KSS_ASSERT(consistent.load());
+        KSS_ASSERT(a == 200 && b == 200);
+    }),
+    make_pair("Timed locks", [] {
+        ReadWriteLock l;
+        auto& wl = l.writeLock();
+        auto& rl = l.readLock();
+
+        // Note that the attempts are made from other threads since a pthread read/write
+        // lock may report a deadlock if the thread holding it tries again.
+        wl.lock();
+        bool gotRead = true;
+        bool gotWrite = true;
+        chrono::milliseconds waited;
+        thread t1 { [&] {
+            const auto start = chrono::steady_clock::now();
+            gotRead = rl.try_lock_for(chrono::milliseconds(50));
+            gotWrite = wl.try_lock_until(chrono::system_clock::now() + chrono::milliseconds(50));
+            waited = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        }};
+        t1.join();
+        KSS_ASSERT(!gotRead && !gotWrite);
+        KSS_ASSERT(waited >= chrono::milliseconds(100));
+        wl.unlock();
+
+        rl.lock();
+        thread t2 { [&] {
+            unique_lock<ReadWriteLock::ReadLock> rlock(rl, chrono::milliseconds(50));
+            gotRead = rlock.owns_lock();
+            unique_lock<ReadWriteLock::WriteLock> wlock(wl, chrono::milliseconds(50));
+            gotWrite = wlock.owns_lock();
+        }};
+        t2.join();
+        KSS_ASSERT(gotRead && !gotWrite);
+        rl.unlock();
+
+        thread t3 { [&] {
+            unique_lock<ReadWriteLock::WriteLock> wlock(wl, chrono::steady_clock::now() + chrono::seconds(5));
+            gotWrite = wlock.owns_lock();
+        }};
+        t3.join();
+        KSS_ASSERT(gotWrite);
     })
 });
@@ -8,12 +8,20 @@
 //
 
 #include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <new>
+#include <stdexcept>
 #include <system_error>
 #include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <kss/test/all.h>
 #include <kss/thread/interruptible.hpp>
@@ -72,5 +80,135 @@ make_pair("is interruptible", [] {
     interrupt(th);
     th.join();
     KSS_ASSERT(wasInterrupted);
+}),
+make_pair("timed locks", [] {
+    Semaphore s("/KssThreadTestSemaphore4", 1);
+    KSS_ASSERT(s.try_lock_for(chrono::milliseconds(10)) == true);
+
+    const auto start = chrono::steady_clock::now();
+    KSS_ASSERT(s.try_lock_for(chrono::milliseconds(50)) == false);
+    KSS_ASSERT(s.try_lock_until(chrono::system_clock::now() + chrono::milliseconds(50)) == false);
+    KSS_ASSERT(chrono::steady_clock::now() - start >= chrono::milliseconds(100));
+
+    bool gotLock = false;
+    thread th { [&] {
+        gotLock = s.try_lock_for(chrono::seconds(5));
+    }};
+    this_thread::sleep_for(chrono::milliseconds(20));
+    s.unlock();
+    th.join();
+    KSS_ASSERT(gotLock);
+
+    s.unlock();
+    {
+        unique_lock<Semaphore> lock(s, chrono::milliseconds(10));
+        KSS_ASSERT(lock.owns_lock());
+        unique_lock<Semaphore> lock2(s, chrono::milliseconds(10));
+        KSS_ASSERT(!lock2.owns_lock());
+    }
+    KSS_ASSERT(s.try_lock() == true);
+    s.unlock();
+}),
+make_pair("move", [] {
+    Semaphore s1("/KssThreadTestSemaphore5", 1);
+    Semaphore s2(move(s1));
+    KSS_ASSERT(s1.nativeHandle() == SEM_FAILED);
+    KSS_ASSERT(s2.name() == "/KssThreadTestSemaphore5");
+    KSS_ASSERT(s2.try_lock() == true);
+    KSS_ASSERT(s2.try_lock() == false);
+    s2.unlock();
+}),
+make_pair("unnamed in shared memory", [] {
+    void* mem = mmap(nullptr, sizeof(sem_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    KSS_ASSERT(mem != MAP_FAILED);
+    auto* storage = static_cast<sem_t*>(mem);
+
+    KSS_ASSERT(throwsException<invalid_argument>([] { Semaphore s(nullptr, 1); }));
+    try {
+        Semaphore s(storage, 0);
+        KSS_ASSERT(s.name().empty());
+        KSS_ASSERT(s.nativeHandle() == storage);
+        KSS_ASSERT(s.try_lock() == false);
+
+        // The child process attaches to the semaphore and releases it.
+        const pid_t pid = fork();
+        if (pid == 0) {
+            Semaphore child(storage);
+            child.unlock();
+            _exit(0);
+        }
+        KSS_ASSERT(pid > 0);
+        KSS_ASSERT(s.try_lock_for(chrono::seconds(5)) == true);
+        int status = 0;
+        KSS_ASSERT(waitpid(pid, &status, 0) == pid);
+        KSS_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    catch (const system_error& e) {
+        // Some platforms (e.g. macOS) do not support unnamed semaphores.
+        KSS_ASSERT(e.code() == errc::function_not_supported);
+    }
+    munmap(mem, sizeof(sem_t));
+}),
+make_pair("CountingSemaphore", [] {
+    CountingSemaphore s(3);
+    KSS_ASSERT(s.value() == 3);
+    KSS_ASSERT(s.tryAcquire(2) == true);
+    KSS_ASSERT(s.tryAcquire(2) == false);
+    KSS_ASSERT(s.try_lock() == true);
+    KSS_ASSERT(s.try_lock() == false);
+    KSS_ASSERT(s.value() == 0);
+    s.release(3);
+    KSS_ASSERT(s.value() == 3);
+    s.acquire(3);
+    KSS_ASSERT(s.value() == 0);
+
+    const auto start = chrono::steady_clock::now();
+    KSS_ASSERT(s.tryAcquireFor(1, chrono::milliseconds(50)) == false);
+    KSS_ASSERT(s.try_lock_until(chrono::system_clock::now() + chrono::milliseconds(50)) == false);
+    KSS_ASSERT(chrono::steady_clock::now() - start >= chrono::milliseconds(100));
+
+    // A request for more than one unit waits until they are all available.
+    bool gotThem = false;
+    thread th { [&] {
+        gotThem = s.tryAcquireFor(2, chrono::seconds(5));
+    }};
+    s.release();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    KSS_ASSERT(!gotThem);
+    s.release();
+    th.join();
+    KSS_ASSERT(gotThem);
+    KSS_ASSERT(s.value() == 0);
+
+    s.release();
+    {
+        unique_lock<CountingSemaphore> lock(s, chrono::milliseconds(10));
+        KSS_ASSERT(lock.owns_lock());
+        KSS_ASSERT(s.value() == 0);
+    }
+    KSS_ASSERT(s.value() == 1);
+}),
+make_pair("CountingSemaphore limits concurrency", [] {
+    CountingSemaphore s(2);
+    atomic<int> active { 0 };
+    atomic<int> maxActive { 0 };
+    vector<thread> threads;
+    for (int i = 0; i < 6; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 50; ++j) {
+                lock_guard<CountingSemaphore> l(s);
+                const int a = ++active;
+                int m = maxActive.load();
+                while (a > m && !maxActive.compare_exchange_weak(m, a)) {}
+                this_thread::yield();
+                --active;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    KSS_ASSERT(maxActive.load() >= 1 && maxActive.load() <= 2);
+    KSS_ASSERT(s.value() == 2);
 })
 });
@@ -0,0 +1,71 @@
+//
+//  seq_lock.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <kss/test/all.h>
+#include <kss/thread/seq_lock.hpp>
+
+using namespace std;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    struct Record {
+        uint64_t    a = 0;
+        uint64_t    b = 0;
+        char        name[13] = "initial";
+    };
+}
+
+
+static TestSuite ts("seq_lock", {
+    make_pair("basic usage", [] {
+        SeqLock<int> i;
+        KSS_ASSERT(i.load() == 0);
+        i.store(10);
+        KSS_ASSERT(i.load() == 10);
+        i.update([](int& v) { v *= 2; });
+        KSS_ASSERT(i.load() == 20);
+
+        SeqLock<Record> r;
+        KSS_ASSERT(string(r.load().name) == "initial");
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            r.update([](Record& rec) { rec.a = 99; throw runtime_error("oops"); });
+        }));
+        KSS_ASSERT(r.load().a == 0);
+    }),
+    make_pair("readers see consistent values", [] {
+        SeqLock<Record> r;
+        atomic<bool> done { false };
+        atomic<bool> consistent { true };
+        const auto reader = [&] {
+            while (!done) {
+                const auto rec = r.load();
+                if (rec.a != rec.b) {
+                    consistent = false;
+                }
+            }
+        };
+        thread t1 { reader };
+        thread t2 { reader };
+        for (uint64_t i = 1; i <= 10000; ++i) {
+            r.update([i](Record& rec) { rec.a = i; rec.b = i; });
+        }
+        done = true;
+        t1.join();
+        t2.join();
+        KSS_ASSERT(consistent.load());
+        KSS_ASSERT(r.load().b == 10000);
+    })
+});
@@ -7,10 +7,13 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
 #include <csignal>
+#include <stdexcept>
 #include <thread>
 
 #include <kss/test/all.h>
+#include <kss/thread/action_queue.hpp>
 #include <kss/thread/signal.hpp>
 
 using namespace std;
@@ -43,4 +46,39 @@ static TestSuite t("signal", {
         th2.join();
         KSS_ASSERT(true);   // Nothing to test except that we complete without error.
     }),
+    make_pair("Dispatcher", [] {
+        ActionQueue queue;
+        atomic<int> usr1 { 0 };
+        atomic<int> usr2 { 0 };
+        thread::id queueThread;
+        queue.addAction([&] { queueThread = this_thread::get_id(); });
+        queue.wait();
+        {
+            // The handlers are run as actions on the queue.
+            signal::Dispatcher dispatcher(queue, { SIGUSR1, SIGUSR2 }, [&](int sig) {
+                KSS_ASSERT(this_thread::get_id() == queueThread);
+                if (sig == SIGUSR1) { ++usr1; } else if (sig == SIGUSR2) { ++usr2; }
+            });
+
+            dispatcher.send(SIGUSR1);
+            KSS_ASSERT(isTrue([&] {
+                while (usr1 == 0) { this_thread::sleep_for(1ms); }
+                return true;
+            }));
+            dispatcher.send(SIGUSR2);
+            KSS_ASSERT(isTrue([&] {
+                while (usr2 == 0) { this_thread::sleep_for(1ms); }
+                return true;
+            }));
+        }
+        queue.wait();
+        KSS_ASSERT(usr1 == 1 && usr2 == 1);
+
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            signal::Dispatcher d(queue, { SIGKILL }, [](int) {});
+        }));
+        KSS_ASSERT(throwsException<invalid_argument>([&] {
+            signal::Dispatcher d(queue, { SIGUSR1 }, nullptr);
+        }));
+    }),
 });
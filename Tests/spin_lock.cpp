@@ -0,0 +1,158 @@
+//
+//  spin_lock.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <kss/test/all.h>
+#include <kss/thread/action_thread.hpp>
+#include <kss/thread/channel.hpp>
+#include <kss/thread/lock.hpp>
+#include <kss/thread/spin_lock.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    // Returns true if a number of threads incrementing a counter under the lock
+    // produce the expected total, and are never inside the lock together.
+    template <class Lockable>
+    bool mutuallyExclusive() {
+        Lockable l;
+        unsigned value = 0;
+        atomic<unsigned> inside { 0 };
+        atomic<bool> overlapped { false };
+        vector<thread> threads;
+        for (unsigned i = 0; i < 4; ++i) {
+            threads.emplace_back([&] {
+                for (unsigned j = 0; j < 10000; ++j) {
+                    locked(l, [&] {
+                        if (++inside > 1) { overlapped = true; }
+                        ++value;
+                        --inside;
+                    });
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        return (value == 40000 && !overlapped);
+    }
+
+    template <class Lockable>
+    bool tryLockWorks() {
+        Lockable l;
+        if (!l.try_lock()) { return false; }
+        bool obtained = true;
+        thread th { [&] { obtained = l.try_lock(); } };
+        th.join();
+        l.unlock();
+        if (obtained) { return false; }
+
+        bool ran = false;
+        ifLocked(l, [&] { ran = true; });
+        return ran;
+    }
+}
+
+static TestSuite ts("spin_lock", {
+    make_pair("AdaptiveMutex", [] {
+        KSS_ASSERT(mutuallyExclusive<AdaptiveMutex>());
+        KSS_ASSERT(tryLockWorks<AdaptiveMutex>());
+
+        AdaptiveMutex m;
+        m.lock();
+        bool timedOut = true;
+        thread th { [&] {
+            timedOut = !m.try_lock_for(10ms);
+        }};
+        th.join();
+        KSS_ASSERT(timedOut);
+        thread th2 { [&] {
+            timedOut = !m.try_lock_until(steady_clock::now() + 5s);
+            if (!timedOut) { m.unlock(); }
+        }};
+        this_thread::sleep_for(5ms);
+        m.unlock();
+        th2.join();
+        KSS_ASSERT(!timedOut);
+    }),
+    make_pair("TicketLock", [] {
+        KSS_ASSERT(mutuallyExclusive<TicketLock>());
+        KSS_ASSERT(tryLockWorks<TicketLock>());
+
+        // Waiters obtain the lock in the order they asked for it.
+        TicketLock l;
+        vector<int> order;
+        l.lock();
+        vector<thread> threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.emplace_back([&, i] { lock_guard<TicketLock> g(l); order.push_back(i); });
+            this_thread::sleep_for(5ms);
+        }
+        l.unlock();
+        for (auto& th : threads) {
+            th.join();
+        }
+        KSS_ASSERT(order == vector<int>({ 0, 1, 2 }));
+    }),
+    make_pair("McsLock", [] {
+        KSS_ASSERT(mutuallyExclusive<McsLock>());
+        KSS_ASSERT(tryLockWorks<McsLock>());
+
+        // A thread may hold several McsLocks at once, released in any order.
+        McsLock a, b, c;
+        a.lock();
+        b.lock();
+        c.lock();
+        b.unlock();
+        a.unlock();
+        KSS_ASSERT(a.try_lock());
+        c.unlock();
+        a.unlock();
+
+        vector<int> order;
+        a.lock();
+        vector<thread> threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.emplace_back([&, i] { lock_guard<McsLock> g(a); order.push_back(i); });
+            this_thread::sleep_for(5ms);
+        }
+        a.unlock();
+        for (auto& th : threads) {
+            th.join();
+        }
+        KSS_ASSERT(order == vector<int>({ 0, 1, 2 }));
+    }),
+    make_pair("as the lock of other primitives", [] {
+        Channel<int, AdaptiveMutex> ch(2);
+        thread producer { [&] {
+            for (int i = 0; i < 100; ++i) { ch.push(i); }
+            ch.close();
+        }};
+        int sum = 0;
+        int i = 0;
+        while (ch.pop(i)) {
+            sum += i;
+        }
+        producer.join();
+        KSS_ASSERT(sum == 4950);
+
+        ActionThread<int, TicketLock> th;
+        th.run([] { return 3; });
+        KSS_ASSERT(th.get() == 3);
+        KSS_ASSERT(th.async([] { return 4; }).get() == 4);
+    })
+});
@@ -0,0 +1,148 @@
+//
+//  stop_token.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include <kss/test/all.h>
+#include <kss/thread/action_queue.hpp>
+#include <kss/thread/channel.hpp>
+#include <kss/thread/interruptible.hpp>
+#include <kss/thread/stop_token.hpp>
+#include <kss/thread/synchronizer.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    // Run fn in a stoppable section on another thread, request the stop once it has
+    // started, and return true if the section was left because of the stop.
+    bool stopsWhileBlocked(const function<void()>& fn) {
+        StopSource source;
+        atomic<bool> started { false };
+        atomic<bool> finished { false };
+        std::thread th { [&] {
+            stoppable { source.token(), [&] {
+                started = true;
+                fn();
+                finished = true;
+            }};
+        }};
+        while (!started) { this_thread::yield(); }
+        this_thread::sleep_for(10ms);
+        source.requestStop();
+        th.join();
+        return !finished;
+    }
+}
+
+static TestSuite ts("stop_token", {
+    make_pair("basic usage", [] {
+        StopToken unassociated;
+        KSS_ASSERT(isFalse([&] { return unassociated.stopPossible(); }));
+        KSS_ASSERT(isFalse([&] { return unassociated.stopRequested(); }));
+
+        StopSource source;
+        const auto token = source.token();
+        KSS_ASSERT(isTrue([&] { return token.stopPossible(); }));
+        KSS_ASSERT(isFalse([&] { return token.stopRequested(); }));
+        KSS_ASSERT(isTrue([&] { return source.requestStop(); }));
+        KSS_ASSERT(isFalse([&] { return source.requestStop(); }));
+        KSS_ASSERT(isTrue([&] { return token.stopRequested(); }));
+        KSS_ASSERT(isTrue([&] { return source.stopRequested(); }));
+    }),
+    make_pair("across threads", [] {
+        StopSource source;
+        atomic<bool> sawStop { false };
+        std::thread th([&sawStop, token = source.token()] {
+            while (!token.stopRequested()) {
+                this_thread::yield();
+            }
+            sawStop = true;
+        });
+        source.requestStop();
+        th.join();
+        KSS_ASSERT(sawStop.load());
+    }),
+    make_pair("StopCallback", [] {
+        StopSource source;
+        int calls = 0;
+        {
+            StopCallback removed(source.token(), [&] { ++calls; });
+        }
+        StopCallback cb1(source.token(), [&] { ++calls; });
+        StopCallback cb2(source.token(), [&] { calls += 10; });
+        KSS_ASSERT(calls == 0);
+        source.requestStop();
+        KSS_ASSERT(calls == 11);
+        source.requestStop();
+        KSS_ASSERT(calls == 11);
+
+        // Registering after the stop runs the function immediately.
+        StopCallback late(source.token(), [&] { calls += 100; });
+        KSS_ASSERT(calls == 111);
+
+        // A token without a source never runs the function.
+        StopCallback never(StopToken(), [&] { calls = 0; });
+        KSS_ASSERT(calls == 111);
+    }),
+    make_pair("stoppable", [] {
+        StopSource source;
+        bool reachedEnd = false;
+        stoppable { source.token(), [&] {
+            interruptionPoint();
+            source.requestStop();
+            interruptionPoint();
+            reachedEnd = true;
+        }};
+        KSS_ASSERT(!reachedEnd);
+        KSS_ASSERT(throwsException<runtime_error>([] {
+            stoppable { StopToken(), [] { throw runtime_error("not a stop"); }};
+        }));
+
+        // Outside of the section the token no longer applies.
+        interruptionPoint();
+    }),
+    make_pair("stop wakes blocked waits", [] {
+        KSS_ASSERT(stopsWhileBlocked([] {
+            Latch latch;
+            latch.wait();
+        }));
+
+        Barrier barrier(2);
+        KSS_ASSERT(stopsWhileBlocked([&] { barrier.wait(); }));
+        // The stopped thread withdrew, so another still has to wait for a partner.
+        atomic<bool> passed { false };
+        std::thread other { [&] { barrier.wait(); passed = true; } };
+        this_thread::sleep_for(10ms);
+        KSS_ASSERT(!passed);
+        barrier.wait();
+        other.join();
+        KSS_ASSERT(passed);
+
+        ActionQueue q;
+        Latch release;
+        q.addAction([&] { release.wait(); });
+        KSS_ASSERT(stopsWhileBlocked([&] { q.wait(); }));
+        q.addAction([]{});
+        release.release();
+        q.wait();
+
+        Channel<int> ch(4);
+        KSS_ASSERT(stopsWhileBlocked([&] { int i = 0; ch.pop(i); }));
+        for (int i = 0; i < 4; ++i) { ch.push(i); }
+        KSS_ASSERT(stopsWhileBlocked([&] { ch.push(4); }));
+        KSS_ASSERT(ch.size() == 4);
+    })
+});
@@ -7,9 +7,13 @@
 //  Licensing follows the MIT License.
 //
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <stdexcept>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <kss/test/all.h>
 #include <kss/thread/interruptible.hpp>
@@ -186,5 +190,122 @@ static TestSuite ts("synchronizer", {
             th.join();
             return wasInterrupted;
         }));
+    }),
+    make_pair("SpinLatch", [] {
+        SpinLatch l;
+        atomic<int> numPassed { 0 };
+        {
+            // Test that the latch will block threads.
+            thread t1 { [&]{ l.wait(); ++numPassed; }};
+            thread t2 { [&]{ l.wait(); ++numPassed; }};
+            KSS_ASSERT(l.waitFor(1ms) == false);
+            KSS_ASSERT(l.waitUntil(chrono::system_clock::now()) == false);
+            KSS_ASSERT(numPassed == 0);
+
+            l.release();
+            t1.join();
+            t2.join();
+            KSS_ASSERT(numPassed == 2);
+            KSS_ASSERT(l.waitFor(100s) == true);
+            KSS_ASSERT(l.waitUntil(chrono::steady_clock::now() + 100s) == true);
+        }
+        {
+            // Test that a latch can be reset, and that timed waits are released.
+            l.reset();
+            bool released = false;
+            thread th { [&]{ released = l.waitFor(10s); }};
+            this_thread::sleep_for(10ms);
+            l.release();
+            th.join();
+            KSS_ASSERT(released);
+        }
+    }),
+    make_pair("SpinBarrier", [] {
+        KSS_ASSERT(throwsException<invalid_argument>([] { SpinBarrier b(0); }));
+
+        // The barrier is reused for many phases without a reset. No thread may start
+        // phase i+1 before all of them have finished phase i.
+        constexpr unsigned numThreads = 4;
+        constexpr unsigned numPhases = 2000;
+        SpinBarrier b(numThreads);
+        atomic<unsigned> arrivals { 0 };
+        atomic<bool> inOrder { true };
+        const auto worker = [&] {
+            for (unsigned phase = 0; phase < numPhases; ++phase) {
+                ++arrivals;
+                b.wait();
+                if (arrivals < (phase + 1) * numThreads) {
+                    inOrder = false;
+                }
+                b.wait();
+            }
+        };
+        thread t1 { worker };
+        thread t2 { worker };
+        thread t3 { worker };
+        worker();
+        t1.join();
+        t2.join();
+        t3.join();
+        KSS_ASSERT(inOrder.load());
+        KSS_ASSERT(arrivals == numThreads * numPhases);
+
+        // A timed out thread withdraws from the phase.
+        SpinBarrier b2(2);
+        KSS_ASSERT(b2.waitFor(1ms) == false);
+        KSS_ASSERT(b2.waitUntil(chrono::steady_clock::now()) == false);
+        bool completed = false;
+        thread th { [&]{ completed = b2.waitFor(10s); }};
+        b2.wait();
+        th.join();
+        KSS_ASSERT(completed);
+    }),
+    make_pair("CyclicBarrier", [] {
+        // An iterative computation where each phase reads the previous phase's output.
+        constexpr unsigned numThreads = 3;
+        constexpr unsigned numPhases = 1000;
+        vector<unsigned> in(numThreads, 0), out(numThreads, 0);
+        unsigned numCompletions = 0;
+        bool consistent = true;
+        CyclicBarrier b(numThreads, [&] {
+            for (auto v : out) {
+                if (v != numCompletions + 1) { consistent = false; }
+            }
+            swap(in, out);
+            ++numCompletions;
+        });
+        KSS_ASSERT(b.phase() == 0);
+
+        const auto worker = [&](unsigned i) {
+            for (unsigned phase = 0; phase < numPhases; ++phase) {
+                out[i] = in[(i + 1) % numThreads] + 1;
+                b.wait();
+            }
+        };
+        thread t1 { [&]{ worker(1); }};
+        thread t2 { [&]{ worker(2); }};
+        worker(0);
+        t1.join();
+        t2.join();
+        KSS_ASSERT(numCompletions == numPhases);
+        KSS_ASSERT(b.phase() == numPhases);
+        KSS_ASSERT(consistent);
+
+        // An exception from the completion function is thrown by the thread that ran it,
+        // but the other threads are still released and the barrier remains usable.
+        bool shouldThrow = true;
+        CyclicBarrier b2(2, [&] { if (shouldThrow) { throw runtime_error("oops"); } });
+        thread th { [&]{
+            try { b2.wait(); } catch (const runtime_error&) {}
+        }};
+        try { b2.wait(); } catch (const runtime_error&) {}
+        th.join();
+        KSS_ASSERT(b2.phase() == 1);
+        shouldThrow = false;
+        KSS_ASSERT(b2.waitFor(1ms) == false);
+        thread th2 { [&]{ b2.wait(); }};
+        KSS_ASSERT(b2.waitFor(10s) == true);
+        th2.join();
+        KSS_ASSERT(b2.phase() == 2);
     })
 });
@@ -0,0 +1,111 @@
+//
+//  thread_attributes.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <kss/test/all.h>
+#include <kss/thread/action_queue.hpp>
+#include <kss/thread/parallel.hpp>
+#include <kss/thread/thread_attributes.hpp>
+
+using namespace std;
+using namespace std::chrono;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+#if defined(__linux)
+    string currentName() {
+        char buf[16] = {};
+        pthread_getname_np(pthread_self(), buf, sizeof(buf));
+        return buf;
+    }
+
+    bool currentlyOnlyOnCpu0() {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        return (CPU_COUNT(&cpuset) == 1 && CPU_ISSET(0, &cpuset));
+    }
+#endif
+}
+
+
+static TestSuite ts("thread_attributes", {
+    make_pair("apply", [] {
+        ThreadAttributes attrs;
+        KSS_ASSERT(isTrue([&] { return attrs.empty(); }));
+
+        std::thread notRunning;
+        KSS_ASSERT(throwsException<invalid_argument>([&] { attrs.apply(notRunning); }));
+
+#if defined(__linux)
+        attrs.name = "a-rather-long-thread-name";
+        attrs.cpus = { 0 };
+        KSS_ASSERT(isFalse([&] { return attrs.empty(); }));
+
+        promise<void> applied;
+        string name;
+        bool onCpu0 = false;
+        std::thread th([&] {
+            applied.get_future().wait();
+            name = currentName();
+            onCpu0 = currentlyOnlyOnCpu0();
+        });
+        attrs.apply(th);
+        applied.set_value();
+        th.join();
+        KSS_ASSERT(name == "a-rather-long-t");
+        KSS_ASSERT(onCpu0);
+
+        ThreadAttributes badNode;
+        badNode.numaNode = 100000;
+        std::thread th2([] { this_thread::sleep_for(10ms); });
+        KSS_ASSERT(throwsException<invalid_argument>([&] { badNode.apply(th2); }));
+        th2.join();
+#endif
+    }),
+    make_pair("threads of the library", [] {
+#if defined(__linux)
+        ThreadAttributes attrs;
+        attrs.name = "kss-test";
+        if (ifstream("/sys/devices/system/node/node0/cpulist")) {
+            attrs.numaNode = 0;
+        }
+        attrs.policy = ThreadAttributes::SchedulingPolicy::other;
+
+        ActionThread<string> at(attrs);
+        at.run([] { return currentName(); });
+        KSS_ASSERT(at.get() == "kss-test");
+
+        ParallelThreadGroup tg(2, attrs);
+        string n1, n2;
+        parallel(tg, []{}, [&]{ n1 = currentName(); }, [&]{ n2 = currentName(); });
+        KSS_ASSERT(n1 == "kss-test" && n2 == "kss-test");
+
+        attrs.name = "kss-queue";
+        ActionQueue queue(ActionQueue::noLimit, ActionQueue::Storage::ordered,
+                          ActionQueue::Dispatch::single, attrs);
+        promise<string> queueName;
+        queue.addAction([&] { queueName.set_value(currentName()); });
+        KSS_ASSERT(queueName.get_future().get() == "kss-queue");
+
+        attrs.cpus = { CPU_SETSIZE };
+        KSS_ASSERT(throwsException<invalid_argument>([&] { ActionThread<void> bad(attrs); }));
+#endif
+    })
+});
@@ -0,0 +1,103 @@
+//
+//  versioned.cpp
+//  unittest
+//
+//  Created by Steven W. Klassen on 2026-10-14.
+//  Copyright © 2026 Klassen Software Solutions. All rights reserved.
+//  Licensing follows the MIT License.
+//
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <kss/test/all.h>
+#include <kss/thread/versioned.hpp>
+
+using namespace std;
+using namespace kss::thread;
+using namespace kss::test;
+
+namespace {
+    struct Counted {
+        static atomic<int> instances;
+        int value = 0;
+        Counted() { ++instances; }
+        explicit Counted(int v) : value(v) { ++instances; }
+        Counted(const Counted& c) : value(c.value) { ++instances; }
+        ~Counted() { --instances; }
+    };
+    atomic<int> Counted::instances { 0 };
+}
+
+
+static TestSuite ts("versioned", {
+    make_pair("basic usage", [] {
+        Versioned<map<string, int>> table;
+        KSS_ASSERT(table.snapshot()->empty());
+        table.update([](map<string, int>& m) { m["one"] = 1; });
+        table.update([](map<string, int>& m) { m["two"] = 2; });
+        KSS_ASSERT(table.load().size() == 2);
+        {
+            auto snap = table.snapshot();
+            KSS_ASSERT(snap->at("two") == 2);
+        }
+        KSS_ASSERT(throwsException<runtime_error>([&] {
+            table.update([](map<string, int>& m) { m.clear(); throw runtime_error("oops"); });
+        }));
+        KSS_ASSERT(table.load().size() == 2);
+    }),
+    make_pair("reclamation", [] {
+        {
+            Versioned<Counted> v(Counted(1));
+            KSS_ASSERT(Counted::instances == 1);
+            v.store(Counted(2));
+            v.store(Counted(3));
+            KSS_ASSERT(Counted::instances == 1);
+
+            // A snapshot keeps its version, and those after it, alive.
+            {
+                auto snap = v.snapshot();
+                v.store(Counted(4));
+                v.update([](Counted& c) { ++c.value; });
+                KSS_ASSERT(snap->value == 3);
+                KSS_ASSERT(v.load().value == 5);
+                KSS_ASSERT(Counted::instances > 1);
+
+                // Nested snapshots in the same thread.
+                auto inner = v.snapshot();
+                KSS_ASSERT(inner->value == 5);
+            }
+            v.reclaim();
+            KSS_ASSERT(Counted::instances == 1);
+        }
+        KSS_ASSERT(Counted::instances == 0);
+    }),
+    make_pair("concurrent readers", [] {
+        Versioned<pair<int, int>> v(make_pair(0, 0));
+        atomic<bool> done { false };
+        atomic<bool> consistent { true };
+        const auto reader = [&] {
+            while (!done) {
+                auto snap = v.snapshot();
+                const auto first = snap->first;
+                this_thread::yield();
+                if (first != snap->second) {
+                    consistent = false;
+                }
+            }
+        };
+        thread t1 { reader };
+        thread t2 { reader };
+        for (int i = 1; i <= 5000; ++i) {
+            v.update([i](pair<int, int>& p) { p.first = i; p.second = i; });
+        }
+        done = true;
+        t1.join();
+        t2.join();
+        KSS_ASSERT(consistent.load());
+        KSS_ASSERT(v.load().second == 5000);
+    })
+});